@@ -4,6 +4,9 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include "../NetCDF/include/netcdfcpp.h"
 
 #include "../NetCDF.Tool/NetCDFinfo.h"
@@ -15,6 +18,134 @@
 #define CODE_ERROR -3
 #define DIM_ERROR  -4
 
+//! same type test (i.e. data written or read without conversion)
+template<typename A,typename B> struct NcSameType {static bool value() {return false;}};
+template<typename A> struct NcSameType<A,A> {static bool value() {return true;}};
+
+//! write \c n values of memory type \c Tmem at \c start of a 1D variable of disk type \c Tdisk
+/**
+ * values are written as they are if both types are the same (i.e. no copy),
+ * otherwise they are converted chunk by chunk in one pass (i.e. vectorized cast, only a chunk is allocated in disk type).
+ * \see NcPut
+ **/
+template<typename Tdisk,typename Tmem> NcBool NcPutAs(NcVar *v,const Tmem *x,long start,long n,const long chunk=65536)
+{
+  if(n<1) return true;
+  if(NcSameType<Tdisk,Tmem>::value())
+  {//zero copy
+    if(!v->set_cur(start)) return false;
+    return v->put((const Tdisk*)x,n);
+  }
+  std::vector<Tdisk> buffer(std::min(n,chunk));
+  for(long s=0;s<n;s+=chunk)
+  {
+    const long m=std::min(chunk,n-s);
+    Tdisk *q=&buffer[0];
+    const Tmem *p=x+s;
+    for(long i=0;i<m;++i) q[i]=(Tdisk)p[i];
+    if(!v->set_cur(start+s)) return false;
+    if(!v->put(q,m)) return false;
+  }
+  return true;
+}
+//! read a whole variable of disk type \c Tdisk as memory type \c Tmem (i.e. no copy if same type, see \c NcPutAs )
+template<typename Tdisk,typename Tmem> NcBool NcGetAs(NcVar *v,Tmem *x)
+{
+  const long n=v->num_vals();
+  if(n<1) return true;
+  long *edges=v->edges();
+  long corner[MAX_NC_DIMS]={0};
+  v->set_cur(corner);
+  NcBool ok;
+  if(NcSameType<Tdisk,Tmem>::value()) ok=v->get((Tdisk*)x,edges);
+  else
+  {
+    std::vector<Tdisk> buffer(n);
+    ok=v->get(&buffer[0],edges);
+    if(ok) {const Tdisk *p=&buffer[0];for(long i=0;i<n;++i) x[i]=(Tmem)p[i];}
+  }
+  delete[] edges;
+  return ok;
+}
+//! write \c n values of any memory type at \c start of a 1D variable (i.e. converted to the variable type, see \c NcPutAs )
+template<typename Tmem> NcBool NcPut(NcVar *v,const Tmem *x,long start,long n)
+{
+  switch(v->type())
+  {
+  case ncByte:  return NcPutAs<ncbyte>(v,x,start,n);
+  case ncChar:  return NcPutAs<char>(v,x,start,n);
+  case ncShort: return NcPutAs<short>(v,x,start,n);
+  case ncInt:   return NcPutAs<int>(v,x,start,n);
+  case ncFloat: return NcPutAs<float>(v,x,start,n);
+  case ncDouble:return NcPutAs<double>(v,x,start,n);
+  default: return false;
+  }
+}
+//! read a whole variable as any memory type (i.e. converted from the variable type, see \c NcGetAs )
+template<typename Tmem> NcBool NcGet(NcVar *v,Tmem *x)
+{
+  switch(v->type())
+  {
+  case ncByte:  return NcGetAs<ncbyte>(v,x);
+  case ncChar:  return NcGetAs<char>(v,x);
+  case ncShort: return NcGetAs<short>(v,x);
+  case ncInt:   return NcGetAs<int>(v,x);
+  case ncFloat: return NcGetAs<float>(v,x);
+  case ncDouble:return NcGetAs<double>(v,x);
+  default: return false;
+  }
+}
+
+//! read a strided hyperslab of a 1D variable in disk type (i.e. C interface, as C++ interface has no stride)
+inline int NcGetVars(int ncid,int varid,const size_t *start,const size_t *count,const ptrdiff_t *stride,ncbyte *x) {return nc_get_vars_uchar(ncid,varid,start,count,stride,x);}
+inline int NcGetVars(int ncid,int varid,const size_t *start,const size_t *count,const ptrdiff_t *stride,char *x)   {return nc_get_vars_text(ncid,varid,start,count,stride,x);}
+inline int NcGetVars(int ncid,int varid,const size_t *start,const size_t *count,const ptrdiff_t *stride,short *x)  {return nc_get_vars_short(ncid,varid,start,count,stride,x);}
+inline int NcGetVars(int ncid,int varid,const size_t *start,const size_t *count,const ptrdiff_t *stride,int *x)    {return nc_get_vars_int(ncid,varid,start,count,stride,x);}
+inline int NcGetVars(int ncid,int varid,const size_t *start,const size_t *count,const ptrdiff_t *stride,float *x)  {return nc_get_vars_float(ncid,varid,start,count,stride,x);}
+inline int NcGetVars(int ncid,int varid,const size_t *start,const size_t *count,const ptrdiff_t *stride,double *x) {return nc_get_vars_double(ncid,varid,start,count,stride,x);}
+
+//! read \c count values every \c stride from \c start of a 1D variable of disk type \c Tdisk as memory type \c Tmem
+/**
+ * hyperslab read (i.e. only the requested samples are read from file), values are read as they are if both types are the same (i.e. no copy),
+ * otherwise they are converted chunk by chunk in one pass (i.e. only a chunk is allocated in disk type).
+ * \see NcGetBlock
+ **/
+template<typename Tdisk,typename Tmem> NcBool NcGetBlockAs(int ncid,NcVar *v,Tmem *x,long start,long count,long stride=1,const long chunk=65536)
+{
+  if(count<1) return true;
+  std::vector<Tdisk> buffer;
+  if(!NcSameType<Tdisk,Tmem>::value()) buffer.resize(std::min(count,chunk));
+  for(long s=0;s<count;s+=chunk)
+  {
+    const size_t st=start+s*stride,cn=std::min(chunk,count-s);
+    const ptrdiff_t sd=stride;
+    if(NcSameType<Tdisk,Tmem>::value())
+    {//zero copy
+      if(NcGetVars(ncid,v->id(),&st,&cn,&sd,(Tdisk*)(x+s))!=NC_NOERR) return false;
+      continue;
+    }
+    Tdisk *p=&buffer[0];
+    if(NcGetVars(ncid,v->id(),&st,&cn,&sd,p)!=NC_NOERR) return false;
+    Tmem *q=x+s;
+    for(size_t i=0;i<cn;++i) q[i]=(Tmem)p[i];
+  }
+  return true;
+}
+//! read \c count values every \c stride from \c start of a 1D variable as any memory type (i.e. converted from the variable type, see \c NcGetBlockAs )
+template<typename Tmem> NcBool NcGetBlock(int ncid,NcVar *v,Tmem *x,long start,long count,long stride=1)
+{
+  switch(v->type())
+  {
+  case ncByte:  return NcGetBlockAs<ncbyte>(ncid,v,x,start,count,stride);
+  case ncChar:  return NcGetBlockAs<char>(ncid,v,x,start,count,stride);
+  case ncShort: return NcGetBlockAs<short>(ncid,v,x,start,count,stride);
+  case ncInt:   return NcGetBlockAs<int>(ncid,v,x,start,count,stride);
+  case ncFloat: return NcGetBlockAs<float>(ncid,v,x,start,count,stride);
+  case ncDouble:return NcGetBlockAs<double>(ncid,v,x,start,count,stride);
+  default: return false;
+  }
+}
+
 //! add NetCDF read/write support to CImg class
 /**
  * an object of this class may be created or CImg may derived from this class to handle NetCDF
@@ -67,6 +198,12 @@ template<typename T> class CImgNetCDF
    *
    **/
   NcFile *pNCFile;bool pNCFile_init_here;
+  //! fast create mode (i.e. file created by \c saveNetCDFFile without fill values, see \c endNetCDFDefine )
+  bool fast_create;
+  //! free bytes reserved in header when leaving define mode by \c endNetCDFDefine (i.e. \c h_minfree of \c nc__enddef ; 0: none)
+  size_t header_slack;
+  //! format of file created by \c saveNetCDFFile (i.e. \c NcFile::Offset64Bits for files over 2 GiB)
+  NcFile::FileFormat file_format;
   //! pointers to NetCDF dimensions
   /**
    * 
@@ -198,6 +335,7 @@ template<typename T> class CImgNetCDF
 #endif
       pNCError=new NcError(NcError::verbose_nonfatal);
       pNCFile=NULL;pNCFile_init_here=false;
+      fast_create=false;header_slack=0;file_format=NcFile::Classic;
       /*vpNCDimv=NULL;*/vpNCDim_init_here=false;
       pNCDimt=NULL;
       pNCvar=NULL;
@@ -260,8 +398,9 @@ template<typename T> class CImgNetCDF
     //  std::cerr << ((dimi_name==NULL)?"default":dimi_name) << "," << ((dimj_name==NULL)?"default":dimj_name) << ",";
     std::cerr << ((pTime_name==NULL)?"":*pTime_name) << ")" << std::endl;
 #endif
-    pNCFile=new NcFile(fileName,NcFile::Replace);// Write
+    pNCFile=new NcFile(fileName,NcFile::Replace,NULL,0,file_format);// Write
     pNCFile_init_here=true;
+    if(fast_create&&pNCFile->is_valid()&&!pNCFile->set_fill(NcFile::NoFill)) return NC_ERROR;
     if( (pDim_names!=NULL) && (pTime_name!=NULL)) return addNetCDFDims(*pDim_names,*pTime_name);
     else return 0;
   }
@@ -272,8 +411,9 @@ template<typename T> class CImgNetCDF
     //  std::cerr << ((dimi_name==NULL)?"default":dimi_name) << "," << ((dimj_name==NULL)?"default":dimj_name) << ",";
     std::cerr << ((pTime_name==NULL)?"":*pTime_name) << ")" << std::endl;
 #endif
-    pNCFile=new NcFile(fileName,fmod);//Replace Write
+    pNCFile=new NcFile(fileName,fmod,NULL,0,file_format);//Replace Write
     pNCFile_init_here=true;
+    if(fast_create&&pNCFile->is_valid()&&!pNCFile->set_fill(NcFile::NoFill)) return NC_ERROR;
     if( (pDim_names!=NULL) && (pTime_name!=NULL)) return addNetCDFDims(*pDim_names,*pTime_name);
     else return 0;
   }
@@ -316,6 +456,58 @@ template<typename T> class CImgNetCDF
     return pNCFile;
   }
   
+  //! leave define mode for fast writing (i.e. reserved header space and preallocated data section)
+  /**
+   * header keeps \c header_slack free bytes, so that attributes added or grown later (e.g. statistics at close) do not move the data section;
+   * data section of all variables in file is preallocated on disk (i.e. \c fallocate without changing file size),
+   * so that data is written without block allocation nor fragmentation.
+   * \note may be called instead of \c NcFile::data_mode ; with \c fast_create , variables are not filled (i.e. samples not written read as 0).
+   * \note file descriptor is the NetCDF identifier (i.e. bundled NetCDF 3.6)
+   * \param [in] records expected number of records (i.e. size of unlimited dimension, 0 for fixed dimensions only)
+   *
+   * \code
+   *   fp.fast_create=true;fp.header_slack=16384;
+   *   fp.saveNetCDFFile("data.nc");
+   *   //add dimensions, variables and attributes
+   *   fp.endNetCDFDefine(samples);
+   * \endcode
+   * \see saveNetCDFFile
+   **/
+  int endNetCDFDefine(long records=0)
+  {
+    if(pNCFile==NULL||!pNCFile->is_valid()) return CODE_ERROR;
+    const int ncid=pNCFile->id();
+    ///leave define mode with header slack, then through NcFile (i.e. begins kept as header fits)
+    if(header_slack>0)
+    {
+      const int status=nc__enddef(ncid,header_slack,1,0,1);
+      if(status==NC_NOERR) {if(nc_redef(ncid)!=NC_NOERR) return NC_ERROR;}
+      else if(status!=NC_ENOTINDEFINE) return NC_ERROR;
+    }
+    if(!pNCFile->data_mode()) return NC_ERROR;
+#ifdef FALLOC_FL_KEEP_SIZE
+    ///preallocate data section (i.e. variables after header and its slack, each padded to 4 bytes)
+    off_t size=0;
+    for(int i=0;i<pNCFile->num_vars();++i)
+    {
+      NcVar *v=pNCFile->get_var(i);
+      const bool record=(v->num_dims()>0&&v->get_dim(0)->is_unlimited());
+      long n=1;
+      for(int d=record?1:0;d<v->num_dims();++d) n*=v->get_dim(d)->size();
+      off_t bytes=(off_t)n*nctypelen((nc_type)v->type());
+      bytes=(bytes+3)/4*4;
+      size+=record?bytes*records:bytes;
+    }
+    if(!pNCFile->sync()) return NC_ERROR;//header on disk
+    struct stat st;
+    if(fstat(ncid,&st)!=0) return NC_ERROR;
+    const off_t begin=(st.st_size+(off_t)header_slack+3)/4*4;
+    if(size>0&&fallocate(ncid,FALLOC_FL_KEEP_SIZE,0,begin+size)!=0)
+      std::cerr<<"Warning: can not preallocate "<<begin+size<<" bytes of NetCDF file (data section)."<<std::endl;
+#endif
+    return 0;
+  }
+
   //! add variables in NetCDF file
   /**
    * save variables in NetCDF file, may be called after creation of dimensions \c CImgNetCDF::addNetCDFDims
@@ -337,9 +529,14 @@ template<typename T> class CImgNetCDF
    *
    **/
   int addNetCDFVar(std::string var_name,std::string unit_name)
+  {
+    return addNetCDFVar(var_name,unit_name,(NcType)NcTypeInfo<T>::ncId());
+  }
+  //! \overload with on-disk type independent of \c T (e.g. \c ncShort for 16 bit levels, see \c putNetCDFDataBlock )
+  int addNetCDFVar(std::string var_name,std::string unit_name,NcType disk_type)
   {
 #if cimg_debug>10
-    std::cerr << "CImgNetCDF::" << __func__ << "(" << var_name << "," << unit_name << ")" << std::endl;
+    std::cerr << "CImgNetCDF::" << __func__ << "(" << var_name << "," << unit_name << "," << NcTypeStr(disk_type) << ")" << std::endl;
 #endif
     if(pNCDimt==NULL)
       {
@@ -348,10 +545,10 @@ template<typename T> class CImgNetCDF
 #endif
 	switch(vpNCDim.size())
 	  {
-	  case 4:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),vpNCDim[3],vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
-	  case 3:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
-	  case 2:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
-	  case 1:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),vpNCDim[0]))) return NC_ERROR;break;
+	  case 4:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,vpNCDim[3],vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
+	  case 3:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
+	  case 2:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
+	  case 1:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,vpNCDim[0]))) return NC_ERROR;break;
 	    //default:NULL;
 	  }
       }
@@ -362,10 +559,11 @@ template<typename T> class CImgNetCDF
 #endif
 	switch(vpNCDim.size())
 	  {
-	  case 4:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),pNCDimt,vpNCDim[3],vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
-	  case 3:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),pNCDimt,vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
-	  case 2:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),pNCDimt,vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
-	  case 1:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),(NcType)NcTypeInfo<T>::ncId(),pNCDimt,vpNCDim[0]))) return NC_ERROR;break;	
+	  case 4:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,pNCDimt,vpNCDim[3],vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
+	  case 3:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,pNCDimt,vpNCDim[2],vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
+	  case 2:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,pNCDimt,vpNCDim[1],vpNCDim[0]))) return NC_ERROR;break;
+	  case 1:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,pNCDimt,vpNCDim[0]))) return NC_ERROR;break;	
+	  case 0:if (!(pNCvar=pNCFile->add_var(var_name.c_str(),disk_type,pNCDimt))) return NC_ERROR;break;//1D record variable (e.g. data on unlimited time)
 	    //default:NULL;
 	  }
       }
@@ -500,6 +698,111 @@ template<typename T> class CImgNetCDF
     return 0;
   }
 
+  //! add a block of variable data in NetCDF file
+  /**
+   * add a block of 1D variable data at position \c start along the first dimension (e.g. \c time ),
+   * may be called after creation of both dimensions \c CImgNetCDF::addNetCDFDims and variables \c CImgNetCDF::addNetCDFVar .
+   * This allows to write a variable part by part (e.g. while acquiring).
+   *
+   * \param [in] img: data block to write (i.e. its width is the block size)
+   * \param [in] start: index of the first sample of the block in the variable
+   *
+   * \code
+   *   fp.addNetCDFDataBlock(block,0);fp.addNetCDFDataBlock(block,block.width());
+   * \endcode
+   *
+   * \note only 1D variable is implemented, i.e. either a fixed dimension or the unlimited one (records are then appended, e.g. \c start is the number of records)
+   * \see CImgNetCDF::addNetCDFData
+   **/
+  int addNetCDFDataBlock(CImg<T> &img,long start)
+  {
+#if cimg_debug>10
+    std::cerr<<"CImgNetCDF::"<< __func__<<"(CImg<"<<img.pixel_type()<<">,"<<start<<")"<<std::endl;
+#endif
+    if(pNCvar==NULL) return CODE_ERROR;
+    if(pNCDimt!=NULL&&vpNCDim.empty())
+    {//record variable: write records from start (i.e. unlimited dimension grows)
+      if (!pNCvar->set_cur(start)) return NC_ERROR;
+      if (!pNCvar->put(img.data(),img.width())) return NC_ERROR;
+      pNCvar->set_cur(0L);
+      return 0;
+    }
+    if(vpNCDim.size()!=1) return DIM_ERROR;
+    if(start+img.width()>loadDim(0)) return DIM_ERROR;
+    //write data from start
+    if (!pNCvar->set_cur(start)) return NC_ERROR;
+    if (!pNCvar->put(img.data(),img.width())) return NC_ERROR;
+    //restore default start corner
+    pNCvar->set_cur(0L);
+    return 0;
+  }
+
+  //! add a block of variable data of any memory type in NetCDF file
+  /**
+   * same as \c CImgNetCDF::addNetCDFDataBlock , but the in-memory type \c Tmem and the on-disk type of the variable are independent
+   * (i.e. data written as they are if same type, otherwise converted in one pass chunk by chunk; e.g. \c unsigned \c short levels in \c ncShort or \c ncFloat variable).
+   *
+   * \code
+   *   fp.addNetCDFVar("c0","level",ncShort);
+   *   CImg<unsigned short> levels(4096);
+   *   fp.putNetCDFDataBlock(levels,0);
+   * \endcode
+   * \see NcPut CImgNetCDF::getNetCDFData
+   **/
+  template<typename Tmem>
+  int putNetCDFDataBlock(const CImg<Tmem> &img,long start)
+  {
+    if(pNCvar==NULL) return CODE_ERROR;
+    if(!(pNCDimt!=NULL&&vpNCDim.empty()))
+    {//fixed dimension
+      if(vpNCDim.size()!=1) return DIM_ERROR;
+      if(start+img.width()>loadDim(0)) return DIM_ERROR;
+    }
+    if (!NcPut(pNCvar,img.data(),start,img.width())) return NC_ERROR;
+    pNCvar->set_cur(0L);
+    return 0;
+  }
+
+  //! load whole variable data of any memory type from NetCDF file
+  /**
+   * the in-memory type \c Tmem and the on-disk type of the variable are independent (i.e. read as they are if same type, otherwise converted in one pass).
+   * \param [in,out] img: allocated image (e.g. by \c loadNetCDFVar ), with as many values as the variable
+   * \see NcGet CImgNetCDF::putNetCDFDataBlock
+   **/
+  template<typename Tmem>
+  int getNetCDFData(CImg<Tmem> &img)
+  {
+    if(pNCvar==NULL) return CODE_ERROR;
+    if((long)img.size()!=pNCvar->num_vals()) return DIM_ERROR;
+    if (!NcGet(pNCvar,img.data())) return NC_ERROR;
+    return 0;
+  }
+
+  //! load a block of 1D variable data of any memory type from NetCDF file
+  /**
+   * hyperslab read of \c count samples every \c stride from \c start (i.e. only this window is read from file; e.g. a few seconds of a long recording, or decimated overview)
+   * \param [out] img: data block (i.e. assigned to \c count samples if needed)
+   * \param [in] start: index of the first sample in the variable
+   * \param [in] count: number of samples to read
+   * \param [in] stride: distance between two read samples (i.e. 1: contiguous)
+   * \code
+   *   fp.getNetCDFDataBlock(block,200000,100000);//samples 200000 to 299999
+   *   fp.getNetCDFDataBlock(overview,0,1000,fp.loadDim(0)/1000);//1000 samples over the whole variable
+   * \endcode
+   * \note only 1D variable is implemented, i.e. either a fixed dimension or the unlimited one (i.e. number of records)
+   * \see NcGetBlock CImgNetCDF::getNetCDFData
+   **/
+  template<typename Tmem>
+  int getNetCDFDataBlock(CImg<Tmem> &img,long start,long count,long stride=1)
+  {
+    if(pNCvar==NULL) return CODE_ERROR;
+    if(pNCvar->num_dims()!=1) return DIM_ERROR;
+    if(start<0||count<0||stride<1) return DIM_ERROR;
+    if(count>0&&start+(count-1)*stride>=pNCvar->get_dim(0)->size()) return DIM_ERROR;
+    if(img.width()!=count||(long)img.size()!=count) img.assign(count);
+    if (!NcGetBlock(pNCFile->id(),pNCvar,img.data(),start,count,stride)) return NC_ERROR;
+    return 0;
+  }
 
 
   //! load variable dimension from NetCDF file
@@ -1213,6 +1516,137 @@ template<typename T> class CImgNetCDF
       return 0;
     }
 
+    //! add variables in NetCDF file without data
+    /**
+     * same as \c CImgListNetCDF::addNetCDFVar , but the dimensions are not checked against any data
+     * (e.g. to define whole variables before writing them by blocks using \c CImgListNetCDF::addNetCDFDataBlock )
+     *
+     * \see CImgListNetCDF::addNetCDFDataBlock
+     **/
+    int addNetCDFVar(std::vector<std::string> var_names,std::vector<std::string> unit_names)
+    {
+#if cimg_debug>10
+      std::cerr << "CImgListNetCDF::" << __func__ << "(vector<string>,vector<string>)" << std::endl;
+#endif
+      if(var_names.size()<1) {return DIM_ERROR;}
+      if(var_names.size()!=unit_names.size()) {return DIM_ERROR;}
+      //allocates
+      pNCvars.assign(var_names.size(),NULL);
+      //var component
+      for(unsigned int i=0;i<pNCvars.size();i++)
+	{
+	  if((*this).CImgNetCDF<T>::addNetCDFVar(var_names[i],unit_names[i])) {return NC_ERROR;}
+	  pNCvars[i]=(*this).pNCvar;(*this).pNCvar=NULL;
+	}
+      return 0;
+    }
+
+    //! \overload with on-disk type independent of \c T (see \c CImgNetCDF::putNetCDFDataBlock )
+    int addNetCDFVar(std::vector<std::string> var_names,std::vector<std::string> unit_names,NcType disk_type)
+    {
+      if(var_names.size()<1) {return DIM_ERROR;}
+      if(var_names.size()!=unit_names.size()) {return DIM_ERROR;}
+      pNCvars.assign(var_names.size(),NULL);
+      for(unsigned int i=0;i<pNCvars.size();i++)
+	{
+	  if((*this).CImgNetCDF<T>::addNetCDFVar(var_names[i],unit_names[i],disk_type)) {return NC_ERROR;}
+	  pNCvars[i]=(*this).pNCvar;(*this).pNCvar=NULL;
+	}
+      return 0;
+    }
+
+    //! add a block of variable data of any memory type in NetCDF file
+    /**
+     * add a block of data for all variables at position \c start , converted to the variable type if needed
+     *
+     * \see CImgNetCDF::putNetCDFDataBlock
+     **/
+    template<typename Tmem>
+    int putNetCDFDataBlock(const CImgList<Tmem> &imgs,long start)
+    {
+      if(pNCvars.empty()) return CODE_ERROR;
+      if(imgs.size()!=pNCvars.size()) {return DIM_ERROR;}
+      int error;
+      for(unsigned int i=0;i<pNCvars.size();i++)
+	{
+	  (*this).pNCvar=pNCvars[i];//set current variable data pointer
+	  error=(*this).CImgNetCDF<T>::putNetCDFDataBlock(imgs[i],start);
+	  (*this).pNCvar=NULL;
+	  if(error) return error;
+	}
+      return 0;
+    }
+
+    //! load whole variable data of any memory type from NetCDF file
+    /**
+     * load data of all variables (e.g. set by \c loadNetCDFVar ), converted from the variable type if needed
+     *
+     * \see CImgNetCDF::getNetCDFData
+     **/
+    template<typename Tmem>
+    int getNetCDFData(CImgList<Tmem> &imgs)
+    {
+      if(pNCvars.empty()) return CODE_ERROR;
+      if(imgs.size()!=pNCvars.size()) {return DIM_ERROR;}
+      int error;
+      for(unsigned int i=0;i<pNCvars.size();i++)
+	{
+	  (*this).pNCvar=pNCvars[i];//set current variable data pointer
+	  error=(*this).CImgNetCDF<T>::getNetCDFData(imgs[i]);
+	  (*this).pNCvar=NULL;
+	  if(error) return error;
+	}
+      return 0;
+    }
+
+    //! load a block of variable data of any memory type from NetCDF file
+    /**
+     * hyperslab read of \c count samples every \c stride from \c start of all variables (e.g. set by \c loadNetCDFVar , i.e. channel subset)
+     *
+     * \see CImgNetCDF::getNetCDFDataBlock
+     **/
+    template<typename Tmem>
+    int getNetCDFDataBlock(CImgList<Tmem> &imgs,long start,long count,long stride=1)
+    {
+      if(pNCvars.empty()) return CODE_ERROR;
+      if(imgs.size()!=pNCvars.size()) imgs.assign(pNCvars.size());
+      int error;
+      for(unsigned int i=0;i<pNCvars.size();i++)
+	{
+	  (*this).pNCvar=pNCvars[i];//set current variable data pointer
+	  error=(*this).CImgNetCDF<T>::getNetCDFDataBlock(imgs[i],start,count,stride);
+	  (*this).pNCvar=NULL;
+	  if(error) return error;
+	}
+      return 0;
+    }
+
+    //! add a block of variable data in NetCDF file
+    /**
+     * add a block of data for all variables at position \c start (i.e. one \c CImg per variable)
+     *
+     * \see CImgNetCDF::addNetCDFDataBlock
+     **/
+    int addNetCDFDataBlock(CImgList<T> &imgs,long start)
+    {
+#if cimg_debug>10
+      std::cerr << "CImgListNetCDF::" << __func__ << "(CImgList<" << imgs.pixel_type() << ">(" << imgs.size() << ")";
+      std::cerr << ",start=" << start << ")" << std::endl;
+#endif
+      if(pNCvars.empty()) return CODE_ERROR;
+      //check sizes
+      if(imgs.size()!=pNCvars.size()) {return DIM_ERROR;}
+      //var component
+      for(unsigned int i=0;i<pNCvars.size();i++)
+	{
+	  //write data
+	  (*this).pNCvar=pNCvars[i];//set current variable data pointer
+	  if((*this).CImgNetCDF<T>::addNetCDFDataBlock(imgs[i],start)) {(*this).pNCvar=NULL;return NC_ERROR;}
+	  (*this).pNCvar=NULL;
+	}
+      return 0;
+    }
+
 
 
 
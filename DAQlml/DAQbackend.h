@@ -0,0 +1,120 @@
+#ifndef DAQ_BACKEND
+#define DAQ_BACKEND
+
+//! acquisition device backend
+/**
+ * interface between \c DAQdevice and the board: the methods are those of comedi library used by DAQlml (i.e. same names without \c comedi_ prefix and device pointer),
+ * so that a board (see \c DAQbackend_comedi ) or a simulated device (see \c DAQsimulated ) can be used by all acquisition paths.
+ *
+ * \code
+ *   DAQbackend *backend=DAQbackend_new("/dev/comedi0");
+ *   backend->open("/dev/comedi0");
+ *   int bytes=backend->get_buffer_contents(subdevice);
+ * \endcode
+ * \see DAQdevice
+ **/
+class DAQbackend
+{
+ public:
+  //! destructor
+  virtual ~DAQbackend() {}
+
+  //! load backend specific parameters (e.g. \c simulation variable)
+  virtual int load_parameter(const std::string /*file_name*/) {return 0;}
+
+  //! open device
+  /**
+   * \return 0 on success
+   **/
+  virtual int open(const std::string filename)=0;
+  //! close device (i.e. stop acquisition)
+  virtual int close()=0;
+  //! print last error
+  virtual void perror(const char *s)=0;
+  //! device file descriptor (i.e. -1 if none)
+  virtual int fileno()=0;
+
+  //! @name board information
+  //@{
+  virtual int get_version_code()=0;
+  virtual const char* get_driver_name()=0;
+  virtual const char* get_board_name()=0;
+  virtual int get_subdevice_type(int subdevice)=0;
+  virtual int get_subdevice_flags(int subdevice)=0;
+  virtual lsampl_t get_maxdata(int subdevice,int channel)=0;
+  virtual comedi_range* get_range(int subdevice,int channel,int range)=0;
+  //@}
+
+  //! @name buffer acquisition
+  //@{
+  virtual int get_buffer_size(int subdevice)=0;
+  //! map the acquisition buffer in memory (i.e. \c MAP_FAILED on error)
+  virtual void* map_buffer(int size)=0;
+  virtual int command_test(comedi_cmd *cmd)=0;
+  virtual int command(comedi_cmd *cmd)=0;
+  virtual int get_buffer_contents(int subdevice)=0;
+  virtual int mark_buffer_read(int subdevice,int bytes)=0;
+  //@}
+
+  //! @name point acquisition
+  //@{
+  virtual int data_read_delayed(int subdevice,int channel,int range,int aref,lsampl_t *data,int nano_sec)=0;
+  //! do a list of instructions in a single request (e.g. read all channels of a scan)
+  /**
+   * \return number of instructions done, or -1 on error
+   **/
+  virtual int do_insnlist(comedi_insnlist *list)=0;
+  //@}
+};//DAQbackend class
+
+//! comedi board backend
+/**
+ * calls comedi library on the device file (e.g. \c /dev/comedi0 ).
+ **/
+class DAQbackend_comedi : public DAQbackend
+{
+ public:
+  comedi_t *dev; ///< pointer to device
+
+  DAQbackend_comedi() {dev=NULL;}
+
+  int open(const std::string filename)
+  {
+    dev=comedi_open(filename.c_str());
+    return (dev==NULL)?-1:0;
+  }
+  int close()
+  {
+    if(dev==NULL) return 0;
+    int ret=comedi_close(dev);
+    dev=NULL;
+    return ret;
+  }
+  void perror(const char *s) {comedi_perror(s);}
+  int fileno() {return comedi_fileno(dev);}
+
+  int get_version_code() {return comedi_get_version_code(dev);}
+  const char* get_driver_name() {return comedi_get_driver_name(dev);}
+  const char* get_board_name() {return comedi_get_board_name(dev);}
+  int get_subdevice_type(int subdevice) {return comedi_get_subdevice_type(dev,subdevice);}
+  int get_subdevice_flags(int subdevice) {return comedi_get_subdevice_flags(dev,subdevice);}
+  lsampl_t get_maxdata(int subdevice,int channel) {return comedi_get_maxdata(dev,subdevice,channel);}
+  comedi_range* get_range(int subdevice,int channel,int range) {return comedi_get_range(dev,subdevice,channel,range);}
+
+  int get_buffer_size(int subdevice) {return comedi_get_buffer_size(dev,subdevice);}
+  //! map device buffer to main memory through device file (e.g. /dev/comedi0)
+  /**
+   * option MAP_SHARED means updating memory contents when the file (/dev/comedi0) is updated.
+   **/
+  void* map_buffer(int size) {return mmap(NULL,size,PROT_READ,MAP_SHARED,comedi_fileno(dev),0);}
+  int command_test(comedi_cmd *cmd) {return comedi_command_test(dev,cmd);}
+  int command(comedi_cmd *cmd) {return comedi_command(dev,cmd);}
+  int get_buffer_contents(int subdevice) {return comedi_get_buffer_contents(dev,subdevice);}
+  int mark_buffer_read(int subdevice,int bytes) {return comedi_mark_buffer_read(dev,subdevice,bytes);}
+
+  int data_read_delayed(int subdevice,int channel,int range,int aref,lsampl_t *data,int nano_sec) {return comedi_data_read_delayed(dev,subdevice,channel,range,aref,data,nano_sec);}
+  int do_insnlist(comedi_insnlist *list) {return comedi_do_insnlist(dev,list);}
+};//DAQbackend_comedi class
+
+#endif// DAQ_BACKEND
+
@@ -0,0 +1,251 @@
+//! micro-benchmark of DAQlml kernels
+/**
+ * benchmark of the DAQlml hot loops on synthetic data (i.e. no board needed):
+ * \li de-interleave of the mapped comedi buffer, legacy per-sample loop versus \c deinterleave_ring engine (1, 2, 3, 4, 8 and 16 channels)
+ * \li conversion to physical values, legacy per-sample \c comedi_to_phys like call versus \c DAQconvert modes (table, affine, threads)
+ * \li point acquisition on the simulated device, legacy request for each channel versus \c DAQinsnlist request for each scan (requests per scan and maximum scan rate)
+ *
+ * \code
+ *   make DAQbench && ./DAQbench -n 4194304 -l 8
+ * \endcode
+ * \see DAQdeinterleave.h DAQconvert.h DAQpoint.h
+ **/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <sys/time.h>
+#include <sys/mman.h>
+
+#include "../CImg.Tool/useCImg.h"
+#include <comedilib.h>
+#include <netcdfcpp.h>
+#include "../NetCDF.Tool/struct_parameter_NetCDF.h"
+#include "../NetCDF.Tool/NetCDFinfo.h"
+
+//! elapsed time (in second)
+double getETime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + (double)tv.tv_usec*1e-6;
+}
+
+//DAQlml headers
+#include "DAQbackend.h"
+#include "DAQsimulated.h"
+#include "DAQcomedi.h"
+#include "DAQparallel.h"
+#include "DAQconvert.h"
+#include "DAQpoint.h"
+#include "DAQdeinterleave.h"
+
+//! legacy de-interleave loop of \c sample_data_buffer (i.e. per sample modulo and column counter)
+template<typename T>
+void deinterleave_legacy(const void *map,int size,int back,long scans,int channel_number,cimg_library::CImgList<T> &data)
+{
+  const int front=back+scans*channel_number*sizeof(sampl_t);
+  int col=0;long sample_count=0;
+  for(int i=back;i<front;i+=sizeof(sampl_t))
+  {
+    data[col](sample_count)=*(sampl_t *)((const char*)map+(i%size));
+    col++;
+    if(col==channel_number) {col=0;sample_count++;}
+  }
+}
+
+//! benchmark de-interleave for a number of channels
+/**
+ * the ring is read \c loop times from an offset that is not scan aligned to the buffer end (i.e. spans and split scan are used).
+ * \return 0 if engine output equals legacy one
+ **/
+int bench_deinterleave(int channel_number,long scans,int size,int loop)
+{
+  const int scan_bytes=channel_number*sizeof(sampl_t);
+  const long total_bytes=scans*scan_bytes;
+  ///- synthetic mapped buffer
+  cimg_library::CImg<sampl_t> ring(size/sizeof(sampl_t));
+  cimg_forX(ring,i) ring(i)=(sampl_t)(i*2654435761u>>16);
+  const int back=size-(size/3/scan_bytes)*scan_bytes-sizeof(sampl_t);//wrap within run and split scan if possible
+  ///- legacy loop
+  cimg_library::CImgList<int> legacy(channel_number,scans);
+  double st=getETime();
+  for(int l=0;l<loop;++l) deinterleave_legacy(ring.data(),size,back,scans,channel_number,legacy);
+  double legacy_time=(getETime()-st)/loop;
+  ///- engine to int (i.e. as sample_data_buffer)
+  cimg_library::CImgList<int> data(channel_number,scans);
+  int *plane[256];
+  for(int c=0;c<channel_number;++c) plane[c]=data[c].data();
+  st=getETime();
+  for(int l=0;l<loop;++l) deinterleave_ring<sampl_t>(ring.data(),size,back,scans,channel_number,plane);
+  double engine_time=(getETime()-st)/loop;
+  ///- engine to sampl_t (i.e. raw planes)
+  cimg_library::CImgList<sampl_t> raw(channel_number,scans);
+  sampl_t *raw_plane[256];
+  for(int c=0;c<channel_number;++c) raw_plane[c]=raw[c].data();
+  st=getETime();
+  for(int l=0;l<loop;++l) deinterleave_ring<sampl_t>(ring.data(),size,back,scans,channel_number,raw_plane);
+  double raw_time=(getETime()-st)/loop;
+  ///- check
+  int error=0;
+  for(int c=0;c<channel_number;++c) cimg_forX(data[c],s) if(data[c](s)!=legacy[c](s)||raw[c](s)!=legacy[c](s)) {++error;break;}
+  std::cout<<"de-interleave "<<channel_number<<" channels: "
+    <<"legacy "<<total_bytes/legacy_time*1e-9<<" GB/s, "
+    <<"engine "<<total_bytes/engine_time*1e-9<<" GB/s (int), "
+    <<total_bytes/raw_time*1e-9<<" GB/s (sampl_t)"
+    <<(error?", ERROR: output differs":"")<<std::endl;
+  return error;
+}
+
+//! legacy per-sample conversion (i.e. same computation as \c comedi_to_phys with \c COMEDI_OOR_NAN )
+double to_phys_legacy(lsampl_t data,const comedi_range *rng,lsampl_t maxdata) __attribute__((noinline));
+double to_phys_legacy(lsampl_t data,const comedi_range *rng,lsampl_t maxdata)
+{
+  if(!rng||!maxdata) return std::numeric_limits<double>::quiet_NaN();
+  if(data==0||data==maxdata) return std::numeric_limits<double>::quiet_NaN();
+  double x=data;
+  x/=maxdata;
+  x*=(rng->max-rng->min);
+  x+=rng->min;
+  return x;
+}
+
+//! same value (i.e. NaN at same place, relative tolerance otherwise)
+inline bool same_phys(float a,float b,float tolerance)
+{
+  if(a!=a||b!=b) return (a!=a)&&(b!=b);
+  return std::abs(a-b)<=tolerance;
+}
+
+//! benchmark conversion for a number of channels
+/**
+ * channels get ranges alternately bipolar 10V and 5V (i.e. two tables).
+ * \return 0 if engine outputs equal legacy one
+ **/
+int bench_convert(int channel_number,long samples,int loop,int threads)
+{
+  comedi_range range[2];
+  range[0].min=-10;range[0].max=10;range[0].unit=UNIT_volt;
+  range[1].min=-5; range[1].max=5; range[1].unit=UNIT_volt;
+  const lsampl_t maxdata=65535;
+  std::vector<const comedi_range*> ranges(channel_number);
+  for(int c=0;c<channel_number;++c) ranges[c]=&range[c%2];
+  const double total=(double)samples*channel_number;
+  ///- synthetic levels (including out of range ones)
+  cimg_library::CImgList<sampl_t> data(channel_number,samples);
+  cimglist_for(data,c) cimg_forX(data[c],s) data[c](s)=(sampl_t)((s*2654435761u+c)>>16);
+  data[0](0)=0;data[0](1)=maxdata;
+  ///- legacy loop
+  cimg_library::CImgList<float> legacy(channel_number,samples);
+  double st=getETime();
+  for(int l=0;l<loop;++l) cimglist_for(data,c) cimg_forX(data[c],s) legacy[c](s)=to_phys_legacy(data[c](s),ranges[c],maxdata);
+  const double legacy_time=(getETime()-st)/loop;
+  std::cout<<"convert "<<channel_number<<" channels: legacy "<<total/legacy_time*1e-6<<" MS/s";
+  ///- engine modes
+  const int    modes[]={CONVERT_LUT,CONVERT_AFFINE,CONVERT_AFFINE};
+  const int    mode_threads[]={1,1,threads};
+  const char  *names[]={"table","affine","affine threads"};
+  int error=0;
+  for(int m=0;m<3;++m)
+  {
+    DAQconvert<float> conv;
+    conv.mode=modes[m];conv.threads=mode_threads[m];
+    conv.assign(ranges,maxdata);
+    cimg_library::CImgList<float> phys;
+    conv.convert(data,phys);//allocation
+    st=getETime();
+    for(int l=0;l<loop;++l) conv.convert(data,phys);
+    const double time=(getETime()-st)/loop;
+    int e=0;
+    cimglist_for(data,c) cimg_forX(data[c],s) if(!same_phys(phys[c](s),legacy[c](s),1e-6f*range[c%2].max)) {++e;break;}
+    error+=e;
+    std::cout<<", "<<names[m]<<" "<<total/time*1e-6<<" MS/s"<<(e?" (ERROR: output differs)":"");
+  }
+  std::cout<<std::endl;
+  return error;
+}
+
+//! benchmark point acquisition for a number of channels
+/**
+ * scans are read as fast as possible (i.e. no real time wait) on the simulated device, each request taking \c request_time .
+ * \return 0 if both loops read all scans
+ **/
+int bench_point(int channel_number,long scans,int request_time)
+{
+  DAQsimulated *sim=new DAQsimulated;
+  sim->request_time=request_time;
+  DAQdevice DAQdev;
+  DAQdev.backend=sim;
+  if(sim->open("sim")) {sim->perror("open");delete sim;return 1;}
+  for(int c=0;c<channel_number;++c) DAQdev.channel_index.push_back(c);
+  DAQdev.range_id=0;
+  ///- legacy loop (i.e. a request for each channel)
+  lsampl_t value;
+  int error=0;
+  sim->request_count=0;
+  double st=getETime();
+  for(long s=0;s<scans;++s)
+    for(int c=0;c<channel_number;++c)
+      if(sim->data_read_delayed(DAQdev.subdevice,DAQdev.channel_index[c],0,0,&value,1)<0) ++error;
+  const double legacy_time=getETime()-st;
+  const double legacy_request=(double)sim->request_count/scans;
+  ///- instruction list (i.e. a request for each scan)
+  DAQinsnlist scan;
+  scan.assign(DAQdev);
+  sim->request_count=0;
+  st=getETime();
+  for(long s=0;s<scans;++s) if(scan.read(sim)) ++error;
+  const double engine_time=getETime()-st;
+  const double engine_request=(double)sim->request_count/scans;
+  std::cout<<"point "<<channel_number<<" channels: "
+    <<"legacy "<<legacy_request<<" requests/scan, "<<scans/legacy_time*1e-3<<" kHz, "
+    <<"instruction list "<<engine_request<<" requests/scan, "<<scans/engine_time*1e-3<<" kHz"
+    <<(error?", ERROR: read failed":"")<<std::endl;
+  sim->close();
+  delete sim;
+  DAQdev.backend=NULL;
+  return error;
+}
+
+//! main function of the DAQbench program
+int main(int argc, char *argv[])
+{
+  const std::string version = "DAQbench v0.0.1: micro-benchmark of DAQlml kernels";
+  cimg_usage(version.c_str());
+  const bool show_h    = (cimg_option("-h",(const char*)NULL,NULL)!=NULL);
+        bool show_help = (cimg_option("--help",(const char*)NULL,"help (or -h option)")!=NULL);show_help=show_h|show_help;
+  const long scans     =  cimg_option("-n",1048576,"number of scans");
+  const int  size      =  cimg_option("--bufsize",1048576,"size of the mapped buffer (in byte)");
+  const int  loop      =  cimg_option("-l",8,"number of runs (i.e. time is averaged)");
+  const int  channel   =  cimg_option("-c",0,"number of channels (0: 1, 2, 3, 4, 8 and 16)");
+  const int  threads   =  cimg_option("--threads",0,"number of conversion threads (0: number of online processors)");
+  const long points    =  cimg_option("--points",20000,"number of scans of point acquisition");
+  const int  request   =  cimg_option("--request_time",2000,"time of a point acquisition request of the simulated device (in ns)");
+  if(show_help) {cimg_library::cimg::info();return 0;}
+  std::cout<<version<<std::endl;
+#ifdef DAQ_USE_AVX2
+  std::cout<<"AVX2 "<<(deinterleave_has_avx2()?"available":"not available")<<std::endl;
+#endif
+  int error=0;
+  if(channel>0) error+=bench_deinterleave(channel,scans,size,loop);
+  else
+  {
+    const int channels[]={1,2,3,4,8,16};
+    for(int i=0;i<6;++i) error+=bench_deinterleave(channels[i],scans,size,loop);
+  }
+  if(channel>0) error+=bench_convert(channel,scans,loop,threads);
+  else
+  {
+    const int channels[]={1,4,16};
+    for(int i=0;i<3;++i) error+=bench_convert(channels[i],scans,loop,threads);
+  }
+  if(channel>0) error+=bench_point(channel,points,request);
+  else
+  {
+    const int channels[]={1,4,8,16};
+    for(int i=0;i<4;++i) error+=bench_point(channels[i],points,request);
+  }
+  return error;
+}
+
@@ -11,11 +11,12 @@ class DAQdevice
   int verbose; ///< verbose option
   std::string filename;///< device file name
 
-  comedi_t *dev; ///< pointer to device
+  DAQbackend *backend; ///< device backend (i.e. comedi board or simulated device)
   comedi_range *comedirange; ///< pointer to comedirange;
   comedi_cmd c,*cmd; ///< comedi command
 
   int subdevice; ///< subdevice id
+  int subdevice_flags; ///< subdevice flags (e.g. \c SDF_LSAMPL for 32 bit samples)
   int aref; ///< reference, GROUND or DIFFERENCE
   int bufsize; ///< board buffer size
   int maxdata; ///< max value of voltage
@@ -24,8 +25,13 @@ class DAQdevice
   int sample_number; ///< sample number
   int sampling_rate; ///< sampling rate
   int range_id; ///< range id;
+  int settling_time; ///< point acquisition: wait between channel selection and read (in nanosecond; 0: no wait)
+  unsigned int trigger_src; ///< start trigger (i.e. \c TRIG_NOW or \c TRIG_EXT for a trigger shared between boards)
+  unsigned int trigger_arg; ///< start trigger argument (e.g. external trigger input)
+  double clock_offset; ///< start delay of this board relative to the others (in second; e.g. trigger path), corrected in multi-board files
   std::vector<std::string> channel_name; ///< channel name
   std::vector<int> channel_index; ///< channel index
+  struct timeval start_time; ///< start of acquisition (i.e. command sent to the board, or first point)
  
   //! constructor
   //! \todo subdevice and aref should be configurable somewhere?
@@ -37,13 +43,21 @@ class DAQdevice
     {
       filename=dev_filename;
       initDAQdevice();
+      backend=DAQbackend_new(filename);
     }
 // !/todo add variable subdevice: 0 for read and 1 for write
   void initDAQdevice()
   {
     subdevice=0;
+    subdevice_flags=0;
     aref=AREF_GROUND;
+    settling_time=0;
+    trigger_src=TRIG_NOW;trigger_arg=0;
+    clock_offset=0.0;
     cmd = &c;    
+    memset(cmd,0,sizeof(comedi_cmd));
+    start_time.tv_sec=start_time.tv_usec=0;
+    backend=NULL;
   }
 
   //! set unsigned int chanlist from channel_index, range and aref
@@ -57,12 +71,12 @@ class DAQdevice
   //! print on \c given stream all member values
   void print(std::ostream &stream)
   {
-    stream<<"comedi version code: "<<comedi_get_version_code(dev)<<std::endl;
+    stream<<"comedi version code: "<<backend->get_version_code()<<std::endl;
     stream<<"device file: "<<filename<<std::endl; 
-    stream<<"driver name: "<<comedi_get_driver_name(dev)<<std::endl;
-    stream<<"board name: "<<comedi_get_board_name(dev)<<std::endl;
+    stream<<"driver name: "<<backend->get_driver_name()<<std::endl;
+    stream<<"board name: "<<backend->get_board_name()<<std::endl;
     stream<<"subdevice id: " << subdevice << "\n";
-    int type = comedi_get_subdevice_type(dev, subdevice);
+    int type = backend->get_subdevice_type(subdevice);
     stream<<"subdevice type: ";
     switch(type)
       {
@@ -160,9 +174,22 @@ class DAQdevice
     fp.loadAttribute("sampling_rate",sampling_rate);
     fp.loadAttribute("number_of_samples",sample_number);
     fp.loadAttribute("range_id",range_id);
+    ///- start trigger (optional, e.g. "ext" for boards sharing an external trigger)
+    std::string trigger("now");
+    fp.loadAttribute("trigger",trigger);
+    if(trigger=="ext") trigger_src=TRIG_EXT;
+    else if(trigger=="now") trigger_src=TRIG_NOW;
+    else {std::cerr<<"Error: unknown trigger \""<<trigger<<"\" (i.e. now or ext).\n";return CODE_ERROR;}
+    int trigger_channel=trigger_arg;
+    fp.loadAttribute("trigger_channel",trigger_channel);trigger_arg=trigger_channel;
+    float offset=clock_offset;
+    fp.loadAttribute("clock_offset",offset);clock_offset=offset;
 
     setchannellist();
 
+    ///load backend parameters (e.g. waveforms of simulated device)
+    if(backend!=NULL) backend->load_parameter(file_name);
+
     return 0;
   }
 
@@ -180,11 +207,9 @@ class DAQdevice
     cmd->subdev = subdevice;
     cmd->flags = 0;
 
-    //! start the measurement immediately
-    //! one can specify TRIG_EXT for external trigerring
-    //! \todo cmd->start_src should be configurable by parameter.nc
-    cmd->start_src = TRIG_NOW;
-    cmd->start_arg = 0;
+    //! start the measurement immediately (i.e. TRIG_NOW) or on external trigger (i.e. TRIG_EXT, see \c trigger attribute of parameter file)
+    cmd->start_src = trigger_src;
+    cmd->start_arg = (trigger_src==TRIG_EXT)?trigger_arg:0;
 
     // set the board sampling rate (see comedi website)
     cmd->scan_begin_src = TRIG_TIMER;
@@ -222,19 +247,24 @@ class DAQdevice
     int sdflag;			/// subdevice flag
     
     // load thee device file
-    dev = comedi_open(filename.c_str());
-    if(!(dev)){
-      comedi_perror(filename.c_str());
+    if(backend==NULL) backend=DAQbackend_new(filename);
+    if(backend->open(filename)!=0){
+      backend->perror(filename.c_str());
       exit(1);
     }
     // check subdevice flag before using it
-    sdflag = comedi_get_subdevice_flags(dev, subdevice);
+    sdflag = backend->get_subdevice_flags(subdevice);
+    subdevice_flags = sdflag;
     std::cout<<std::showbase;
     if (verbose) std::cout<<"subdevice flag: "<<std::hex<<sdflag<<std::dec<<std::endl;
 
 // get max data and range. these will be used to convert 16bit integer binary to physical voltage
-    maxdata = comedi_get_maxdata(dev, subdevice,channel_index.front());
-    comedirange = comedi_get_range(dev, subdevice,channel_index.front(),range_id);
+    maxdata = backend->get_maxdata(subdevice,channel_index.front());
+    comedirange = backend->get_range(subdevice,channel_index.front(),range_id);
+    if(comedirange==NULL){
+      backend->perror("get_range");
+      exit(1);
+    }
     if(verbose) std::cout<<"maxdata:"<<maxdata<<", min:"<<(comedirange)->min<<", max:"<<(comedirange)->max<<", unit:"<<(comedirange)->unit<<std::endl;
 
     return 0;
@@ -252,22 +282,22 @@ class DAQdevice
     int ret;
 
     // get the buffer size of the subdevice 
-    bufsize = comedi_get_buffer_size(dev, subdevice);
+    bufsize = backend->get_buffer_size(subdevice);
     if(verbose) std::cout<<"buffer size is "<<bufsize<<std::endl; 
 
     // map device buffer to main memory through device file /dev/comedi0
     // option MAP_SHARED means updating memory contents when the file (/dev/comedi0) is updated.
     // (this means buffer and memory are linked??)
     // mmap(*addr, size, prot, flags, fd, offset) is the system function.
-    map = mmap(NULL, bufsize, PROT_READ, MAP_SHARED, comedi_fileno(dev), 0);
+    map = backend->map_buffer(bufsize);
     if( verbose ) std::cout<<"pointer to mapped region: "<<std::hex<<map<<std::dec<<std::endl;
     if( map == MAP_FAILED ){
       perror( "mmap" );
       exit(1);
     }
     // this function should be called twice.
-    ret = comedi_command_test(dev, cmd);
-    ret = comedi_command_test(dev, cmd);
+    ret = backend->command_test(cmd);
+    ret = backend->command_test(cmd);
     if(ret != 0){
       fprintf(stderr,"command_test failed\n");
       exit(1);
@@ -284,10 +314,11 @@ class DAQdevice
       }
 
     // send the command to the board
-    ret = comedi_command(dev, cmd);
+    ret = backend->command(cmd);
+    gettimeofday(&start_time,NULL);
     if(ret < 0)
     {
-      comedi_perror("comedi_command");
+      backend->perror("comedi_command");
       exit(1);
     }
 
@@ -302,6 +333,16 @@ class DAQdevice
     return config_device_specific_buffer(map);
    }//config_device_buffer
 
+  //! close device (i.e. stop acquisition and release backend)
+  int close()
+  {
+    if(backend==NULL) return 0;
+    int ret=backend->close();
+    delete backend;
+    backend=NULL;
+    return ret;
+  }
+
 };//DAQdevice class
 
 
@@ -323,91 +364,6 @@ int print_help(std::ostream &stream)
   return 0;
 }
 
-//! convert integer 16bit binary data into float physical voltage
-/** 
- * 
- * 
- * @param [in]    data integer binary
- * @param [inout] data_phys physical voltage
- * @param [in]    DAQdev DAQdevice object
- * 
- * @return 
- */
-template <typename Tacquisition, typename Tphysical>
-  int convert_to_phys(cimg_library::CImgList<Tacquisition>& data, cimg_library::CImgList<Tphysical>& data_phys, DAQdevice DAQdev)
-{
-  data_phys.assign(data);
-  cimglist_for(data,c)
-    {
-      cimg_forX(data[c],s)
-	{
-	  data_phys[c](s)=comedi_to_phys(data[c](s), DAQdev.comedirange, DAQdev.maxdata);
-	}
-    }
-  return 0;
-}
-//! convert float physical voltage into integer 16bit binary data
-/** 
- * 
- * 
- * @param data integer binary
- * @param data_phys physical voltage
- * @param [inout] DAQdev DAQdevice object
- * 
- * @return 
- */
-template <typename Tacquisition, typename Tphysical>
-  int convert_from_phys(cimg_library::CImgList<Tphysical>& data_phys, cimg_library::CImgList<Tacquisition>& data, DAQdevice DAQdev, const bool assign=true)
-{
-  if(assign) data.assign(data_phys);
-  cimglist_for(data_phys,c)
-    {
-      cimg_forX(data_phys[c],s)
-	{
-	  data[c](s)=comedi_from_phys(data_phys[c](s), DAQdev.comedirange, DAQdev.maxdata);
-	}
-    }
-  return 0;
-}
-
-//! create time corresponding to each sample
-/** 
- * create time corresponding to each sample
- * the delay between channels is also taken into account
- * 
- * @param[in] data 
- * @param[out] time 
- * @param[in,out] DAQdev 
- * @param sampling_rate 
- * 
- * @return 
- */
-template <typename Tdata, typename Ttime>
-  int create_time(cimg_library::CImgList<Tdata>& data, cimg_library::CImgList<Ttime>& time, DAQdevice DAQdev)
-{
-  //get minimum convert time of the board
-  int min_convert_time=DAQdev.cmd->convert_arg; // in nano second
-
-  //std::cerr<<__FILE__<<"/"<<__func__<<"(...)\n"<<std::flush;
-  //data.print("data");
-  //PR(board_frequency);
-  //PR(sampling_rate);
-  //allocate time structure
-  time.assign(data);
-  //time.print("time");
-  double cdelay=1e-9*(double)min_convert_time;//delay between channels
-  double present_time=0.0;
-  cimg_forX(time[0],s)
-    {
-      cimglist_for(time,c)
-	{
-	  time[c](s)=present_time+cdelay*c; // time of a channel is delayed depending on c
-	}
-      present_time+=1/(double)DAQdev.sampling_rate;
-    }
-  return 0;
-}
-
 //! subfunction of 
 char *cmd_src(int src,char *buf)
 {
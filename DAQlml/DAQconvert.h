@@ -0,0 +1,289 @@
+#ifndef DAQ_CONVERT
+#define DAQ_CONVERT
+
+//! conversion engine: binary levels to physical values
+/**
+ * same result as \c comedi_to_phys (i.e. \c min+(max-min)*level/maxdata , and NaN for out of range levels \c 0 and \c maxdata ),
+ * with the range computations done once for each channel:
+ * \li \c CONVERT_LUT : table of all physical values (i.e. 65536 entries for 16 bit boards),
+ * \li \c CONVERT_AFFINE : \c offset+scale*level , AVX2 kernel if the CPU supports it at run time,
+ * \li \c CONVERT_AUTO : AVX2 affine if available, else table for 16 bit boards, else affine.
+ *
+ * Channels are converted by several threads (see \c DAQparallel_for ) for long captures,
+ * and blocks may be converted in place (i.e. levels already stored in physical type, e.g. while streaming).
+ *
+ * \code
+ *   DAQconvert<float> conv;conv.assign(DAQdev);
+ *   conv.convert(data,data_phys);
+ * \endcode
+ * \see convert_to_phys DAQbench.cpp
+ **/
+
+#include <limits>
+#include <cmath>
+#if defined(__SSE2__) && defined(__GNUC__) && ( (__GNUC__>4) || ((__GNUC__==4)&&(__GNUC_MINOR__>=9)) ) && !defined(DAQ_NO_AVX2)
+#include <immintrin.h>
+#define DAQ_CONVERT_AVX2
+#endif
+
+//! conversion modes
+enum DAQconvert_mode {CONVERT_AUTO=0, CONVERT_LUT=1, CONVERT_AFFINE=2};
+
+//! minimum number of samples to convert channels in parallel
+#define CONVERT_PARALLEL_MIN 1048576
+
+#ifdef DAQ_CONVERT_AVX2
+//! AVX2 affine conversion of 16 bit levels (8 samples per iteration)
+/**
+ * \return number of samples converted (i.e. multiple of 8, tail is left to scalar path)
+ **/
+__attribute__((target("avx2,fma")))
+inline long convert_affine_avx2(const unsigned short *src,float *dst,long n,float scale,float offset,float maxdata,bool oor_nan)
+{
+  const __m256 s=_mm256_set1_ps(scale),o=_mm256_set1_ps(offset);
+  const __m256 zero=_mm256_setzero_ps(),top=_mm256_set1_ps(maxdata),nan=_mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+  long i=0;
+  for(;i+8<=n;i+=8)
+  {
+    __m256 x=_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src+i))));
+    __m256 y=_mm256_fmadd_ps(x,s,o);
+    if(oor_nan) y=_mm256_blendv_ps(y,nan,_mm256_or_ps(_mm256_cmp_ps(x,zero,_CMP_EQ_OQ),_mm256_cmp_ps(x,top,_CMP_EQ_OQ)));
+    _mm256_storeu_ps(dst+i,y);
+  }
+  return i;
+}
+//! AVX2 affine conversion of levels stored as float (i.e. in place)
+__attribute__((target("avx2,fma")))
+inline long convert_affine_avx2(const float *src,float *dst,long n,float scale,float offset,float maxdata,bool oor_nan)
+{
+  const __m256 s=_mm256_set1_ps(scale),o=_mm256_set1_ps(offset);
+  const __m256 zero=_mm256_setzero_ps(),top=_mm256_set1_ps(maxdata),nan=_mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+  long i=0;
+  for(;i+8<=n;i+=8)
+  {
+    __m256 x=_mm256_loadu_ps(src+i);
+    __m256 y=_mm256_fmadd_ps(x,s,o);
+    if(oor_nan) y=_mm256_blendv_ps(y,nan,_mm256_or_ps(_mm256_cmp_ps(x,zero,_CMP_EQ_OQ),_mm256_cmp_ps(x,top,_CMP_EQ_OQ)));
+    _mm256_storeu_ps(dst+i,y);
+  }
+  return i;
+}
+//! AVX2 and FMA availability at run time (checked once)
+inline bool convert_has_avx2()
+{
+  static const bool avx2=__builtin_cpu_supports("avx2")&&__builtin_cpu_supports("fma");
+  return avx2;
+}
+#endif //DAQ_CONVERT_AVX2
+
+//! vectorized kernel if any for these types, return number of converted samples
+template<typename Tsrc,typename Tphys>
+inline long convert_affine_simd(const Tsrc*,Tphys*,long,Tphys,Tphys,Tphys,bool) {return 0;}
+#ifdef DAQ_CONVERT_AVX2
+template<>
+inline long convert_affine_simd(const unsigned short *src,float *dst,long n,float scale,float offset,float maxdata,bool oor_nan)
+{return convert_has_avx2()?convert_affine_avx2(src,dst,n,scale,offset,maxdata,oor_nan):0;}
+template<>
+inline long convert_affine_simd(const float *src,float *dst,long n,float scale,float offset,float maxdata,bool oor_nan)
+{return convert_has_avx2()?convert_affine_avx2(src,dst,n,scale,offset,maxdata,oor_nan):0;}
+#endif
+
+//! conversion engine
+template<typename Tphys>
+class DAQconvert
+{
+ public:
+  int mode;     ///< conversion mode (see \c DAQconvert_mode )
+  int threads;  ///< number of threads (0: number of online processors)
+  bool oor_nan; ///< out of range levels (i.e. 0 and maxdata) are NaN (as \c COMEDI_OOR_NAN )
+
+  lsampl_t maxdata;             ///< maximum level
+  std::vector<Tphys> scale;     ///< physical step of each channel
+  std::vector<Tphys> offset;    ///< physical value of level 0 of each channel
+  std::vector<int> table_index; ///< table of each channel (i.e. in \c table )
+  cimg_library::CImgList<Tphys> table;///< physical values of all levels for each range (i.e. \c CONVERT_LUT )
+
+  //! constructor
+  DAQconvert()
+  {
+    mode=CONVERT_AUTO;
+    threads=0;
+    oor_nan=true;
+    maxdata=0;
+  }
+
+  //! set up ranges of all channels
+  /**
+   * \param [in] DAQdev acquisition device (i.e. configured, e.g. range and maxdata)
+   **/
+  int assign(const DAQdevice &DAQdev)
+  {
+    const int channel_number=DAQdev.channel_index.size();
+    std::vector<const comedi_range*> ranges(channel_number,DAQdev.comedirange);
+    return assign(ranges,DAQdev.maxdata);
+  }
+  //! set up ranges of all channels
+  /**
+   * \param [in] ranges range of each channel
+   * \param [in] max maximum level (i.e. \c maxdata )
+   **/
+  int assign(const std::vector<const comedi_range*> &ranges,lsampl_t max)
+  {
+    maxdata=max;
+    const int channel_number=ranges.size();
+    scale.assign(channel_number,0);offset.assign(channel_number,0);
+    table_index.assign(channel_number,-1);
+    table.assign();
+    std::vector<const comedi_range*> tabled;
+    for(int c=0;c<channel_number;++c)
+    {
+      if(ranges[c]==NULL) return CODE_ERROR;
+      offset[c]=(Tphys)ranges[c]->min;
+      scale[c]=(Tphys)((ranges[c]->max-ranges[c]->min)/(double)maxdata);
+      ///- table of physical values, once for each range (16 bit levels only)
+      if(maxdata>65535||mode==CONVERT_AFFINE||(mode==CONVERT_AUTO&&has_simd())) continue;
+      for(unsigned int t=0;t<tabled.size();++t) if(tabled[t]->min==ranges[c]->min&&tabled[t]->max==ranges[c]->max) table_index[c]=t;
+      if(table_index[c]>=0) continue;
+      table_index[c]=tabled.size();tabled.push_back(ranges[c]);
+      cimg_library::CImg<Tphys> lut(maxdata+1);
+      for(lsampl_t l=0;l<=maxdata;++l) lut(l)=(Tphys)(ranges[c]->min+(ranges[c]->max-ranges[c]->min)*(double)l/(double)maxdata);
+      if(oor_nan) lut(0)=lut(maxdata)=std::numeric_limits<Tphys>::quiet_NaN();
+      table.insert(lut);
+    }
+    return 0;
+  }
+
+  //! vectorized affine kernel is available at run time
+  static bool has_simd()
+  {
+#ifdef DAQ_CONVERT_AVX2
+    return convert_has_avx2();
+#else
+    return false;
+#endif
+  }
+
+  //! convert samples of a channel
+  /**
+   * \param [in] src levels (e.g. \c sampl_t , or physical type for in place conversion)
+   * \param [out] dst physical values (may be \c src if same type)
+   * \param [in] n number of samples
+   * \param [in] c channel (i.e. position in the channel list)
+   **/
+  template<typename Tsrc>
+  void convert(const Tsrc *src,Tphys *dst,long n,int c) const
+  {
+    affine(src,dst,n,c);
+  }
+  //! convert 16 bit levels of a channel (i.e. table if any, see \c CONVERT_LUT )
+  /**
+   * \note only \c sampl_t (i.e. unsigned) levels index the table, other types (e.g. \c short ) are converted by \c affine
+   **/
+  void convert(const sampl_t *src,Tphys *dst,long n,int c) const
+  {
+    if(table_index[c]>=0)
+    {///- table
+      const Tphys *lut=table[table_index[c]].data();
+      for(long i=0;i<n;++i) dst[i]=lut[src[i]];
+      return;
+    }
+    affine(src,dst,n,c);
+  }
+
+  //! convert all channels
+  /**
+   * \param [in] data levels (i.e. one image per channel)
+   * \param [out] data_phys physical values (i.e. same size as \c data ; may be \c data if same type, i.e. in place)
+   **/
+  template<typename Tsrc>
+  int convert(const cimg_library::CImgList<Tsrc> &data,cimg_library::CImgList<Tphys> &data_phys) const
+  {
+    if(data.size()!=scale.size()) return DIM_ERROR;
+    if((void*)&data!=(void*)&data_phys)
+    {
+      bool same=(data_phys.size()==data.size());
+      for(unsigned int c=0;same&&c<data.size();++c) same=(data_phys[c].width()==data[c].width());
+      if(!same) {data_phys.assign(data.size());cimglist_for(data,c) data_phys[c].assign(data[c].width());}
+    }
+    job<Tsrc> j(*this,data,data_phys);
+    long samples=0;
+    cimglist_for(data,c) samples+=data[c].width();
+    DAQparallel_for(j,data.size(),(samples<CONVERT_PARALLEL_MIN)?1:threads);
+    return 0;
+  }
+
+ private:
+  //! affine conversion of a channel (vectorized first)
+  template<typename Tsrc>
+  void affine(const Tsrc *src,Tphys *dst,long n,int c) const
+  {
+    const Tphys s=scale[c],o=offset[c],top=(Tphys)maxdata;
+    long i=convert_affine_simd(src,dst,n,s,o,top,oor_nan);
+    const Tphys nan=std::numeric_limits<Tphys>::quiet_NaN();
+    for(;i<n;++i)
+    {
+      const Tphys x=(Tphys)src[i];
+      dst[i]=(oor_nan&&(x==0||x==top))?nan:o+s*x;
+    }
+  }
+
+  //! conversion of a channel (i.e. for \c DAQparallel_for )
+  template<typename Tsrc>
+  class job : public DAQparallel_job
+  {
+   public:
+    const DAQconvert<Tphys> &conv;
+    const cimg_library::CImgList<Tsrc> &data;
+    cimg_library::CImgList<Tphys> &data_phys;
+    job(const DAQconvert<Tphys> &cv,const cimg_library::CImgList<Tsrc> &d,cimg_library::CImgList<Tphys> &dp):conv(cv),data(d),data_phys(dp) {}
+    void run(int c) {conv.convert(data[c].data(),data_phys[c].data(),data[c].width(),c);}
+  };
+};//DAQconvert class
+
+//! convert integer 16bit binary data into float physical voltage
+/**
+ *
+ *
+ * @param [in]    data integer binary
+ * @param [inout] data_phys physical voltage
+ * @param [in]    DAQdev DAQdevice object
+ * @param [in]    threads number of threads (0: number of online processors)
+ *
+ * @return
+ * \see DAQconvert
+ */
+template <typename Tacquisition, typename Tphysical>
+  int convert_to_phys(cimg_library::CImgList<Tacquisition>& data, cimg_library::CImgList<Tphysical>& data_phys, const DAQdevice &DAQdev, const int threads=0)
+{
+  DAQconvert<Tphysical> conv;
+  conv.threads=threads;
+  int error=conv.assign(DAQdev);
+  if(error) return error;
+  return conv.convert(data,data_phys);
+}
+//! convert float physical voltage into integer 16bit binary data
+/**
+ *
+ *
+ * @param data integer binary
+ * @param data_phys physical voltage
+ * @param [inout] DAQdev DAQdevice object
+ *
+ * @return
+ */
+template <typename Tacquisition, typename Tphysical>
+  int convert_from_phys(cimg_library::CImgList<Tphysical>& data_phys, cimg_library::CImgList<Tacquisition>& data, const DAQdevice &DAQdev, const bool assign=true)
+{
+  if(assign) data.assign(data_phys);
+  cimglist_for(data_phys,c)
+    {
+      cimg_forX(data_phys[c],s)
+	{
+	  data[c](s)=comedi_from_phys(data_phys[c](s), DAQdev.comedirange, DAQdev.maxdata);
+	}
+    }
+  return 0;
+}
+
+#endif// DAQ_CONVERT
+
@@ -1,10 +1,64 @@
 #ifndef DAQ_DATA
 #define DAQ_DATA
 
+//! packing attributes of a variable (i.e. \c scale_factor and \c add_offset ; false if not packed)
+/**
+ * \param [out] valid_min smallest valid stored value (i.e. \c valid_min attribute, -infinity if none)
+ * \param [out] valid_max largest valid stored value (i.e. \c valid_max attribute, +infinity if none)
+ **/
+inline bool unpack_attribute(NcVar *v,double &scale,double &offset,double &valid_min,double &valid_max)
+{
+  NcError silent(NcError::silent_nonfatal);
+  NcAtt *a;
+  bool packed=false;
+  scale=1.0;offset=0.0;
+  valid_min=-std::numeric_limits<double>::infinity();valid_max=std::numeric_limits<double>::infinity();
+  if((a=v->get_att("scale_factor"))) {scale=a->as_double(0);delete a;packed=true;}
+  if((a=v->get_att("add_offset")))   {offset=a->as_double(0);delete a;packed=true;}
+  if((a=v->get_att("valid_min")))    {valid_min=a->as_double(0);delete a;}
+  if((a=v->get_att("valid_max")))    {valid_max=a->as_double(0);delete a;}
+  return packed;
+}
+//! unpack values in place (i.e. physical=scale*stored+offset, one pass)
+/**
+ * stored values out of [\c valid_min , \c valid_max ] (i.e. clipped levels, see \c DAQwriter::save_packing ) are unpacked as NaN, as \c DAQconvert::oor_nan
+ **/
+template<typename T> void unpack(CImg<T> &x,double scale,double offset,double valid_min,double valid_max)
+{
+  T *p=x.data();
+  const T s=(T)scale,o=(T)offset,lo=(T)valid_min,hi=(T)valid_max;
+  const T nan=std::numeric_limits<T>::quiet_NaN();
+  for(long i=0,n=x.size();i<n;++i) p[i]=(p[i]<lo||p[i]>hi)?nan:p[i]*s+o;
+}
+//! unpack previously recorded data
+/**
+ * packed variables (i.e. \c scale_factor and \c add_offset attributes, CF convention, see \c DAQwriter::packed ), loaded in memory type, are unpacked in one pass;
+ * variables without these attributes are kept as they are.
+ * \note integer data are not unpacked (i.e. stored values)
+ * \param [in]  file_name file name (e.g. "data.nc")
+ * \param [in]  var_names variable names (i.e. loaded channels)
+ * \param [in,out] channels stored values, then physical values of packed variables
+**/
+template<typename T> int unpack_data(std::string file_name,std::vector<std::string> var_names,CImgList<T> &channels)
+{
+  NcFile fp(file_name.c_str(),NcFile::ReadOnly);
+  if(!fp.is_valid()) {std::cerr<<"Error: can not open \""<<file_name<<"\" file."<<std::endl;return NC_ERROR;}
+  for(unsigned int c=0;c<var_names.size()&&c<channels.size();++c)
+  {
+    NcVar *v=fp.get_var(var_names[c].c_str());
+    if(v==NULL) return NC_ERROR;
+    double scale,offset,valid_min,valid_max;
+    if(!unpack_attribute(v,scale,offset,valid_min,valid_max)) continue;
+    if(std::numeric_limits<T>::is_integer) {std::cerr<<"Warning: packed variable \""<<var_names[c]<<"\" loaded as stored values (i.e. integer type)."<<std::endl;continue;}
+    unpack(channels[c],scale,offset,valid_min,valid_max);
+  }
+  return 0;
+}
 //! load previously recorded data
 /**
  * load previously recorded data as many channels in a list (i.e. CImgList container)
  * \note all channels should have the same size (i.e. 1D data with same width)
+ * \note packed data (i.e. raw levels with \c scale_factor and \c add_offset ) are unpacked after loading (see \c unpack_data )
  * \param [in]  file_name file name (e.g. "data.nc")
  * \param [in]  var_names variable names (i.e. the requested list of channels;e.g. "pressure, hot_wire, square_wave, control_signal")
  * \param [out] unit_names variable unit names (i.e. unit names of channels; e.g. "Pa","m/s","V","volt")
@@ -40,8 +94,9 @@ std::cerr<<__FILE__<<"/"<<__func__<<"[data](\""<<file_name<<"\",...)"<<std::endl
   ///load NetCDF header
   std::cout << "CImgListNetCDF::loadNetCDFVar(" << file_name << ",...) return "  << fpi.loadNetCDFVar(channels,var_names,unit_names)  << std::endl;
   ///load NetCDF data
-  std::cout << "CImgListNetCDF::loadNetCDFData(" << file_name << ",...) return " << fpi.loadNetCDFData(channels)  << std::endl;
-  return 0;
+  std::cout << "CImgListNetCDF::getNetCDFData(" << file_name << ",...) return " << fpi.getNetCDFData(channels)  << std::endl;
+  ///unpack data (i.e. raw levels stored with \c scale_factor and \c add_offset )
+  return unpack_data(file_name,var_names,channels);
 }
 //! load previously recorded data information
 /**
@@ -86,6 +141,23 @@ std::cerr<<__FILE__<<"/"<<__func__<<"[information](\""<<file_name<<"\",...)"<<st
 */
   return 0;
 }
+//! load implicit time axis of previously recorded data
+/**
+ * load time attributes (i.e. start time, sampling period and channel offsets), so that time of any sample is computed in double precision on demand.
+ * \param [in]  file_name file name (e.g. "data.nc")
+ * \param [in]  var_names variable names (i.e. the requested list of channels)
+ * \param [out] time implicit time axis (e.g. \c time(s,c) or \c time.get(...) )
+ * \see DAQtime
+**/
+int load_data_time(std::string file_name,std::vector<std::string> var_names,DAQtime &time)
+{
+  NcFile fp(file_name.c_str(),NcFile::ReadOnly);
+  if(!fp.is_valid()) {std::cerr<<"Error: can not open \""<<file_name<<"\" file."<<std::endl;return NC_ERROR;}
+  std::vector<NcVar*> vars(var_names.size());
+  for(unsigned int c=0;c<var_names.size();++c)
+    if(!(vars[c]=fp.get_var(var_names[c].c_str()))) {std::cerr<<"Error: data variable \""<<var_names[c]<<"\" can not be loaded."<<std::endl;return NC_ERROR;}
+  return time.load(&fp,vars);
+}
 //! load previously recorded data
 /**
  * load previously recorded data as many channels in a list (i.e. CImgList container)
@@ -115,107 +187,504 @@ std::cerr<<__FILE__<<"/"<<__func__<<"[data+attribute](\""<<file_name<<"\",...)"<
   return 0;
 }
 
+//! read recorded data block by block
+/**
+ * block iterator on a window of recorded channels (i.e. channel subset, time index range and stride), so that files larger than memory are processed block by block:
+ * each block is a hyperslab read (i.e. only requested samples are read from file, see \c CImgListNetCDF::getNetCDFDataBlock ),
+ * converted to memory type and unpacked if needed (i.e. packed raw levels, see \c DAQwriter::packed ).
+ *
+ * \code
+ *   DAQreader<float> fi;
+ *   fi.open("data.nc",var_names);//e.g. 2 channels over 16
+ *   fi.window(2*100000,100000);//samples from 2 s to 3 s at 100 kHz
+ *   CImgList<float> block;
+ *   for(long n;(n=fi.next(block))>0;) process(block,fi.index);
+ * \endcode
+ * \note time of samples is given by \c index (i.e. first sample of the block) and \c stride , see \c load_data_time for time attributes
+ * \see load_data_window DAQwriter
+ **/
+template <typename T>
+class DAQreader
+{
+ public:
+  CImgListNetCDF<T> fpi;              ///< data variables (i.e. channel subset)
+  std::vector<std::string> var_names; ///< variable names (i.e. channel subset)
+  std::vector<double> scale;          ///< packing scale of each channel (i.e. \c scale_factor , see \c packed )
+  std::vector<double> offset;         ///< packing offset of each channel (i.e. \c add_offset )
+  std::vector<double> valid_min;      ///< smallest valid stored value of each channel (i.e. others unpacked as NaN)
+  std::vector<double> valid_max;      ///< largest valid stored value of each channel
+  std::vector<bool> packed;           ///< channel is packed (i.e. unpacked while reading)
+  long sample_number;///< number of samples of each channel in the file
+  long first;        ///< first sample of the window
+  long last;         ///< end of the window (i.e. last sample excluded)
+  long stride;       ///< distance between two read samples (i.e. 1: contiguous)
+  long block_size;   ///< maximum number of samples of each channel in a block
+  long position;     ///< next sample to read
+  long index;        ///< first sample of the last block read
+
+  //! constructor
+  DAQreader()
+  {
+    sample_number=first=last=position=index=0;
+    stride=1;block_size=65536;
+  }
+
+  //! open file and channel variables (i.e. whole window)
+  /**
+   * \param [in] file_name file name (e.g. "data.nc")
+   * \param [in] names variable names (i.e. channel subset; e.g. "pressure, hot_wire")
+   **/
+  int open(std::string file_name,std::vector<std::string> names)
+  {
+    if(names.empty()) return DIM_ERROR;
+    if(fpi.loadNetCDFFile((char*)file_name.c_str())) {std::cerr<<"Error: can not open \""<<file_name<<"\" file."<<std::endl;return NC_ERROR;}
+    var_names=names;
+    NcFile *fp=fpi.getNetCDFFile();
+    fpi.pNCvars.assign(var_names.size(),NULL);
+    scale.assign(var_names.size(),1.0);offset.assign(var_names.size(),0.0);packed.assign(var_names.size(),false);
+    valid_min.assign(var_names.size(),0.0);valid_max.assign(var_names.size(),0.0);
+    for(unsigned int c=0;c<var_names.size();++c)
+    {
+      NcVar *v;
+      {NcError silent(NcError::silent_nonfatal);v=fp->get_var(var_names[c].c_str());}
+      if(v==NULL) {std::cerr<<"Error: data variable \""<<var_names[c]<<"\" can not be loaded."<<std::endl;return NC_ERROR;}
+      if(v->num_dims()!=1) return DIM_ERROR;
+      fpi.pNCvars[c]=v;
+      packed[c]=unpack_attribute(v,scale[c],offset[c],valid_min[c],valid_max[c])&&!std::numeric_limits<T>::is_integer;
+    }
+    sample_number=fpi.pNCvars[0]->get_dim(0)->size();
+    return window(0,sample_number);
+  }
+
+  //! set window to read (i.e. from first block)
+  /**
+   * \param [in] start first sample of the window
+   * \param [in] count number of samples of each channel in the window (i.e. after stride; clipped to the end of file)
+   * \param [in] step distance between two read samples (e.g. 10: decimated by 10, without filtering)
+   **/
+  int window(long start,long count,long step=1)
+  {
+    if(start<0||start>sample_number||count<0||step<1) return DIM_ERROR;
+    first=start;stride=step;
+    last=std::min(sample_number,start+count*stride);
+    position=index=first;
+    return 0;
+  }
+
+  //! number of samples of each channel left in the window
+  long remaining() const {return (position<last)?(last-position+stride-1)/stride:0;}
+
+  //! read next block of all channels
+  /**
+   * \param [out] block data block (i.e. one image per channel, assigned to block size or less at the end of the window)
+   * \return number of samples of each channel in the block (i.e. 0 at the end of the window), or negative error code
+   **/
+  long next(CImgList<T> &block)
+  {
+    const long n=std::min(block_size,remaining());
+    if(n<1) return 0;
+    int error=fpi.getNetCDFDataBlock(block,position,n,stride);
+    if(error) return error;
+    for(unsigned int c=0;c<block.size();++c) if(packed[c]) unpack(block[c],scale[c],offset[c],valid_min[c],valid_max[c]);
+    index=position;
+    position+=n*stride;
+    return n;
+  }
+};//DAQreader class
+
+//! load a window of previously recorded data
+/**
+ * load \c count samples every \c stride from \c start of the requested channels (i.e. hyperslab, only the window is read from file; see \c DAQreader )
+ * \param [in]  file_name file name (e.g. "data.nc")
+ * \param [in]  var_names variable names (i.e. channel subset)
+ * \param [out] channels data as physical values (i.e. packed data are unpacked)
+ * \param [in]  start first sample of the window
+ * \param [in]  count number of samples of each channel (i.e. after stride; clipped to the end of file)
+ * \param [in]  stride distance between two read samples (e.g. decimated overview)
+**/
+template<typename T> int load_data_window(std::string file_name,std::vector<std::string> var_names,CImgList<T> &channels,long start,long count,long stride=1)
+{
+  DAQreader<T> fi;
+  int error;
+  if((error=fi.open(file_name,var_names))) return error;
+  if((error=fi.window(start,count,stride))) return error;
+  fi.block_size=std::max(1L,count);
+  const long n=fi.next(channels);
+  return (n<0)?(int)n:0;
+}
+
+//! write recorded data and additional informations
+/**
+ * NetCDF file writer for recorded data regarding to a single time axis (in order to display it with time axis under ncview for example),
+ * data may be written at once or block by block (e.g. while acquiring, see \c DAQstream ), on a fixed or an unlimited \c time dimension
+ * (i.e. \c unlimited : blocks are appended as records, so that data written before a \c sync survives a crash).
+ * \note time axis is implicit (i.e. start time, sampling period and channel offsets as attributes, see \c DAQtime );
+ * legacy time variables (i.e. \c time and each channel with its corresponding time axis, with the channel name prefix) are written on request only.
+ *
+ * \code
+ *   DAQwriter<float,double> fo;
+ *   fo.open("data.nc",DAQdev,DAQdev.sample_number,false,"volt",0,DAQdev.maxdata,acqu_range_unit,-10.0f,10.0f,phys_range_unit);
+ *   fo.write(data_block,time_block);//as many times as needed
+ *   fo.close();
+ * \endcode
+ *
+ * \see save_data
+ **/
+template <typename Tdata, typename Ttime>
+class DAQwriter
+{
+ public:
+  CImgListNetCDF<Tdata> fod;///< data variables (e.g. "pressure", "hot_wire")
+  CImgListNetCDF<Ttime> fot;///< legacy time variables (e.g. "time","pressure__time","hot_wire__time")
+  DAQtime time;      ///< implicit time axis (i.e. written as attributes)
+  const RT_jitter *jitter;///< real time statistics to write as attributes (i.e. point acquisition, set before \c open ; none if NULL)
+  const DAQstats *stats;  ///< channel statistics to write as attributes (i.e. set before \c open , written again at \c close if updated while writing; none if NULL)
+  DAQpyramid *pyramid;    ///< envelope pyramid to write (i.e. set before \c open , variables created at \c open and written at \c close ; none if NULL)
+  bool time_axis;    ///< legacy time variables are written
+  bool unlimited;    ///< time is the unlimited dimension (i.e. records are appended while writing, set before \c open )
+  bool packed;       ///< raw levels are stored as packed physical values (i.e. \c scale_factor and \c add_offset attributes, set before \c open ; e.g. 16 bit levels in \c short )
+  long level_shift;  ///< subtracted from raw levels when widened to file type (i.e. levels above 32767 of \c packed 16 bit boards in \c short )
+  long sample_number;///< number of samples of each channel in the file (i.e. size of time dimension)
+  long sample_count; ///< number of samples of each channel already written
+  bool opened;       ///< file is opened
+  bool offset64;     ///< 64-bit offset file format (i.e. also set at \c open if data may reach the 2 GiB limit of classic format)
+  size_t header_slack;///< free bytes reserved in header at \c open (i.e. attributes written again at \c close never move data; \c unlimited file created without fill values, see \c CImgNetCDF::endNetCDFDefine )
+  long stats_count;  ///< number of samples in statistics written at \c open
+
+  //! constructor
+  DAQwriter()
+  {
+    time_axis=false;
+    unlimited=false;
+    packed=false;level_shift=0;
+    jitter=NULL;
+    stats=NULL;stats_count=0;
+    pyramid=NULL;
+    sample_number=sample_count=0;
+    opened=false;
+    header_slack=16384;offset64=false;
+  }
+
+  //! create file structure (i.e. dimension, variables and attributes)
+  /**
+   * \param [in] file_name file name (e.g. "data.nc")
+   * \param [in] DAQdev acquisition device (i.e. channel names, indexes and sampling rate)
+   * \param [in] samples number of samples of each channel in the file (i.e. expected number of records if \c unlimited )
+   * \param [in] with_time create legacy time variables (i.e. \c time and \c <channel>__time ; implicit time attributes are always written)
+   * \param [in] data_unit_name unit of data (e.g. "volt"; unit of unpacked data if \c packed )
+   **/
+  template <typename Tacqu, typename Tphys>
+  int open(std::string file_name,DAQdevice &DAQdev,long samples,bool with_time,
+    std::string data_unit_name,
+    Tacqu acqu_range_min, Tacqu acqu_range_max, std::string &acqu_range_unit,
+    Tphys phys_range_min, Tphys phys_range_max, std::string &phys_range_unit)
+  {
+    int error;
+    sample_number=samples;sample_count=0;
+    time_axis=with_time;
+    ///open file (shared between \c fod and \c fot ; no fill values only if \c unlimited , as records exist once written,
+    ///so that samples of a fixed dimension not written, e.g. stopped run, keep the fill value instead of reading as 0)
+    fod.fast_create=unlimited;fod.header_slack=header_slack;
+    ///- file format (i.e. 64-bit offset if data may be over 2 GiB; expected number of records if \c unlimited )
+    const double scan_bytes=(double)DAQdev.channel_index.size()*sizeof(Tdata)+(with_time?(DAQdev.channel_index.size()+1.0)*sizeof(Ttime):0.0);
+    const bool large=((double)samples*scan_bytes+(double)header_slack>2147483647.0);
+    fod.file_format=(offset64||large)?NcFile::Offset64Bits:NcFile::Classic;
+    if((error=fod.saveNetCDFFile((char*)file_name.c_str()))) return error;
+    NcFile *fp=fod.getNetCDFFile();
+    if(!fp->is_valid()) {std::cerr<<"Error: can not create \""<<file_name<<"\" file."<<std::endl;return NC_ERROR;}
+    fot.setNetCDFFile(fp);
+    ///create dimension (shared between \c fod and \c fot )
+    //!\note set both dimension and axis names of time to "time"
+    std::string dim_name("time");
+    NcDim *pd;
+    if(unlimited)
+    {//record variables (i.e. file grows block by block, no fill at creation)
+      if(!(pd=fp->add_dim(dim_name.c_str()))) return NC_ERROR;
+      std::vector<NcDim*> dims;
+      fod.setNetCDFDims(dims,pd);
+      fot.setNetCDFDims(dims,pd);
+    }
+    else
+    {
+      if(!(pd=fp->add_dim(dim_name.c_str(),sample_number))) return NC_ERROR;
+      std::vector<NcDim*> dims(1,pd);
+      fod.setNetCDFDims(dims);
+      fot.setNetCDFDims(dims);
+    }
+    ///create variables (and attributes)
+    ///- data variables
+    unsigned int channel_number=DAQdev.channel_index.size();
+    ////data attribute units
+    std::vector<std::string> data_unit_names(channel_number,data_unit_name);
+    ////create data variables
+    if((error=fod.addNetCDFVar(DAQdev.channel_name,data_unit_names))) return error;
+    ////data attribute channel indexes
+    std::string index_name("channel_index");
+    for(unsigned int c=0;c<channel_number;++c) (fod.pNCvars[c])->add_att(index_name.c_str(),DAQdev.channel_index[c]);
+    ////data attribute ranges
+    std::string range_name("physical_range");
+    Tphys phys_range[2];
+    phys_range[0]=phys_range_min;phys_range[1]=phys_range_max;
+    for(unsigned int c=0;c<channel_number;++c) (fod.pNCvars[c])->add_att(range_name.c_str(),2,phys_range);
+    range_name="physical_range_unit";
+    for(unsigned int c=0;c<channel_number;++c) (fod.pNCvars[c])->add_att(range_name.c_str(),(const char*)phys_range_unit.c_str());
+    range_name="acquisition_range";
+    Tacqu acqu_range[2];
+    acqu_range[0]=acqu_range_min;acqu_range[1]=acqu_range_max;
+    for(unsigned int c=0;c<channel_number;++c) (fod.pNCvars[c])->add_att(range_name.c_str(),2,acqu_range);
+    range_name="acquisition_range_unit";
+    for(unsigned int c=0;c<channel_number;++c) (fod.pNCvars[c])->add_att(range_name.c_str(),(const char*)acqu_range_unit.c_str());
+    ///- packing (i.e. CF convention: physical=scale_factor*stored+add_offset)
+    if(packed&&(error=save_packing(DAQdev))) return error;
+    ///- implicit time axis (i.e. global and data attributes)
+    if(time.offset.size()!=channel_number&&(error=time.assign(DAQdev))) return error;//may be set before (e.g. aligned boards, see \c DAQmulti )
+    if((error=time.save(fp,fod.pNCvars))) return error;
+    ///- legacy time variables (first for all data, then each data have it own time)
+    if(time_axis)
+    {
+      ////time names
+      std::vector<std::string> time_var_names;
+      time_var_names.push_back(dim_name);
+      for(unsigned int c=0;c<channel_number;++c) time_var_names.push_back(DAQdev.channel_name[c]+"__"+dim_name);
+      ////time units
+//! \todo add unit__long_name="second" refering to unit="s"
+      std::vector<std::string> time_unit_names(time_var_names.size(),"second");
+      ////create time variables
+      if((error=fot.addNetCDFVar(time_var_names,time_unit_names))) return error;
+    }
+    ///create global attributes
+    ///- sampling rate
+    fp->add_att("sampling_rate", DAQdev.sampling_rate);
+    ///- range
+//! \todo . save range: acquisition [min, max], physical [min, max] (as both global and local attribute)
+    fp->add_att("range_id", DAQdev.range_id);
+    ///- real time statistics (i.e. timing quality of point acquisition; none if not measured, e.g. without REAL_TIME)
+    if(jitter!=NULL&&jitter->ticks>0&&(error=save_jitter(fp,*jitter))) return error;
+    ///- channel statistics (i.e. space reserved while streaming)
+    if(stats!=NULL)
+    {
+      if((error=stats->save(fod.pNCvars))) return error;
+      stats_count=stats->count[0];
+    }
+    ///- envelope pyramid variables (i.e. fixed size, written at close)
+    if(pyramid!=NULL&&(error=pyramid->define(fp,data_unit_name))) return error;
+    ///leave define mode (i.e. ready to write data; header slack reserved, data section preallocated)
+    if((error=fod.endNetCDFDefine(unlimited?sample_number:0))) return error;
+    opened=true;
+    return 0;
+  }
+
+  //! write packing attributes of data variables
+  /**
+   * raw levels are stored shifted by \c level_shift (i.e. level 0 at -32768 for 16 bit boards in \c short ),
+   * so that \c scale_factor and \c add_offset give physical values from stored ones;
+   * \c valid_min and \c valid_max exclude levels 0 and \c maxdata (i.e. out of range, unpacked as NaN as in physical files, see \c unpack ),
+   * and \c _FillValue is level 0 (i.e. samples not written are unpacked as NaN too).
+   **/
+  int save_packing(const DAQdevice &DAQdev)
+  {
+    if((double)DAQdev.maxdata>(double)std::numeric_limits<Tdata>::max()-(double)std::numeric_limits<Tdata>::min())
+    {
+      std::cerr<<"Error: levels up to "<<DAQdev.maxdata<<" can not be packed in "<<NcTypeInfo<Tdata>::ncStr()<<"."<<std::endl;
+      return DIM_ERROR;
+    }
+    level_shift=((double)DAQdev.maxdata>(double)std::numeric_limits<Tdata>::max())?-(long)std::numeric_limits<Tdata>::min():0;
+    const float scale_factor=(DAQdev.comedirange->max-DAQdev.comedirange->min)/(double)DAQdev.maxdata;
+    const float add_offset=DAQdev.comedirange->min+scale_factor*(double)level_shift;
+    const Tdata valid_min=(Tdata)(1-level_shift),valid_max=(Tdata)((long)DAQdev.maxdata-1-level_shift),fill_value=(Tdata)(-level_shift);
+    for(unsigned int c=0;c<fod.pNCvars.size();++c)
+    {
+      if(!fod.pNCvars[c]->add_att("scale_factor",scale_factor)) return NC_ERROR;
+      if(!fod.pNCvars[c]->add_att("add_offset",add_offset)) return NC_ERROR;
+      if(!fod.pNCvars[c]->add_att("valid_min",valid_min)) return NC_ERROR;
+      if(!fod.pNCvars[c]->add_att("valid_max",valid_max)) return NC_ERROR;
+      if(!fod.pNCvars[c]->add_att("_FillValue",fill_value)) return NC_ERROR;
+    }
+    return 0;
+  }
+
+  //! write real time statistics as global attributes
+  /**
+   * number of ticks and overruns, and wakeup lateness min, mean, p99, p99.9 and max (in ns)
+   **/
+  static int save_jitter(NcFile *fp,const RT_jitter &j)
+  {
+    if(!fp->add_att("RT_interval",j.interval)) return NC_ERROR;
+    if(!fp->add_att("RT_ticks",(int)j.ticks)) return NC_ERROR;
+    if(!fp->add_att("RT_overruns",(int)j.overruns)) return NC_ERROR;
+    double lateness[5];
+    lateness[0]=j.min;lateness[1]=j.mean();lateness[2]=j.percentile(99.0);lateness[3]=j.percentile(99.9);lateness[4]=j.max;
+    if(!fp->add_att("RT_lateness",5,lateness)) return NC_ERROR;
+    if(!fp->add_att("RT_lateness_statistics","min mean p99 p99.9 max")) return NC_ERROR;
+    if(!fp->add_att("RT_lateness_unit","nanosecond")) return NC_ERROR;
+    return 0;
+  }
+
+  //! write a block of data (and its time) after the previous one
+  /**
+   * \param [in] data data block (i.e. one image per channel, all with the same width)
+   * \param [in] time time block (i.e. one image per channel, same size as data; not used if file has no time variables)
+   **/
+  int write(cimg_library::CImgList<Tdata> &data,cimg_library::CImgList<Ttime> &time)
+  {
+    int error;
+    if(!opened) return CODE_ERROR;
+    if(data.is_empty()) return 0;
+    ///- data
+    if((error=fod.addNetCDFDataBlock(data,sample_count))) return error;
+    ///- time
+    if((error=write_time(time,data.size()))) return error;
+    sample_count+=data[0].width();
+    return 0;
+  }
+
+  //! write a block of raw data (and its time) after the previous one
+  /**
+   * raw samples (e.g. \c sampl_t ) are converted to file type by the NetCDF writer in one pass (see \c CImgListNetCDF::putNetCDFDataBlock ),
+   * or widened chunk by chunk if shifted by \c level_shift (e.g. \c packed levels; i.e. only a chunk is allocated in file type)
+   * \param [in] data data block (i.e. one image per channel, all with the same width)
+   * \param [in] time time block (i.e. one image per channel, same size as data; not used if file has no time variables)
+   * \param [in] chunk_size number of samples of each channel in a chunk
+   **/
+  template <typename Traw>
+  int write(cimg_library::CImgList<Traw> &data,cimg_library::CImgList<Ttime> &time,const int chunk_size=65536)
+  {
+    int error;
+    if(data.is_empty()) return 0;
+    if(level_shift==0)
+    {//memory and file types independent (i.e. no copy in file type)
+      if(!opened) return CODE_ERROR;
+      if((error=fod.putNetCDFDataBlock(data,sample_count))) return error;
+      if((error=write_time(time,data.size()))) return error;
+      sample_count+=data[0].width();
+      return 0;
+    }
+    const int width=data[0].width();
+    cimg_library::CImgList<Tdata> data_chunk;
+    cimg_library::CImgList<Ttime> time_chunk;
+    for(int s=0;s<width;s+=chunk_size)
+    {
+      const int n=std::min(chunk_size,width-s);
+      data_chunk.assign(data.size(),n);
+      cimglist_for(data,c) {const Traw *p=data[c].data(s);Tdata *q=data_chunk[c].data();const long shift=level_shift;for(int i=0;i<n;++i) q[i]=(Tdata)((long)p[i]-shift);}
+      if(time_axis)
+      {
+        if(time.size()!=data.size()) return DIM_ERROR;
+        time_chunk.assign(time.size(),n);
+        cimglist_for(time,c) std::memcpy(time_chunk[c].data(),time[c].data(s),n*sizeof(Ttime));
+      }
+      if((error=write(data_chunk,time_chunk))) return error;
+    }
+    return 0;
+  }
+
+  //! write a block of time (i.e. first for all data, then each data have it own time; nothing if no time variables)
+  int write_time(cimg_library::CImgList<Ttime> &time,unsigned int channel_number)
+  {
+    if(!time_axis) return 0;
+    if(time.size()!=channel_number) return DIM_ERROR;
+    int error;
+    for(unsigned int c=0;c<fot.pNCvars.size();++c)
+    {
+      fot.pNCvar=fot.pNCvars[c];
+      error=fot.CImgNetCDF<Ttime>::addNetCDFDataBlock(time[(c==0)?0:c-1],sample_count);
+      fot.pNCvar=NULL;
+      if(error) return error;
+    }
+    return 0;
+  }
+
+  //! flush written data to disk
+  int sync()
+  {
+    if(!opened) return CODE_ERROR;
+    return (fod.getNetCDFFile()->sync())?0:NC_ERROR;
+  }
+
+  //! close file
+  int close()
+  {
+    if(!opened) return 0;
+    opened=false;
+    if(sample_count!=sample_number) std::cerr<<"Warning: "<<sample_count<<" samples written over "<<sample_number<<" samples per channel."<<std::endl;
+    ///- envelope pyramid (i.e. last bins ended)
+    if(pyramid!=NULL&&pyramid->save()) std::cerr<<"Warning: can not write envelope pyramid."<<std::endl;
+    ///- final channel statistics (i.e. same attribute sizes, so that header does not grow)
+    if(stats!=NULL&&stats->count[0]!=stats_count&&stats->save(fod.pNCvars)) std::cerr<<"Warning: can not write channel statistics."<<std::endl;
+    return (fod.getNetCDFFile()->close())?0:NC_ERROR;
+  }
+};//DAQwriter class
+
+//! save recorded data with a given writer (i.e. file type, see \c save_data )
+template <typename Tfile, typename Traw, typename Tdata, typename Ttime, typename Tacqu>
+int save_data(DAQwriter<Tfile,Ttime> &fo,
+  std::string file_name,
+  cimg_library::CImgList<Traw>& data,
+  cimg_library::CImgList<Ttime>& time,
+  DAQdevice &DAQdev,
+  std::string data_unit_name,
+  Tacqu acqu_range_min, Tacqu acqu_range_max, std::string &acqu_range_unit,
+  Tdata phys_range_min, Tdata phys_range_max, std::string &phys_range_unit,
+  const RT_jitter *jitter,
+  const DAQstats *stats,
+  DAQpyramid *pyramid
+)
+{
+  int error;
+  fo.jitter=jitter;
+  fo.stats=stats;
+  fo.pyramid=pyramid;
+  ///create file structure
+  if((error=fo.open(file_name,DAQdev,data[0].width(),!time.is_empty(),data_unit_name,
+    acqu_range_min,acqu_range_max,acqu_range_unit,phys_range_min,phys_range_max,phys_range_unit))) return error;
+  ///write data
+  if((error=fo.write(data,time))) return error;
+  return fo.close();
+}
+
 //! save recorded data and additional informations
 /**
  * save all recoreded data regarding to a single time axis (in order to display it with time axis under ncview for example)
- * \note each recorded channel is also written with its corresponding time axis (especially with the channel name prefix)
+ * \note time axis is implicit (see \c DAQtime ), legacy time variables are written only if \c time is not empty
  *
  * @param fo 
- * @param data 
- * @param time 
+ * @param data (raw samples, e.g. \c sampl_t , are widened to file type given by physical range type)
+ * @param time (time variables are not written if empty)
  * @param DAQdev
  * @param data_unit_name 
+ * @param jitter real time statistics (i.e. point acquisition; not written if NULL or not measured)
+ * @param stats channel statistics (not written if NULL)
+ * @param pyramid envelope pyramid (not written if NULL)
+ * @param packed raw levels stored in \c short with \c scale_factor and \c add_offset (i.e. \c data being raw levels, see \c DAQwriter::packed )
  *
  * @return 
+ * \see DAQwriter
  */
-//! \todo [medium] make NetCDF file object version (\c  save_data(NcFile*fp,... ) and its overload with file name
-template <typename Tdata, typename Ttime, typename Tacqu>
+template <typename Traw, typename Tdata, typename Ttime, typename Tacqu>
 int save_data(
   std::string file_name,
-  cimg_library::CImgList<Tdata>& data,
+  cimg_library::CImgList<Traw>& data,
   cimg_library::CImgList<Ttime>& time,
-  DAQdevice DAQdev,
+  DAQdevice &DAQdev,
   std::string data_unit_name,
   Tacqu acqu_range_min, Tacqu acqu_range_max, std::string &acqu_range_unit,
-  Tdata phys_range_min, Tdata phys_range_max, std::string &phys_range_unit
+  Tdata phys_range_min, Tdata phys_range_max, std::string &phys_range_unit,
+  const RT_jitter *jitter=NULL,
+  const DAQstats *stats=NULL,
+  DAQpyramid *pyramid=NULL,
+  bool packed=false
 )
 {
-//std::cerr<<__FILE__<<"/"<<__func__<<"(\""<<file_name<<"\",...)\n"<<std::flush;
-//data.print("data");
-//time.print("time");
-  ///open file (shared between \c fod and \c fot )
-  //NetCDF file objects for both data and time
-  CImgListNetCDF<Tdata> fod;//e.g. "pressure", "hot_wire"
-  CImgListNetCDF<Ttime> fot;//e.g. "time","pressure__time","hot_wire__time"
-  //open NetCDF file
-  fod.saveNetCDFFile((char*)file_name.c_str());
-  //set NetCDF file object for time
-  fot.setNetCDFFile(fod.getNetCDFFile());
-  ///create dimension (shared between \c fod and \c fot )
-  //std::cerr<<"create dimension\n"<<std::flush;
-  //dimension name (only one here, as 1D data)
-  std::vector<std::string> dim_names;
-  //!\note set both dimension and axis names of time to "time"
-  dim_names.push_back("time");
-  //create dimension
-  fod.addNetCDFDims(data,dim_names);
-  //set dimension for time
-  fot.setNetCDFDims(fod.vpNCDim,fod.pNCDimt);
-  ///create variables (and attributes)
-  //std::cerr<<"create variables\n"<<std::flush;
-  NcFile *fp=fod.getNetCDFFile();
-  ///- data variables
-  ////data attribute units
-  std::vector<std::string> data_unit_names;
-  cimglist_for(data,c) data_unit_names.push_back(data_unit_name);
-  ////create data variables
-  fod.addNetCDFVar(data,DAQdev.channel_name,data_unit_names);
-  ////data attribute channel indexes
-  std::string index_name("channel_index");
-  cimglist_for(data,c) (fod.pNCvars[c])->add_att(index_name.c_str(),DAQdev.channel_index[c]);
-  ////data attribute ranges
-  std::string range_name("physical_range");
-  Tdata phys_range[2];
-  phys_range[0]=phys_range_min;phys_range[1]=phys_range_max;
-  cimglist_for(data,c) (fod.pNCvars[c])->add_att(range_name.c_str(),2,phys_range);
-  range_name="physical_range_unit";
-  cimglist_for(data,c) (fod.pNCvars[c])->add_att(range_name.c_str(),(const char*)phys_range_unit.c_str());
-  range_name="acquisition_range";
-  Tacqu acqu_range[2];
-  acqu_range[0]=acqu_range_min;acqu_range[1]=acqu_range_max;
-  cimglist_for(data,c) (fod.pNCvars[c])->add_att(range_name.c_str(),2,acqu_range);
-  range_name="acquisition_range_unit";
-  cimglist_for(data,c) (fod.pNCvars[c])->add_att(range_name.c_str(),(const char*)acqu_range_unit.c_str());
-  ///- time variables (first for all data, then each data have it own time)
-  ////time data
-  cimg_library::CImgList<Ttime> store_time(time.size()+1);
-  store_time[0]=time[0];
-  cimglist_for(time,c) store_time[c+1]=time[c];
-  ////time names
-  std::vector<std::string> time_var_names;
-  time_var_names.push_back(dim_names[0]);
-  cimglist_for(data,c) time_var_names.push_back(DAQdev.channel_name[c]+"__"+dim_names[0]);
-  ////time units
-//! \todo add unit__long_name="second" refering to unit="s"
-  std::vector<std::string> time_unit_names(store_time.size(),"second");
-  ////create data variables
-  fot.addNetCDFVar(store_time,time_var_names,time_unit_names);
-  ///create global attributes
-//std::cerr<<"create globals\n"<<std::flush;
-  ///- sampling rate
-  fp->add_att("sampling_rate", DAQdev.sampling_rate);
-  ///- sampling rate
-//! \todo . save range: acquisition [min, max], physical [min, max] (as both global and local attribute)
-  fp->add_att("range_id", DAQdev.range_id);
-  ///write data
-//std::cerr<<"create data\n"<<std::flush;
-  ///- data
-  fod.addNetCDFData(data,0);
-  ///- time
-  fot.addNetCDFData(store_time,0);
-  return 0;
+  if(data.is_empty()) return DIM_ERROR;
+  if(packed)
+  {//raw levels in 16 bit (i.e. half size of float, no conversion)
+    DAQwriter<short,Ttime> fo;
+    fo.packed=true;
+    return save_data(fo,file_name,data,time,DAQdev,data_unit_name,acqu_range_min,acqu_range_max,acqu_range_unit,phys_range_min,phys_range_max,phys_range_unit,jitter,stats,pyramid);
+  }
+  DAQwriter<Tdata,Ttime> fo;
+  return save_data(fo,file_name,data,time,DAQdev,data_unit_name,acqu_range_min,acqu_range_max,acqu_range_unit,phys_range_min,phys_range_max,phys_range_unit,jitter,stats,pyramid);
 }
 
-
 #endif// DAQ_DATA
 
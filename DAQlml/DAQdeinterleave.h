@@ -0,0 +1,327 @@
+#ifndef DAQ_DEINTERLEAVE
+#define DAQ_DEINTERLEAVE
+
+//! de-interleave engine: comedi scans to channel planes
+/**
+ * The comedi buffer contains interleaved scans (i.e. \c c0,c1,...,cN,c0,c1,...), this engine transposes them into channel planes (i.e. one 1D image per channel).
+ * \li specialized SIMD paths for 1, 2, 4, 8 and 16 channels (SSE2, and AVX2 if the CPU supports it at run time), scalar path otherwise
+ * \li the unread region of the mapped ring buffer is handled as at most two contiguous spans around the wrap (see \c deinterleave_ring )
+ *
+ * \code
+ *   sampl_t *planes[16];for(c...) planes[c]=data[c].data(sample_count);
+ *   deinterleave(scans_ptr,scan_number,channel_number,planes);
+ * \endcode
+ * \see sample_data_buffer DAQbench.cpp
+ **/
+
+#include <cstring>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__GNUC__) && ( (__GNUC__>4) || ((__GNUC__==4)&&(__GNUC_MINOR__>=9)) ) && !defined(DAQ_NO_AVX2)
+#include <immintrin.h>
+#define DAQ_USE_AVX2
+#endif
+#endif
+
+//! number of scans in a tile when de-interleaving to a type different from the raw one
+#define DEINTERLEAVE_TILE 256
+
+//! scalar de-interleave (any number of channels)
+/**
+ * \param [in] src interleaved scans (i.e. \c scans*channels samples)
+ * \param [in] scans number of scans
+ * \param [in] channels number of channels
+ * \param [out] dst channel planes (i.e. \c channels pointers of at least \c scans samples)
+ **/
+template<typename Tsrc,typename Tdst>
+inline void deinterleave_scalar(const Tsrc *src,long scans,int channels,Tdst **dst)
+{
+  for(int c=0;c<channels;++c)
+  {
+    const Tsrc *p=src+c;
+    Tdst *q=dst[c];
+    for(long s=0;s<scans;++s,p+=channels) q[s]=(Tdst)*p;
+  }
+}
+
+#if defined(__SSE2__)
+//! SSE2 de-interleave of 16 bit samples for 2, 4, 8 or 16 channels (8 scans per iteration)
+/**
+ * \return number of scans processed (i.e. multiple of 8, tail is left to scalar path)
+ **/
+inline long deinterleave_sse2(const unsigned short *src,long scans,int channels,unsigned short **dst)
+{
+  long s=0;
+  switch(channels)
+  {
+  case 2:
+    for(;s+8<=scans;s+=8)
+    {//3 unpack levels: 8 scans from 2 vectors
+      const __m128i *p=(const __m128i*)(src+2*s);
+      __m128i a=_mm_loadu_si128(p),b=_mm_loadu_si128(p+1);
+      __m128i x=_mm_unpacklo_epi16(a,b),y=_mm_unpackhi_epi16(a,b);
+      __m128i t0=_mm_unpacklo_epi16(x,y),t1=_mm_unpackhi_epi16(x,y);
+      _mm_storeu_si128((__m128i*)(dst[0]+s),_mm_unpacklo_epi16(t0,t1));
+      _mm_storeu_si128((__m128i*)(dst[1]+s),_mm_unpackhi_epi16(t0,t1));
+    }
+    break;
+  case 4:
+    for(;s+8<=scans;s+=8)
+    {//2 unpack levels per 4 scans, then 64 bit halves
+      const __m128i *p=(const __m128i*)(src+4*s);
+      __m128i a=_mm_loadu_si128(p),b=_mm_loadu_si128(p+1),c=_mm_loadu_si128(p+2),d=_mm_loadu_si128(p+3);
+      __m128i x0=_mm_unpacklo_epi16(a,b),x1=_mm_unpackhi_epi16(a,b);
+      __m128i y0=_mm_unpacklo_epi16(c,d),y1=_mm_unpackhi_epi16(c,d);
+      __m128i u0=_mm_unpacklo_epi16(x0,x1),u1=_mm_unpackhi_epi16(x0,x1);//scans 0..3: [c0|c1], [c2|c3]
+      __m128i v0=_mm_unpacklo_epi16(y0,y1),v1=_mm_unpackhi_epi16(y0,y1);//scans 4..7
+      _mm_storeu_si128((__m128i*)(dst[0]+s),_mm_unpacklo_epi64(u0,v0));
+      _mm_storeu_si128((__m128i*)(dst[1]+s),_mm_unpackhi_epi64(u0,v0));
+      _mm_storeu_si128((__m128i*)(dst[2]+s),_mm_unpacklo_epi64(u1,v1));
+      _mm_storeu_si128((__m128i*)(dst[3]+s),_mm_unpackhi_epi64(u1,v1));
+    }
+    break;
+  case 8:
+  case 16:
+    for(;s+8<=scans;s+=8)
+    {//8x8 transpose (twice for 16 channels)
+      for(int h=0;h<channels;h+=8)
+      {
+        const unsigned short *p=src+channels*s+h;
+        __m128i r0=_mm_loadu_si128((const __m128i*)(p));
+        __m128i r1=_mm_loadu_si128((const __m128i*)(p+channels));
+        __m128i r2=_mm_loadu_si128((const __m128i*)(p+2*channels));
+        __m128i r3=_mm_loadu_si128((const __m128i*)(p+3*channels));
+        __m128i r4=_mm_loadu_si128((const __m128i*)(p+4*channels));
+        __m128i r5=_mm_loadu_si128((const __m128i*)(p+5*channels));
+        __m128i r6=_mm_loadu_si128((const __m128i*)(p+6*channels));
+        __m128i r7=_mm_loadu_si128((const __m128i*)(p+7*channels));
+        __m128i a0=_mm_unpacklo_epi16(r0,r1),a1=_mm_unpackhi_epi16(r0,r1);
+        __m128i a2=_mm_unpacklo_epi16(r2,r3),a3=_mm_unpackhi_epi16(r2,r3);
+        __m128i a4=_mm_unpacklo_epi16(r4,r5),a5=_mm_unpackhi_epi16(r4,r5);
+        __m128i a6=_mm_unpacklo_epi16(r6,r7),a7=_mm_unpackhi_epi16(r6,r7);
+        __m128i b0=_mm_unpacklo_epi32(a0,a2),b1=_mm_unpackhi_epi32(a0,a2);
+        __m128i b2=_mm_unpacklo_epi32(a1,a3),b3=_mm_unpackhi_epi32(a1,a3);
+        __m128i b4=_mm_unpacklo_epi32(a4,a6),b5=_mm_unpackhi_epi32(a4,a6);
+        __m128i b6=_mm_unpacklo_epi32(a5,a7),b7=_mm_unpackhi_epi32(a5,a7);
+        _mm_storeu_si128((__m128i*)(dst[h  ]+s),_mm_unpacklo_epi64(b0,b4));
+        _mm_storeu_si128((__m128i*)(dst[h+1]+s),_mm_unpackhi_epi64(b0,b4));
+        _mm_storeu_si128((__m128i*)(dst[h+2]+s),_mm_unpacklo_epi64(b1,b5));
+        _mm_storeu_si128((__m128i*)(dst[h+3]+s),_mm_unpackhi_epi64(b1,b5));
+        _mm_storeu_si128((__m128i*)(dst[h+4]+s),_mm_unpacklo_epi64(b2,b6));
+        _mm_storeu_si128((__m128i*)(dst[h+5]+s),_mm_unpackhi_epi64(b2,b6));
+        _mm_storeu_si128((__m128i*)(dst[h+6]+s),_mm_unpacklo_epi64(b3,b7));
+        _mm_storeu_si128((__m128i*)(dst[h+7]+s),_mm_unpackhi_epi64(b3,b7));
+      }
+    }
+    break;
+  }//switch
+  return s;
+}
+#endif //__SSE2__
+
+#ifdef DAQ_USE_AVX2
+//! load 2 unaligned 128 bit vectors in the low and high lanes
+#define DAQ_LOAD2X128(lo,hi) _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(lo))),_mm_loadu_si128((const __m128i*)(hi)),1)
+
+//! AVX2 de-interleave of 16 bit samples for 2, 4, 8 or 16 channels (16 scans per iteration)
+/**
+ * same algorithm as \c deinterleave_sse2 within each 128 bit lane: low lane for scans 0..7, high lane for scans 8..15,
+ * so that each output vector is 16 contiguous samples of a channel.
+ * \return number of scans processed (i.e. multiple of 16, tail is left to SSE2/scalar path)
+ **/
+__attribute__((target("avx2")))
+inline long deinterleave_avx2(const unsigned short *src,long scans,int channels,unsigned short **dst)
+{
+  long s=0;
+  switch(channels)
+  {
+  case 2:
+    for(;s+16<=scans;s+=16)
+    {
+      const unsigned short *p=src+2*s;
+      __m256i a=DAQ_LOAD2X128(p,p+16),b=DAQ_LOAD2X128(p+8,p+24);
+      __m256i x=_mm256_unpacklo_epi16(a,b),y=_mm256_unpackhi_epi16(a,b);
+      __m256i t0=_mm256_unpacklo_epi16(x,y),t1=_mm256_unpackhi_epi16(x,y);
+      _mm256_storeu_si256((__m256i*)(dst[0]+s),_mm256_unpacklo_epi16(t0,t1));
+      _mm256_storeu_si256((__m256i*)(dst[1]+s),_mm256_unpackhi_epi16(t0,t1));
+    }
+    break;
+  case 4:
+    for(;s+16<=scans;s+=16)
+    {
+      const unsigned short *p=src+4*s;
+      __m256i a=DAQ_LOAD2X128(p,p+32),b=DAQ_LOAD2X128(p+8,p+40),c=DAQ_LOAD2X128(p+16,p+48),d=DAQ_LOAD2X128(p+24,p+56);
+      __m256i x0=_mm256_unpacklo_epi16(a,b),x1=_mm256_unpackhi_epi16(a,b);
+      __m256i y0=_mm256_unpacklo_epi16(c,d),y1=_mm256_unpackhi_epi16(c,d);
+      __m256i u0=_mm256_unpacklo_epi16(x0,x1),u1=_mm256_unpackhi_epi16(x0,x1);
+      __m256i v0=_mm256_unpacklo_epi16(y0,y1),v1=_mm256_unpackhi_epi16(y0,y1);
+      _mm256_storeu_si256((__m256i*)(dst[0]+s),_mm256_unpacklo_epi64(u0,v0));
+      _mm256_storeu_si256((__m256i*)(dst[1]+s),_mm256_unpackhi_epi64(u0,v0));
+      _mm256_storeu_si256((__m256i*)(dst[2]+s),_mm256_unpacklo_epi64(u1,v1));
+      _mm256_storeu_si256((__m256i*)(dst[3]+s),_mm256_unpackhi_epi64(u1,v1));
+    }
+    break;
+  case 8:
+  case 16:
+    for(;s+16<=scans;s+=16)
+    {
+      for(int h=0;h<channels;h+=8)
+      {
+        const unsigned short *p=src+channels*s+h;
+        const long n=8*channels;//offset of scan 8
+        __m256i r0=DAQ_LOAD2X128(p,p+n);
+        __m256i r1=DAQ_LOAD2X128(p+channels,p+channels+n);
+        __m256i r2=DAQ_LOAD2X128(p+2*channels,p+2*channels+n);
+        __m256i r3=DAQ_LOAD2X128(p+3*channels,p+3*channels+n);
+        __m256i r4=DAQ_LOAD2X128(p+4*channels,p+4*channels+n);
+        __m256i r5=DAQ_LOAD2X128(p+5*channels,p+5*channels+n);
+        __m256i r6=DAQ_LOAD2X128(p+6*channels,p+6*channels+n);
+        __m256i r7=DAQ_LOAD2X128(p+7*channels,p+7*channels+n);
+        __m256i a0=_mm256_unpacklo_epi16(r0,r1),a1=_mm256_unpackhi_epi16(r0,r1);
+        __m256i a2=_mm256_unpacklo_epi16(r2,r3),a3=_mm256_unpackhi_epi16(r2,r3);
+        __m256i a4=_mm256_unpacklo_epi16(r4,r5),a5=_mm256_unpackhi_epi16(r4,r5);
+        __m256i a6=_mm256_unpacklo_epi16(r6,r7),a7=_mm256_unpackhi_epi16(r6,r7);
+        __m256i b0=_mm256_unpacklo_epi32(a0,a2),b1=_mm256_unpackhi_epi32(a0,a2);
+        __m256i b2=_mm256_unpacklo_epi32(a1,a3),b3=_mm256_unpackhi_epi32(a1,a3);
+        __m256i b4=_mm256_unpacklo_epi32(a4,a6),b5=_mm256_unpackhi_epi32(a4,a6);
+        __m256i b6=_mm256_unpacklo_epi32(a5,a7),b7=_mm256_unpackhi_epi32(a5,a7);
+        _mm256_storeu_si256((__m256i*)(dst[h  ]+s),_mm256_unpacklo_epi64(b0,b4));
+        _mm256_storeu_si256((__m256i*)(dst[h+1]+s),_mm256_unpackhi_epi64(b0,b4));
+        _mm256_storeu_si256((__m256i*)(dst[h+2]+s),_mm256_unpacklo_epi64(b1,b5));
+        _mm256_storeu_si256((__m256i*)(dst[h+3]+s),_mm256_unpackhi_epi64(b1,b5));
+        _mm256_storeu_si256((__m256i*)(dst[h+4]+s),_mm256_unpacklo_epi64(b2,b6));
+        _mm256_storeu_si256((__m256i*)(dst[h+5]+s),_mm256_unpackhi_epi64(b2,b6));
+        _mm256_storeu_si256((__m256i*)(dst[h+6]+s),_mm256_unpacklo_epi64(b3,b7));
+        _mm256_storeu_si256((__m256i*)(dst[h+7]+s),_mm256_unpackhi_epi64(b3,b7));
+      }
+    }
+    break;
+  }//switch
+  return s;
+}
+#undef DAQ_LOAD2X128
+
+//! AVX2 availability at run time (checked once)
+inline bool deinterleave_has_avx2()
+{
+  static const bool avx2=__builtin_cpu_supports("avx2");
+  return avx2;
+}
+#endif //DAQ_USE_AVX2
+
+//! de-interleave 16 bit samples to 16 bit channel planes
+/**
+ * fastest available path: AVX2 (at run time), SSE2, then scalar for other channel numbers and tail scans.
+ * \param [in] src interleaved scans (i.e. \c scans*channels samples)
+ * \param [in] scans number of scans
+ * \param [in] channels number of channels
+ * \param [out] dst channel planes (i.e. \c channels pointers of at least \c scans samples)
+ **/
+inline void deinterleave(const unsigned short *src,long scans,int channels,unsigned short **dst)
+{
+  if(channels==1) {memcpy(dst[0],src,scans*sizeof(unsigned short));return;}
+  long s=0;
+  if(channels==2||channels==4||channels==8||channels==16)
+  {
+#ifdef DAQ_USE_AVX2
+    if(deinterleave_has_avx2()) s=deinterleave_avx2(src,scans,channels,dst);
+#endif
+#if defined(__SSE2__)
+    if(s<scans)
+    {
+      unsigned short *d[16];
+      for(int c=0;c<channels;++c) d[c]=dst[c]+s;
+      s+=deinterleave_sse2(src+s*channels,scans-s,channels,d);
+    }
+#endif
+  }
+  if(s<scans)
+  {//tail (or any other number of channels)
+    unsigned short *d[256];
+    for(int c=0;c<channels;++c) d[c]=dst[c]+s;
+    deinterleave_scalar(src+s*channels,scans-s,channels,d);
+  }
+}
+
+//! de-interleave 16 bit samples to channel planes of any type
+/**
+ * 16 bit planes are computed by tiles of \c DEINTERLEAVE_TILE scans (i.e. in cache), then copied to the destination type (e.g. \c int or \c float ).
+ * \see deinterleave(const unsigned short*,long,int,unsigned short**)
+ **/
+template<typename Tdst>
+inline void deinterleave(const unsigned short *src,long scans,int channels,Tdst **dst)
+{
+  if(channels>16) {deinterleave_scalar(src,scans,channels,dst);return;}
+  unsigned short tile[16][DEINTERLEAVE_TILE];
+  unsigned short *t[16];
+  for(int c=0;c<channels;++c) t[c]=tile[c];
+  for(long s=0;s<scans;s+=DEINTERLEAVE_TILE)
+  {
+    const long n=std::min((long)DEINTERLEAVE_TILE,scans-s);
+    deinterleave(src+s*channels,n,channels,t);
+    for(int c=0;c<channels;++c)
+    {
+      Tdst *q=dst[c]+s;
+      const unsigned short *p=tile[c];
+      for(long i=0;i<n;++i) q[i]=(Tdst)p[i];
+    }
+  }
+}
+
+//! de-interleave 32 bit samples (e.g. \c lsampl_t boards) to channel planes
+template<typename Tdst>
+inline void deinterleave(const unsigned int *src,long scans,int channels,Tdst **dst)
+{
+  deinterleave_scalar(src,scans,channels,dst);
+}
+
+//! de-interleave the unread region of the mapped ring buffer
+/**
+ * the unread region \c [offset,offset+bytes) of the mapped buffer is at most two contiguous spans around the buffer wrap:
+ * each span is de-interleaved at once, and a scan split by the wrap is gathered apart.
+ * \param [in] map mapped comedi buffer
+ * \param [in] size size of mapped buffer (in byte)
+ * \param [in] offset read position in mapped buffer (in byte)
+ * \param [in] scans number of scans to read (i.e. whole scans of the unread region)
+ * \param [in] channels number of channels
+ * \param [out] dst channel planes (i.e. \c channels pointers of at least \c scans samples)
+ * \return new read position in mapped buffer (in byte)
+ **/
+template<typename Traw,typename Tdst>
+inline int deinterleave_ring(const void *map,int size,int offset,long scans,int channels,Tdst **dst)
+{
+  const char *buffer=(const char*)map;
+  const int scan_bytes=channels*sizeof(Traw);
+  Tdst *d[256];
+  for(int c=0;c<channels;++c) d[c]=dst[c];
+  while(scans>0)
+  {
+    ///- first span: whole scans up to the end of the buffer (or all requested scans)
+    long n=std::min(scans,(long)((size-offset)/scan_bytes));
+    if(n>0)
+    {
+      deinterleave((const Traw*)(buffer+offset),n,channels,d);
+      for(int c=0;c<channels;++c) d[c]+=n;
+      scans-=n;
+      offset=(offset+n*scan_bytes)%size;
+    }
+    if(scans==0) break;
+    ///- scan split by the wrap (if any), then loop for the second span from buffer start
+    if(offset+scan_bytes>size)
+    {
+      Traw scan[256];
+      const int tail=size-offset;
+      memcpy(scan,buffer+offset,tail);
+      memcpy((char*)scan+tail,buffer,scan_bytes-tail);
+      deinterleave((const Traw*)scan,1,channels,d);
+      for(int c=0;c<channels;++c) d[c]+=1;
+      --scans;
+      offset=scan_bytes-tail;
+    }
+  }//span loop
+  return offset;
+}
+
+#endif// DAQ_DEINTERLEAVE
+
@@ -8,100 +8,203 @@
 
 //! read the data from the mapped buffer
 /** 
+ * the unread region of the mapped buffer is de-interleaved at once into the channel planes of \c data (i.e. at most two contiguous spans around the buffer wrap, see \c deinterleave_ring ).
+ * \note \c T is the sample type of the board (i.e. \c sampl_t or \c lsampl_t )
  * 
  * @param data  
  * @param map 
  * @param DAQdev
+ * @param wakeup wait for data when the buffer is empty (i.e. poll or backoff)
+ * @param stats channel statistics, updated with each de-interleaved part (i.e. not computed if NULL)
+ * @param pyramid envelope pyramid, updated with each de-interleaved part (i.e. not computed if NULL)
  * @param control 
  * 
  * @return 
+ * \see deinterleave_ring DAQwakeup
  */
 //! \todo remove double pointer (i.e. **) to at least single pointer (i.e. * or may be &)
 template<typename T>
-inline int sample_data_buffer(cimg_library::CImgList<T>& data, void *map, DAQdevice& DAQdev, bool control=false)
+inline int sample_data_buffer(cimg_library::CImgList<T>& data, void *map, DAQdevice& DAQdev, DAQwakeup& wakeup, DAQstats *stats=NULL, DAQpyramid *pyramid=NULL, bool control=false)
 {
   std::cerr<<__func__<<"\n"<<std::flush;
   int ret; // return of function
-  int front = 0; // address of mapped buffer
-  int back = 0;  //
-  int sample_count = 0; // number of samples stored in one channel
-  int sampling_complete_flag=0;
+  int offset = 0; // read position in mapped buffer (in byte)
+  long sample_count = 0; // number of samples stored in one channel
 
   int size=DAQdev.bufsize;
-  int sample_number=DAQdev.sample_number;
+  long sample_number=DAQdev.sample_number;
   int channel_number=DAQdev.channel_index.size();
+  const int scan_bytes=channel_number*sizeof(T); // size of one scan (in byte)
+  T *plane[256]; // write position in each channel
 
-  std::cout<<"LOOP_USLEEP_TIME = "<<LOOP_USLEEP_TIME<<std::endl;
+  wakeup.init(DAQdev);
 
   // sampling loop begins
-  while(1)
+  while(sample_count<sample_number)
     {
-      // get the number of bytes available in the streaming buffer.
-      front += comedi_get_buffer_contents(DAQdev.dev, DAQdev.subdevice);
-      
-      // when the buffer is not updated, wait time specified by LOOP_USLEEP_TIME
-      if(front == back)
+      // get the number of unread bytes in the streaming buffer (whole scans only)
+      int available = DAQdev.backend->get_buffer_contents(DAQdev.subdevice);
+      if(available<0){DAQdev.backend->perror("comedi_get_buffer_contents"); break;}
+      long scans = std::min((long)(available/scan_bytes),sample_number-sample_count);
+      // when the buffer is not updated, wait for data (i.e. blocking poll or backoff sleep)
+      if(scans==0)
 	{
-	  usleep(LOOP_USLEEP_TIME);
+	  wakeup.wait();
 	  continue;
 	}
-      // read available buffer (from back to front)
-      int col = 0;
-      for(int i = back; i < front; i += sizeof(sampl_t))
+      wakeup.data(available);
+      // de-interleave available scans (from back to front)
+      if (DAQdev.verbose)std::cout<<"back="<<offset<<",scans="<<scans<<",sample_count="<<sample_count<<std::endl;
+      for(int c=0;c<channel_number;++c) plane[c]=data[c].data(sample_count);
+      offset=deinterleave_ring<T>(map,size,offset,scans,channel_number,plane);
+      if(stats!=NULL) for(int c=0;c<channel_number;++c) stats->add(plane[c],scans,c);
+      if(pyramid!=NULL) for(int c=0;c<channel_number;++c) pyramid->add(plane[c],scans,c);
+      sample_count+=scans;
+
+      // mark the position where the program has already read. refer to the comedi lib manual for further info
+      ret = DAQdev.backend->mark_buffer_read(DAQdev.subdevice, scans*scan_bytes);
+      if(ret < 0){DAQdev.backend->perror("comedi_mark_buffer_read"); break;}
+    }//sampling loop
+  wakeup.print(std::cout);
+
+  return 0;
+}
+
+//! copy the mapped buffer into a ring of blocks
+/**
+ * acquisition side of streaming (see \c sample_data_stream ): interleaved scans are copied into the ring blocks, then the ring is finished.
+ *
+ * @param ring ring of blocks (i.e. allocated, read by another thread)
+ * @param map pointer to mapped buffer
+ * @param DAQdev
+ * @param wakeup wait for data when the buffer is empty (i.e. poll or backoff)
+ *
+ * @return 0 if all samples were copied
+ * \see sample_data_stream DAQmulti
+ */
+template<typename T>
+inline int sample_data_ring(DAQring<T>& ring, void *map, DAQdevice& DAQdev, DAQwakeup& wakeup)
+{
+  int ret; // return of function
+  int size=DAQdev.bufsize;
+  int offset=0; // read position in mapped buffer (in byte)
+  const long sample_total=(long)DAQdev.sample_number*(long)DAQdev.channel_index.size(); // number of samples for all channels
+  long sample_count=0;  // number of samples read for all channels
+  const int block_size=ring.block_size(); // number of samples in a ring block
+  T *block=NULL;        // ring block being filled
+  int block_count=0;    // number of samples in this block
+  const char *buffer=(const char*)map;
+
+  wakeup.init(DAQdev);
+
+  // sampling loop begins
+  while(sample_count<sample_total)
+    {
+      // get the number of unread bytes in the streaming buffer (whole samples only)
+      int available = DAQdev.backend->get_buffer_contents(DAQdev.subdevice);
+      if(available<0){DAQdev.backend->perror("comedi_get_buffer_contents"); break;}
+      available-=available%sizeof(T);
+      // when the buffer is not updated, wait for data (i.e. blocking poll or backoff sleep)
+      if(available==0)
 	{
-	  if (DAQdev.verbose)std::cout<<"front="<<front<<",back="<<back<<",index="<<i<<",value"<<*(sampl_t *)(map + (i % size))<<std::endl;
-	  data[col](sample_count)=*(sampl_t *)(map + (i % size)); // read the contents of the memory directly and convert it into sampl_t type, which is actually integer.
-	  col++;
-	  if(col == channel_number)
-	    { 
-	      col = 0; //re-initialize col when one series of scan is finished  
-	      sample_count++; 	
-	      if(sample_count==sample_number) sampling_complete_flag=1; //sampling should be stopped when the sample_count reaches to the total number of sample
+	  wakeup.wait();
+	  continue;
+	}
+      wakeup.data(available);
+      // copy available samples into ring blocks (contiguous parts of the mapped buffer)
+      int consumed=0;
+      while(consumed<available && sample_count<sample_total)
+	{
+	  if(block==NULL)
+	    {
+	      block=ring.write_block();
+	      if(block==NULL) break; // ring full: keep data in comedi buffer
+	      block_count=0;
+	    }
+	  long n=(available-consumed)/sizeof(T);
+	  n=std::min(n,(long)(block_size-block_count));
+	  n=std::min(n,sample_total-sample_count);
+	  n=std::min(n,(long)((size-offset)/sizeof(T))); // up to the end of the mapped buffer
+	  memcpy(block+block_count,buffer+offset,n*sizeof(T));
+	  block_count+=n;sample_count+=n;
+	  consumed+=n*sizeof(T);
+	  offset=(offset+n*sizeof(T))%size;
+	  if(block_count==block_size || sample_count==sample_total)
+	    {
+	      ring.commit_write(block_count);
+	      block=NULL;
 	    }
-	  if(sampling_complete_flag==1) break;
 	}
-
       // mark the position where the program has already read. refer to the comedi lib manual for further info
-      ret = comedi_mark_buffer_read(DAQdev.dev, DAQdev.subdevice, front - back);
-      if(ret < 0){comedi_perror("comedi_mark_buffer_read"); break;}
-	
-      // "front" of this time becomes "back" for next time.
-      back = front;
-    
-      // exit while loop
-      if(sampling_complete_flag) break;
-    
+      if(consumed>0)
+	{
+	  ret = DAQdev.backend->mark_buffer_read(DAQdev.subdevice, consumed);
+	  if(ret < 0){DAQdev.backend->perror("comedi_mark_buffer_read"); break;}
+	}
+      // writer thread is late, so wait for a free block
+      if(consumed<available && sample_count<sample_total) usleep(LOOP_USLEEP_TIME);
     }//sampling loop
- 
-
+  // publish last partial block (e.g. on error)
+  if(block!=NULL && block_count>0) ring.commit_write(block_count);
+  ring.finish();
+  wakeup.print(std::cout);
+  return (sample_count==sample_total)?0:-1;
+}
 
- 
-  return 0;
+//! drain the mapped buffer into the streaming ring
+/**
+ * acquisition side of streaming: the mapped comedi buffer is copied (i.e. interleaved scans as is) into the blocks of the streaming ring,
+ * the writer thread of \c stream converts and saves the blocks meanwhile (i.e. memory does not depend on the number of samples).
+ * \note if the ring is full, data is kept in the comedi buffer until the writer thread releases a block.
+ *
+ * @param stream streaming ring and writer thread (i.e. started)
+ * @param map pointer to mapped buffer
+ * @param DAQdev
+ * @param wakeup wait for data when the buffer is empty (i.e. poll or backoff)
+ *
+ * @return
+ * \see DAQstream sample_data_buffer
+ */
+template<typename T>
+inline int sample_data_stream(DAQstream<T>& stream, void *map, DAQdevice& DAQdev, DAQwakeup& wakeup)
+{
+  std::cerr<<__func__<<"\n"<<std::flush;
+  return sample_data_ring(stream.ring,map,DAQdev,wakeup);
 }
 
+//! point acquisition loop
+/**
+ * read a scan at each real time tick, i.e. all channels in a single instruction list request (see \c DAQinsnlist ),
+ * with channel, range and reference of the device.
+ * \param [out] data one image per channel (i.e. native sample type)
+ * \param [in,out] DAQdev acquisition device (i.e. configured; start time is set)
+ * \param [out] jitter wakeup lateness and overrun statistics of real time ticks (i.e. not measured if NULL)
+ * \param [in] placement core and scheduling of the calling thread while acquiring (i.e. \c SCHED_FIFO 49 not pinned if NULL)
+ * \return 0 if all scans were read
+ * \see DAQinsnlist RT_jitter
+ */
 template<typename T>
-inline int sample_data_point(cimg_library::CImgList<T>& data, DAQdevice& DAQdev, bool control=false)
+inline int sample_data_point(cimg_library::CImgList<T>& data, DAQdevice& DAQdev, RT_jitter *jitter=NULL, const RT_placement *placement=NULL, bool control=false)
 {
  std::cerr<<__func__<<"\n"<<std::flush;
  int sample_number=DAQdev.sample_number;
  int channel_number=DAQdev.channel_index.size();
+ DAQinsnlist scan;
+ if(scan.assign(DAQdev,DAQdev.settling_time)) return DIM_ERROR;
  
  RT_preempt RT;
+ RT.jitter=jitter;
+ if(placement!=NULL) RT.placement=*placement;
 // Initialization administration RT  
  RT.initialization(DAQdev.sampling_rate);
-lsampl_t value = 99;
+ gettimeofday(&DAQdev.start_time,NULL);
 for(int i=0;i< sample_number;++i)
 {
   // sleep of a nanosecond
   RT.nanowait();
 //acquire 1 point for all channels
-for(int channel=0;channel<channel_number; ++channel)
-{
-//! \todo [medium] set \c range and \c aref from \c DAQdev
-comedi_data_read_delayed(DAQdev.dev, DAQdev.subdevice, DAQdev.channel_index[channel]/*channel*/,0/*range*/,0/*aref*/,&value,1);
-data[channel](i)=value;
-
-}//channel loop
+if(scan.read(DAQdev.backend)!=0) {DAQdev.backend->perror("comedi_do_insnlist");return -1;}
+for(int channel=0;channel<channel_number; ++channel) data[channel](i)=(T)scan[channel];
 
 // computation of the next time interval in a deterministic way: 50 microsec)
   RT.next_time_interval();
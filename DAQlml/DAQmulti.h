@@ -0,0 +1,391 @@
+#ifndef DAQ_MULTI
+#define DAQ_MULTI
+
+#include <sched.h>
+
+//! split a comma separated list (e.g. \c --fd \c /dev/comedi0,/dev/comedi1 )
+inline std::vector<std::string> DAQmulti_split(const std::string &list,const char separator=',')
+{
+  std::vector<std::string> items;
+  std::string::size_type begin=0,end;
+  do
+  {
+    end=list.find(separator,begin);
+    items.push_back(list.substr(begin,(end==std::string::npos)?std::string::npos:end-begin));
+    begin=end+1;
+  } while(end!=std::string::npos);
+  return items;
+}
+
+//! multi-board streaming acquisition
+/**
+ * synchronized acquisition on several boards (i.e. one \c DAQdevice each, with its own channel list), saved in a single file:
+ * \li each board is drained into its own ring by its own acquisition thread (see \c sample_data_ring ), pinned to its own core,
+ * \li the calling thread merges the rings scan by scan (i.e. all channels of all boards at the same time index), converts and writes them (see \c DAQwriter ).
+ *
+ * Boards should have the same sampling rate and sample type, and may share an external start trigger (i.e. \c trigger="ext" in their parameter files).
+ * Their start times (i.e. command time, or trigger of the first board if all are external) plus their \c clock_offset are aligned:
+ * the earliest boards drop their first scans (i.e. \c skip ), the remaining sub-sample offset of each board is written in \c time_offset of its channels (see \c DAQtime ).
+ * \note streaming parameters (i.e. \c block_size , \c ring_size , \c append and \c flush_period ) are those of \c DAQstream .
+ *
+ * \code
+ *   DAQmulti<sampl_t> multi;
+ *   multi.load_parameter("parameters.nc");
+ *   multi.assign(devices,maps,wakeup);
+ *   multi.start();
+ *   multi.write("data.nc",true,false);
+ *   multi.stop();
+ * \endcode
+ * \see DAQstream sample_data_ring
+ **/
+template<typename Traw>
+class DAQmulti
+{
+ public:
+  int verbose;       ///< verbose option
+  int block_size;    ///< number of scans in a block
+  int ring_size;     ///< number of blocks in each ring
+  bool unlimited;    ///< append blocks as records of the unlimited time dimension
+  float flush_period;///< time between two flushes of the file to disk (in second; 0: at close only)
+
+  std::vector<DAQdevice*> device;    ///< boards (i.e. configured and started)
+  std::vector<void*> map;            ///< mapped buffer of each board
+  std::vector<DAQwakeup> wakeup;     ///< wait for data of each board
+  std::vector<int> cpu;              ///< core of each acquisition thread (-1: not pinned)
+  RT_placement placement;            ///< scheduling of acquisition threads (i.e. policy and priority, core being \c cpu )
+  std::vector<long> skip;            ///< scans dropped at start of each board (i.e. time alignment)
+  std::vector<int> first_channel;    ///< position of the first channel of each board in the merged channel list
+  DAQdevice merged;                  ///< merged channel list (i.e. names, indexes, sampling rate, latest start time)
+  DAQtime time;                      ///< implicit time axis of merged channels (i.e. with clock offset correction)
+  long sample_number;                ///< number of aligned scans to write
+
+  std::vector<DAQring<Traw>*> ring;  ///< interleaved scans of each board
+  unsigned long block_written;       ///< number of merged blocks written
+  double write_time;                 ///< time spent in conversion and writing (in second)
+  DAQstats stats;                    ///< statistics of merged channels (i.e. range of each board)
+
+  //! constructor
+  DAQmulti()
+  {
+    verbose=0;
+    placement.policy=-1;
+    block_size=4096;
+    ring_size=256;
+    unlimited=true;
+    flush_period=1.0f;
+    sample_number=0;
+    block_written=0;write_time=0.0;
+  }
+  ~DAQmulti()
+  {
+    stop();
+    for(unsigned int d=0;d<ring.size();++d) delete ring[d];
+  }
+
+  //! load streaming parameters from file (i.e. \c stream variable, as \c DAQstream )
+  int load_parameter(const std::string file_name)
+  {
+    DAQstream<Traw> stream;
+    int error=stream.load_parameter(file_name);
+    block_size=stream.block_size;ring_size=stream.ring_size;
+    unlimited=stream.unlimited;flush_period=stream.flush_period;
+    return error;
+  }
+
+  //! set boards, check them and compute time alignment
+  /**
+   * \param [in] devices boards (i.e. configured, acquisition command sent)
+   * \param [in] maps mapped buffer of each board
+   * \param [in] wakeup wait for data settings (i.e. copied for each board)
+   * \param [in] cores core of each acquisition thread (empty: board \c d on core \c d+1 , i.e. core 0 left to the writer; -1: not pinned)
+   **/
+  int assign(const std::vector<DAQdevice*> &devices,const std::vector<void*> &maps,const DAQwakeup &wakeup_settings,std::vector<int> cores=std::vector<int>())
+  {
+    const int board_number=devices.size();
+    if(board_number<1||(int)maps.size()!=board_number) return DIM_ERROR;
+    device=devices;map=maps;
+    verbose=device[0]->verbose;
+    wakeup.assign(board_number,wakeup_settings);
+    ///- acquisition thread cores
+    if(cores.empty()) for(int d=0;d<board_number;++d) cores.push_back((d+1)%DAQparallel_cpu_number());
+    if((int)cores.size()!=board_number) {std::cerr<<"Error: "<<cores.size()<<" cores for "<<board_number<<" boards."<<std::endl;return DIM_ERROR;}
+    cpu=cores;
+    ///- check boards
+    for(int d=1;d<board_number;++d)
+    {
+      if(device[d]->sampling_rate!=device[0]->sampling_rate) {std::cerr<<"Error: board \""<<device[d]->filename<<"\" samples at "<<device[d]->sampling_rate<<" Hz instead of "<<device[0]->sampling_rate<<" Hz."<<std::endl;return CODE_ERROR;}
+      if((device[d]->subdevice_flags&SDF_LSAMPL)!=(device[0]->subdevice_flags&SDF_LSAMPL)) {std::cerr<<"Error: boards have different sample types."<<std::endl;return CODE_ERROR;}
+    }
+    ///- time alignment (i.e. start of each board, latest one being the common start)
+    const double period=1.0/(double)device[0]->sampling_rate;
+    bool external=true;
+    for(int d=0;d<board_number;++d) external&=(device[d]->trigger_src==TRIG_EXT);
+    std::vector<double> start(board_number);
+    double latest=0.0;
+    for(int d=0;d<board_number;++d)
+    {
+      const DAQdevice &b=*device[external?0:d];
+      start[d]=(double)b.start_time.tv_sec+1e-6*(double)b.start_time.tv_usec+device[d]->clock_offset;
+      if(d==0||start[d]>latest) latest=start[d];
+    }
+    skip.assign(board_number,0);
+    sample_number=device[0]->sample_number;
+    std::vector<double> residual(board_number);
+    for(int d=0;d<board_number;++d)
+    {
+      skip[d]=(long)((latest-start[d])/period+0.5);
+      residual[d]=start[d]+skip[d]*period-latest;
+      sample_number=std::min(sample_number,(long)device[d]->sample_number-skip[d]);
+    }
+    if(sample_number<1) {std::cerr<<"Error: boards do not overlap in time."<<std::endl;return CODE_ERROR;}
+    ///- merged channel list (i.e. board prefix for duplicated names)
+    merged.channel_index.clear();merged.channel_name.clear();
+    first_channel.assign(board_number,0);
+    time.sampling_period=period;
+    time.start=latest;
+    time.offset.clear();
+    for(int d=0;d<board_number;++d)
+    {
+      first_channel[d]=merged.channel_index.size();
+      const double cdelay=1e-9*(double)device[d]->cmd->convert_arg;
+      for(unsigned int c=0;c<device[d]->channel_index.size();++c)
+      {
+        std::string name=device[d]->channel_name[c];
+        if(std::find(merged.channel_name.begin(),merged.channel_name.end(),name)!=merged.channel_name.end())
+        {
+          std::ostringstream prefix;prefix<<"board"<<d<<"_";
+          name=prefix.str()+name;
+        }
+        merged.channel_name.push_back(name);
+        merged.channel_index.push_back(device[d]->channel_index[c]);
+        time.offset.push_back(residual[d]+cdelay*c);
+      }
+    }
+    merged.sampling_rate=device[0]->sampling_rate;
+    merged.sample_number=(int)sample_number;
+    merged.range_id=device[0]->range_id;
+    merged.maxdata=device[0]->maxdata;
+    merged.comedirange=device[0]->comedirange;
+    merged.verbose=verbose;
+    merged.start_time.tv_sec=(time_t)latest;
+    merged.start_time.tv_usec=(suseconds_t)((latest-(double)merged.start_time.tv_sec)*1e6);
+    ///- rings
+    for(unsigned int d=0;d<ring.size();++d) delete ring[d];
+    ring.assign(board_number,NULL);
+    for(int d=0;d<board_number;++d)
+    {
+      ring[d]=new DAQring<Traw>;
+      if(ring[d]->assign(ring_size,block_size*device[d]->channel_index.size())) {std::cerr<<"Error: bad ring size ("<<ring_size<<" blocks of "<<block_size<<" scans)."<<std::endl;return CODE_ERROR;}
+    }
+    print(std::cout);
+    return 0;
+  }
+
+  //! print boards and alignment
+  void print(std::ostream &stream) const
+  {
+    stream<<device.size()<<" boards, "<<merged.channel_index.size()<<" channels, "<<sample_number<<" aligned scans:"<<std::endl;
+    for(unsigned int d=0;d<device.size();++d)
+      stream<<"  board "<<d<<" \""<<device[d]->filename<<"\": "<<device[d]->channel_index.size()<<" channels, "
+        <<((device[d]->trigger_src==TRIG_EXT)?"external":"immediate")<<" start, "<<skip[d]<<" scans skipped, offset "<<time.offset[first_channel[d]]<<" s, core "<<cpu[d]<<std::endl;
+  }
+
+  //! start acquisition threads (i.e. one for each board)
+  int start()
+  {
+    const int board_number=device.size();
+    thread.assign(board_number,pthread_t());
+    arg.assign(board_number,thread_arg());
+    running.assign(board_number,false);
+    error.assign(board_number,0);
+    for(int d=0;d<board_number;++d)
+    {
+      arg[d].multi=this;arg[d].board=d;
+      if(pthread_create(&thread[d],NULL,acquisition_thread,&arg[d])!=0) {perror("pthread_create");stop();return -1;}
+      running[d]=true;
+    }
+    return 0;
+  }
+
+  //! wait for acquisition threads
+  /**
+   * remaining blocks are dropped (e.g. after a write error), so that acquisition threads never wait for the writer
+   * \return 0 if all boards were fully acquired
+   **/
+  int stop()
+  {
+    if(running.empty()) return 0;
+    drain();
+    int e=0;
+    for(unsigned int d=0;d<running.size();++d)
+    {
+      if(running[d]) {pthread_join(thread[d],NULL);running[d]=false;}
+      e|=error[d];
+      std::cout<<"board "<<d<<": ";ring[d]->print(std::cout);
+    }
+    running.clear();
+    return e;
+  }
+
+  //! merge, convert and write rings while acquiring
+  /**
+   * \param [in] file_name output data file name
+   * \param [in] physical convert binary data into physical voltage
+   * \param [in] time_axis write legacy time variables
+   **/
+  int write(const std::string file_name,const bool physical,const bool time_axis)
+  {
+    int e;
+    if(physical) e=write_loop<float>(file_name,physical,time_axis,"volt");
+    else         e=write_loop<int>(file_name,physical,time_axis,"16 bit binary");
+    std::cout<<block_written<<" blocks written in "<<write_time<<" sec"<<std::endl;
+    stats.print(std::cout,merged);
+    return e;
+  }
+
+ private:
+  //! acquisition thread arguments
+  struct thread_arg
+  {
+    DAQmulti<Traw> *multi;
+    int board;
+  };
+  std::vector<pthread_t> thread; ///< acquisition thread of each board
+  std::vector<thread_arg> arg;   ///< acquisition thread arguments
+  std::vector<bool> running;     ///< acquisition thread is started
+  std::vector<int> error;        ///< acquisition thread return value
+
+  //! acquisition thread entry point (i.e. placed, then drain the mapped buffer of a board into its ring)
+  static void* acquisition_thread(void *a)
+  {
+    DAQmulti<Traw> &multi=*((thread_arg*)a)->multi;
+    const int d=((thread_arg*)a)->board;
+    std::ostringstream name;name<<"board "<<d<<" acquisition";
+    DAQthread::place(RT_placement(multi.cpu[d],multi.placement.policy,multi.placement.priority),name.str());
+    multi.error[d]=sample_data_ring(*multi.ring[d],multi.map[d],*multi.device[d],multi.wakeup[d]);
+    return NULL;
+  }
+
+  //! release all blocks until acquisition threads finish (e.g. on write error, so that they never wait)
+  void drain()
+  {
+    for(unsigned int d=0;d<ring.size();++d)
+    {
+      int n;
+      while(!ring[d]->is_finished())
+      {
+        if(ring[d]->read_block(n)!=NULL) ring[d]->release_read();
+        else usleep(LOOP_USLEEP_TIME);
+      }
+    }
+  }
+
+  //! writer loop: merge blocks of all boards scan by scan, then convert and write them
+  template<typename Tdata>
+  int write_loop(const std::string file_name,const bool physical,const bool time_axis,const std::string data_unit_name)
+  {
+    int e;
+    const int board_number=device.size();
+    const int channel_number=merged.channel_index.size();
+    ///create file structure (i.e. merged channels, corrected time axis)
+    DAQwriter<Tdata,double> fo;
+    fo.unlimited=unlimited;
+    fo.time=time;
+    stats.assign(merged,physical);
+    for(int d=0;d<board_number;++d)
+      for(unsigned int c=0;c<device[d]->channel_index.size();++c) stats.range(first_channel[d]+c,device[d]->comedirange);
+    fo.stats=&stats;
+    int acqu_range_min=0,acqu_range_max=merged.maxdata;std::string acqu_range_unit("level");
+    float phys_range_min=merged.comedirange->min,phys_range_max=merged.comedirange->max;std::string phys_range_unit("volt");
+    if((e=fo.open(file_name,merged,sample_number,time_axis,data_unit_name,
+      acqu_range_min,acqu_range_max,acqu_range_unit,phys_range_min,phys_range_max,phys_range_unit)))
+    {
+      std::cerr<<"Error: can not create \""<<file_name<<"\" (return value is "<<e<<")."<<std::endl;
+      return e;
+    }
+    ///conversion engine of each board
+    std::vector<DAQconvert<Tdata> > conv(board_number);
+    for(int d=0;d<board_number;++d)
+    {
+      conv[d].threads=1;
+      if(physical&&(e=conv[d].assign(*device[d]))) {fo.close();return e;}
+    }
+    ///merge blocks
+    std::vector<Traw*> block(board_number,(Traw*)NULL);
+    std::vector<int> scans(board_number,0),position(board_number,0);
+    std::vector<long> to_skip(skip);
+    cimg_library::CImgList<Traw> data;
+    cimg_library::CImgList<Tdata> data_out;
+    cimg_library::CImgList<double> time_block;
+    double flushed=getETime();
+    long written=0;
+    while(written<sample_number)
+    {
+      ////get unread scans of all boards (i.e. skipped ones are released)
+      bool ended=false;
+      for(int d=0;d<board_number&&!ended;++d)
+        while(block[d]==NULL)
+        {
+          int sample_count;
+          Traw *b=ring[d]->read_block(sample_count);
+          if(b==NULL)
+          {
+            if(ring[d]->is_finished()) {ended=true;break;}
+            usleep(LOOP_USLEEP_TIME);continue;
+          }
+          block[d]=b;scans[d]=sample_count/device[d]->channel_index.size();
+          position[d]=(int)std::min(to_skip[d],(long)scans[d]);to_skip[d]-=position[d];
+          if(position[d]==scans[d]) {ring[d]->release_read();block[d]=NULL;}
+        }
+      if(ended) break;
+      const double st=getETime();
+      ////de-interleave the scans available on all boards
+      long n=sample_number-written;
+      for(int d=0;d<board_number;++d) n=std::min(n,(long)(scans[d]-position[d]));
+      if(data.size()!=(unsigned int)channel_number||data[0].width()!=n) data.assign(channel_number,n);
+      for(int d=0;d<board_number;++d)
+      {
+        const int board_channel=device[d]->channel_index.size();
+        Traw *plane[256];
+        for(int c=0;c<board_channel;++c) plane[c]=data[first_channel[d]+c].data();
+        deinterleave(block[d]+(long)position[d]*board_channel,n,board_channel,plane);
+        position[d]+=n;
+        if(position[d]==scans[d]) {ring[d]->release_read();block[d]=NULL;}
+      }
+      stats.add(data);
+      ////convert with the range of each board
+      if(physical)
+      {
+        if(data_out.size()!=(unsigned int)channel_number||data_out[0].width()!=n) data_out.assign(channel_number,n);
+        for(int d=0;d<board_number;++d)
+          for(unsigned int c=0;c<device[d]->channel_index.size();++c)
+            conv[d].convert(data[first_channel[d]+c].data(),data_out[first_channel[d]+c].data(),n,c);
+      }
+      ////write (and legacy time)
+      if(time_axis) fo.time.get(time_block,fo.sample_count,n);
+      if(physical) e=fo.write(data_out,time_block);
+      else e=fo.write(data,time_block);//raw samples widened to file type
+      if(e)
+      {
+        std::cerr<<"Error: can not write block "<<block_written<<" in \""<<file_name<<"\" (return value is "<<e<<")."<<std::endl;
+        fo.close();
+        return e;
+      }
+      written+=n;
+      ++block_written;
+      ////flush (i.e. written records and their number are on disk)
+      if(flush_period>0&&st-flushed>=flush_period)
+      {
+        if((e=fo.sync())) {std::cerr<<"Error: can not flush \""<<file_name<<"\" (return value is "<<e<<")."<<std::endl;fo.close();return e;}
+        flushed=st;
+      }
+      write_time+=getETime()-st;
+    }
+    ///release blocks in use
+    for(int d=0;d<board_number;++d) if(block[d]!=NULL) ring[d]->release_read();
+    return fo.close();
+  }
+};//DAQmulti class
+
+#endif// DAQ_MULTI
+
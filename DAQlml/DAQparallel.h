@@ -0,0 +1,71 @@
+#ifndef DAQ_PARALLEL
+#define DAQ_PARALLEL
+
+#include <pthread.h>
+#include <unistd.h>
+
+//! job for \c DAQparallel_for
+/**
+ * \c run(i) is called once for each index (e.g. channel), from any thread.
+ **/
+class DAQparallel_job
+{
+ public:
+  virtual ~DAQparallel_job() {}
+  //! process index \c i
+  virtual void run(int i)=0;
+};//DAQparallel_job class
+
+//! thread arguments of \c DAQparallel_for
+struct DAQparallel_arg
+{
+  DAQparallel_job *job; ///< job to run
+  int first;            ///< first index of this thread
+  int step;             ///< index step (i.e. number of threads)
+  int n;                ///< number of indexes
+};
+
+//! thread entry point of \c DAQparallel_for
+inline void* DAQparallel_thread(void *arg)
+{
+  DAQparallel_arg *a=(DAQparallel_arg*)arg;
+  for(int i=a->first;i<a->n;i+=a->step) a->job->run(i);
+  return NULL;
+}
+
+//! number of online processors
+inline int DAQparallel_cpu_number()
+{
+  long n=sysconf(_SC_NPROCESSORS_ONLN);
+  return (n<1)?1:(int)n;
+}
+
+//! run a job for all indexes in \c [0,n) using threads
+/**
+ * indexes are shared cyclically between threads (i.e. thread \c t runs \c t, \c t+threads, ...), the calling thread runs the first share.
+ * \param [in] job job to run
+ * \param [in] n number of indexes (e.g. channels)
+ * \param [in] threads number of threads (0: number of online processors), limited to \c n
+ * \return 0 on success (falls back on the calling thread if a thread can not be created)
+ **/
+inline int DAQparallel_for(DAQparallel_job &job,int n,int threads=0)
+{
+  if(threads<1) threads=DAQparallel_cpu_number();
+  if(threads>n) threads=n;
+  if(threads<=1) {for(int i=0;i<n;++i) job.run(i);return 0;}
+  std::vector<pthread_t> thread(threads);
+  std::vector<DAQparallel_arg> arg(threads);
+  std::vector<bool> started(threads,false);
+  for(int t=0;t<threads;++t) {arg[t].job=&job;arg[t].first=t;arg[t].step=threads;arg[t].n=n;}
+  for(int t=1;t<threads;++t) started[t]=(pthread_create(&thread[t],NULL,DAQparallel_thread,&arg[t])==0);
+  DAQparallel_thread(&arg[0]);
+  for(int t=1;t<threads;++t)
+  {
+    if(started[t]) pthread_join(thread[t],NULL);
+    else DAQparallel_thread(&arg[t]);
+  }
+  return 0;
+}
+
+#endif// DAQ_PARALLEL
+
@@ -0,0 +1,88 @@
+#ifndef DAQ_POINT
+#define DAQ_POINT
+
+//! instruction list reading one scan (i.e. one point of all channels)
+/**
+ * point acquisition engine: a single \c comedi_do_insnlist request reads all channels of a scan (instead of one \c comedi_data_read_delayed request for each channel),
+ * each read instruction having the channel, range and reference of the device (i.e. \c CR_PACK(channel_index,range_id,aref) ).
+ * With a settling time, each channel is first selected (i.e. read of no sample), then waited for, then read (as \c comedi_data_read_delayed does).
+ *
+ * \code
+ *   DAQinsnlist scan;
+ *   scan.assign(DAQdev);
+ *   if(scan.read(DAQdev.backend)==0) for(int c=0;c<scan.size();++c) data[c](i)=scan[c];
+ * \endcode
+ * \see sample_data_point DAQbench.cpp
+ **/
+class DAQinsnlist
+{
+ public:
+  int subdevice;                   ///< subdevice id
+  int settling_time;               ///< wait between channel selection and read (in nanosecond; 0: no wait)
+  std::vector<comedi_insn> insn;   ///< instructions of a scan
+  std::vector<lsampl_t> value;     ///< sample of each channel
+  std::vector<lsampl_t> wait;      ///< argument of wait instructions (i.e. settling time)
+  std::vector<int> index;          ///< read instruction of each channel (i.e. position in \c insn )
+  comedi_insnlist list;            ///< list given to \c do_insnlist
+
+  //! constructor
+  DAQinsnlist()
+  {
+    subdevice=0;
+    settling_time=0;
+    list.n_insns=0;list.insns=NULL;
+  }
+
+  //! number of channels
+  int size() const {return index.size();}
+  //! sample of channel \c c of the last scan read
+  lsampl_t operator[](int c) const {return value[c];}
+
+  //! build instruction list from device channels
+  /**
+   * \param [in] DAQdev acquisition device (i.e. subdevice, channel indexes, range and reference)
+   * \param [in] settle settling time (in nanosecond; 0: no wait, i.e. one instruction for each channel)
+   **/
+  int assign(const DAQdevice &DAQdev,int settle=0)
+  {
+    const int channel_number=DAQdev.channel_index.size();
+    if(channel_number<1) return DIM_ERROR;
+    subdevice=DAQdev.subdevice;
+    settling_time=settle;
+    const int per_channel=(settling_time>0)?3:1;
+    insn.assign(channel_number*per_channel,comedi_insn());
+    value.assign(channel_number,0);
+    wait.assign(1,settling_time);
+    index.assign(channel_number,0);
+    for(int c=0,i=0;c<channel_number;++c)
+    {
+      const unsigned int chanspec=CR_PACK(DAQdev.channel_index[c],DAQdev.range_id,DAQdev.aref);
+      if(settling_time>0)
+      {///- select channel (i.e. no sample), then wait
+        insn[i].insn=INSN_READ;insn[i].n=0;insn[i].data=&value[c];insn[i].subdev=subdevice;insn[i].chanspec=chanspec;++i;
+        insn[i].insn=INSN_WAIT;insn[i].n=1;insn[i].data=&wait[0];++i;
+      }
+      ///- read a sample
+      insn[i].insn=INSN_READ;insn[i].n=1;insn[i].data=&value[c];insn[i].subdev=subdevice;insn[i].chanspec=chanspec;
+      index[c]=i;++i;
+    }
+    list.n_insns=insn.size();
+    list.insns=&insn[0];
+    return 0;
+  }
+
+  //! read one scan
+  /**
+   * \param [in] backend device backend
+   * \return 0 if all instructions were done
+   **/
+  int read(DAQbackend *backend)
+  {
+    const int ret=backend->do_insnlist(&list);
+    if(ret<0) return ret;
+    return (ret==(int)list.n_insns)?0:-1;
+  }
+};//DAQinsnlist class
+
+#endif// DAQ_POINT
+
@@ -0,0 +1,326 @@
+#ifndef DAQ_PYRAMID
+#define DAQ_PYRAMID
+
+//! multi-resolution min/max/mean envelope of channels
+/**
+ * decimation pyramid built block by block while acquiring (i.e. no pass over the whole data after acquisition):
+ * level 0 has one bin every \c base samples, each next level one bin every \c factor bins of the previous one,
+ * each bin holding minimum, maximum and mean of its samples.
+ * Envelopes are accumulated on levels, then given in physical unit (i.e. affine range of each channel) if \c physical (as \c DAQstats ).
+ *
+ * Levels with at least \c min_bins bins are kept (i.e. memory about \c 4/3*3/base floats per sample for \c factor 4).
+ * The viewer draws the level matching the screen width (i.e. a few bins per column whatever the zoom), so that long captures are displayed interactively;
+ * envelopes are optionally written in the data file as \c <channel>__envelope<decimation> variables (i.e. minimum, maximum and mean of each bin, see \c define and \c save ).
+ *
+ * \code
+ *   DAQpyramid pyramid;
+ *   pyramid.assign(DAQdev,DAQdev.sample_number,true);
+ *   pyramid.add(data[c].data(),n,c);//for each block of each channel
+ *   pyramid.finish();
+ *   pyramid.display("channels recorded",DAQdev.sampling_rate);
+ * \endcode
+ * \note parameters are loaded from the \c pyramid variable of the parameter file (i.e. \c base , \c factor and \c save attributes).
+ * \see DAQwriter DAQstats
+ **/
+class DAQpyramid
+{
+ public:
+  int base;      ///< number of samples in a bin of level 0
+  int factor;    ///< number of bins of a level in a bin of the next level
+  int min_bins;  ///< minimum number of bins of a level (i.e. coarser levels are not kept)
+  bool save_file;///< envelopes are written in data file
+  bool physical; ///< envelopes in physical unit (i.e. else in levels)
+  long sample_number;                         ///< number of samples of each channel
+  std::vector<std::string> name;              ///< channel names
+  std::vector<long> decimation;               ///< number of samples in a bin of each level
+  std::vector<cimg_library::CImgList<float> > envelope;///< envelope of each level and channel (i.e. \c envelope[l][c](s,b) , \c s being 0: minimum, 1: maximum, 2: mean)
+  std::vector<double> scale;                  ///< physical step of each channel
+  std::vector<double> offset;                 ///< physical value of level 0 of each channel
+
+  //! constructor
+  DAQpyramid()
+  {
+    base=256;factor=4;min_bins=16;
+    save_file=true;physical=false;
+    sample_number=0;
+  }
+
+  //! number of levels
+  int levels() const {return decimation.size();}
+  //! number of channels
+  int size() const {return name.size();}
+
+  //! load pyramid parameters from file
+  /**
+   * default values are kept for missing parameters (e.g. old parameter file).
+   * \param [in] file_name NetCDF/CDL parameter file name (e.g. "parameters.nc")
+   **/
+  int load_parameter(const std::string file_name)
+  {
+    //NetCDF/CDL parameter file object (i.e. parameter class)
+    CParameterNetCDF fp;
+    ///open file from its name
+    int error=fp.loadFile((char *)file_name.c_str());
+    if(error){std::cerr<<"loadFile return "<< error <<std::endl;return error;}
+    ///open pyramid variable (i.e. process variable)
+    int process;
+    std::string process_name="pyramid";
+    if((error=fp.loadVar(process,&process_name))){std::cerr<<"Warning: process variable \""<<process_name<<"\" can not be loaded (return value is "<<error<<"), using default pyramid parameters.\n";return 0;}
+    ///load attributes (i.e. process parameters)
+    fp.loadAttribute("base",base);
+    fp.loadAttribute("factor",factor);
+    int save=save_file;
+    fp.loadAttribute("save",save);save_file=(save!=0);
+    if(base<1||factor<2) {std::cerr<<"Error: bad pyramid (base "<<base<<", factor "<<factor<<").\n";return CODE_ERROR;}
+    return 0;
+  }
+
+  //! set up levels of all channels (i.e. device range) and clear envelopes
+  /**
+   * \param [in] DAQdev acquisition device (i.e. channel names, range and maxdata)
+   * \param [in] samples number of samples of each channel
+   * \param [in] phys envelopes in physical unit
+   **/
+  int assign(const DAQdevice &DAQdev,long samples,bool phys)
+  {
+    const int channel_number=DAQdev.channel_index.size();
+    if(channel_number<1||samples<1) return DIM_ERROR;
+    name=DAQdev.channel_name;
+    sample_number=samples;
+    physical=phys;
+    scale.assign(channel_number,1.0);offset.assign(channel_number,0.0);
+    if(DAQdev.comedirange!=NULL&&DAQdev.maxdata>0)
+      for(int c=0;c<channel_number;++c)
+      {
+        offset[c]=DAQdev.comedirange->min;
+        scale[c]=(DAQdev.comedirange->max-DAQdev.comedirange->min)/(double)DAQdev.maxdata;
+      }
+    ///- levels (i.e. at least level 0)
+    decimation.clear();envelope.clear();
+    for(long d=base;decimation.empty()||bins(d)>=min_bins;d*=factor)
+    {
+      decimation.push_back(d);
+      envelope.push_back(cimg_library::CImgList<float>(channel_number,3,bins(d),1,1,0.0f));
+    }
+    fill.assign(levels(),std::vector<long>(channel_number,0));
+    current.assign(levels(),std::vector<long>(channel_number,0));
+    return 0;
+  }
+
+  //! add a block of levels of channel \c c (i.e. samples following the previous block)
+  /**
+   * \param [in] x levels (e.g. \c sampl_t , or levels in physical type before conversion)
+   * \param [in] n number of samples
+   * \param [in] c channel (i.e. position in the channel list)
+   **/
+  template<typename T>
+  void add(const T *x,long n,int c)
+  {
+    while(n>0&&current[0][c]<envelope[0][c].height())
+    {
+      const long k=std::min(n,(long)base-fill[0][c]);
+      ///- bin part (i.e. vectorized)
+      T lo=x[0],hi=x[0];
+      double sum=0.0;
+      for(long i=0;i<k;++i) {const T v=x[i];lo=(v<lo)?v:lo;hi=(v>hi)?v:hi;sum+=v;}
+      push(0,c,(float)lo,(float)hi,(float)(sum/k),k);
+      x+=k;n-=k;
+    }
+  }
+
+  //! add a block of all channels (i.e. one image per channel, same width)
+  template<typename T>
+  void add(const cimg_library::CImgList<T> &data)
+  {
+    cimglist_for(data,c) add(data[c].data(),data[c].width(),c);
+  }
+
+  //! end incomplete bins (i.e. last bins of each level, e.g. acquisition stopped before the end)
+  void finish()
+  {
+    for(int c=0;c<size();++c)
+      for(int l=0;l<levels();++l)
+      {
+        if(fill[l][c]==0) continue;
+        const cimg_library::CImg<float> &e=envelope[l][c];
+        const long b=current[l][c],w=fill[l][c];
+        fill[l][c]=0;++current[l][c];
+        if(l+1<levels()) push(l+1,c,e(0,b),e(1,b),e(2,b),w);
+      }
+  }
+
+  //! minimum, maximum and mean of samples \c [first,last) of channel \c c from level \c l (in data unit)
+  void get(int l,int c,long first,long last,float &lo,float &hi,float &mean) const
+  {
+    const cimg_library::CImg<float> &e=envelope[l][c];
+    long b0=first/decimation[l],b1=(last+decimation[l]-1)/decimation[l];
+    b0=std::max(0L,std::min(b0,(long)e.height()-1));b1=std::max(b0+1,std::min(b1,(long)e.height()));
+    float l0=e(0,b0),h0=e(1,b0);double m=0;
+    for(long b=b0;b<b1;++b) {l0=std::min(l0,e(0,b));h0=std::max(h0,e(1,b));m+=e(2,b);}
+    lo=phys(c,l0);hi=phys(c,h0);mean=phys(c,(float)(m/(b1-b0)));
+  }
+
+  //! create envelope variables (i.e. file in define mode)
+  /**
+   * \c <channel>__envelope<decimation>(envelope<decimation>,envelope) for each level and channel, \c envelope being minimum, maximum and mean
+   * \param [in] fp NetCDF file
+   * \param [in] unit data unit (e.g. "volt")
+   **/
+  int define(NcFile *fp,const std::string &unit)
+  {
+    vars.assign(levels(),std::vector<NcVar*>(size(),(NcVar*)NULL));
+    NcDim *ds;
+    if(!(ds=fp->add_dim("envelope",3))) return NC_ERROR;
+    for(int l=0;l<levels();++l)
+    {
+      std::ostringstream suffix;suffix<<"envelope"<<decimation[l];
+      NcDim *db;
+      if(!(db=fp->add_dim(suffix.str().c_str(),envelope[l][0].height()))) return NC_ERROR;
+      for(int c=0;c<size();++c)
+      {
+        NcVar *v;
+        if(!(v=fp->add_var((name[c]+"__"+suffix.str()).c_str(),ncFloat,db,ds))) return NC_ERROR;
+        if(!v->add_att("decimation",(int)decimation[l])) return NC_ERROR;
+        if(!v->add_att("envelope","minimum maximum mean")) return NC_ERROR;
+        if(!v->add_att("units",unit.c_str())) return NC_ERROR;
+        vars[l][c]=v;
+      }
+    }
+    return 0;
+  }
+
+  //! write envelopes (i.e. variables created by \c define , file in data mode)
+  int save()
+  {
+    finish();
+    for(int l=0;l<(int)vars.size();++l)
+      for(int c=0;c<(int)vars[l].size();++c)
+      {
+        cimg_library::CImg<float> e=envelope[l][c];
+        if(physical) cimg_forY(e,b) for(int s=0;s<3;++s) e(s,b)=phys(c,e(s,b));
+        if(!vars[l][c]->put(e.data(),e.height(),3)) return NC_ERROR;
+      }
+    return 0;
+  }
+
+  //! interactive display of all channels
+  /**
+   * mouse wheel zooms around mouse position, left button drag or arrow keys pan, ESC or Q quits.
+   * Each column shows minimum to maximum of its samples (i.e. from the level with a few bins per column), and their mean.
+   * \param [in] title window title
+   * \param [in] sampling_rate sampling rate (i.e. time of window in title)
+   * \param [in] raw levels of all channels, drawn when zoomed below level 0 (none if NULL, e.g. streaming)
+   **/
+  template<typename T>
+  void display(const std::string &title,double sampling_rate,const cimg_library::CImgList<T> *raw) const
+  {
+    if(levels()==0) return;
+    const int W=1024,channel_height=std::max(64,512/size()),H=channel_height*size();
+    cimg_library::CImg<unsigned char> img(W,H,1,3);
+    cimg_library::CImgDisplay disp(W,H,title.c_str(),0);
+    const unsigned char colour[6][3]={{255,0,0},{0,160,0},{0,0,255},{200,120,0},{160,0,160},{0,140,140}};
+    const unsigned char black[3]={0,0,0},grey[3]={128,128,128};
+    ///- vertical scale of each channel (i.e. coarsest level)
+    std::vector<float> ymin(size()),ymax(size());
+    for(int c=0;c<size();++c) {float m;get(levels()-1,c,0,sample_number,ymin[c],ymax[c],m);if(ymax[c]<=ymin[c]) ymax[c]=ymin[c]+1;}
+    double x0=0,span=sample_number;
+    bool redraw=true;
+    int drag=-1;
+    while(!disp.is_closed()&&!disp.is_keyESC()&&!disp.is_keyQ())
+    {
+      if(redraw)
+      {
+        ///- level with at least one bin per column
+        int l=levels()-1;
+        while(l>0&&decimation[l]>span/W) --l;
+        const bool samples=(raw!=NULL&&span/W<decimation[0]);
+        img.fill(255);
+        for(int c=0;c<size();++c)
+        {
+          const int top=c*channel_height;
+          const double sy=(channel_height-4)/(ymax[c]-ymin[c]);
+          img.draw_line(0,top,W-1,top,grey);
+          int py=-1;
+          for(int px=0;px<W;++px)
+          {
+            const long s0=(long)(x0+span*px/W),s1=std::max(s0+1,(long)(x0+span*(px+1)/W));
+            if(s0>=sample_number) break;
+            float lo,hi,mean;
+            if(samples)
+            {
+              const T *r=(*raw)[c].data();
+              lo=hi=r[s0];double m=0;
+              const long e=std::min(s1,sample_number);
+              for(long s=s0;s<e;++s) {lo=std::min(lo,(float)r[s]);hi=std::max(hi,(float)r[s]);m+=r[s];}
+              lo=phys(c,lo);hi=phys(c,hi);mean=phys(c,(float)(m/(e-s0)));
+            }
+            else get(l,c,s0,s1,lo,hi,mean);
+            const int ylo=top+channel_height-2-(int)((lo-ymin[c])*sy),yhi=top+channel_height-2-(int)((hi-ymin[c])*sy),ym=top+channel_height-2-(int)((mean-ymin[c])*sy);
+            img.draw_line(px,ylo,px,yhi,colour[c%6]);
+            if(py>=0) img.draw_line(px-1,py,px,ym,black);
+            py=ym;
+          }
+        }
+        std::ostringstream t;
+        t<<title<<": "<<x0/sampling_rate<<" to "<<(x0+span)/sampling_rate<<" s (";
+        if(samples) t<<"samples)";else t<<"decimation "<<decimation[l]<<")";
+        disp.set_title("%s",t.str().c_str());
+        disp.display(img);
+        redraw=false;
+      }
+      disp.wait();
+      ///- zoom around mouse
+      if(disp.wheel())
+      {
+        const double mx=x0+span*std::max(0,disp.mouse_x())/W;
+        const double z=(disp.wheel()>0)?0.5:2.0;
+        span=std::max(16.0,std::min((double)sample_number,span*z));
+        x0=mx-(mx-x0)*z;
+        disp.set_wheel();redraw=true;
+      }
+      ///- pan
+      if(disp.is_keyARROWLEFT())  {x0-=span/4;disp.set_key();redraw=true;}
+      if(disp.is_keyARROWRIGHT()) {x0+=span/4;disp.set_key();redraw=true;}
+      if(disp.button()&1)
+      {
+        if(drag>=0&&disp.mouse_x()>=0) {x0-=span*(disp.mouse_x()-drag)/W;redraw=true;}
+        drag=disp.mouse_x();
+      }
+      else drag=-1;
+      if(redraw) x0=std::max(0.0,std::min(x0,(double)sample_number-span));
+    }
+  }
+
+ private:
+  std::vector<std::vector<long> > fill;    ///< number of samples in current bin of each level and channel
+  std::vector<std::vector<long> > current; ///< current bin of each level and channel
+  std::vector<std::vector<NcVar*> > vars;  ///< envelope variables of each level and channel (see \c define )
+
+  //! number of bins of a level
+  long bins(long d) const {return (sample_number+d-1)/d;}
+  //! level in physical unit (if \c physical )
+  float phys(int c,float level) const {return physical?(float)(offset[c]+scale[c]*level):level;}
+
+  //! add \c w samples (i.e. their envelope) to current bin of level \c l , then complete bins go up
+  void push(int l,int c,float lo,float hi,float mean,long w)
+  {
+    cimg_library::CImg<float> &e=envelope[l][c];
+    const long b=current[l][c];
+    if(b>=e.height()) return;
+    long &f=fill[l][c];
+    if(f==0) {e(0,b)=lo;e(1,b)=hi;e(2,b)=mean;}
+    else
+    {
+      e(0,b)=std::min(e(0,b),lo);e(1,b)=std::max(e(1,b),hi);
+      e(2,b)=(float)((e(2,b)*(double)f+mean*(double)w)/(double)(f+w));
+    }
+    f+=w;
+    if(f<decimation[l]) return;
+    ///- complete bin (i.e. to next level)
+    f=0;++current[l][c];
+    if(l+1<levels()) push(l+1,c,e(0,b),e(1,b),e(2,b),decimation[l]);
+  }
+};//DAQpyramid class
+
+#endif// DAQ_PYRAMID
+
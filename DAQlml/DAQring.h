@@ -0,0 +1,126 @@
+#ifndef DAQ_RING
+#define DAQ_RING
+
+//! lock-free ring of sample blocks
+/**
+ * single-producer/single-consumer ring of preallocated blocks of samples (e.g. interleaved scans as in the comedi buffer).
+ * The producer (i.e. acquisition thread) fills the block given by \c write_block() and then publishes it using \c commit_write() ;
+ * the consumer (i.e. writer thread) gets the oldest published block using \c read_block() and gives it back using \c release_read() .
+ * \note only one thread may write and only one thread may read, so that the block counters are updated without any lock (i.e. memory barriers only).
+ * \note the memory footprint is fixed at \c assign (i.e. whatever the acquisition duration).
+ *
+ * \code
+ *   DAQring<sampl_t> ring;ring.assign(256,4096*channel_number);
+ *   //producer
+ *   sampl_t *w=ring.write_block();if(w!=NULL){...;ring.commit_write(sample_count);}
+ *   //consumer
+ *   int n;sampl_t *r=ring.read_block(n);if(r!=NULL){...;ring.release_read();}
+ * \endcode
+ **/
+template<typename T>
+class DAQring
+{
+ public:
+  cimg_library::CImgList<T> block; ///< ring blocks (preallocated)
+  cimg_library::CImg<int> count;   ///< number of valid samples in each block
+  volatile unsigned long head;     ///< number of blocks published (written by producer only)
+  volatile unsigned long tail;     ///< number of blocks released (written by consumer only)
+  volatile int finished;           ///< producer will not publish any more block
+  unsigned long full_count;        ///< number of times producer found the ring full (producer only)
+  unsigned long max_used;          ///< maximum number of blocks used in the ring (producer only)
+
+  //! constructor
+  DAQring()
+  {
+    head=tail=0;finished=0;
+    full_count=max_used=0;
+  }
+
+  //! allocate ring
+  /**
+   * \param [in] block_number number of blocks in the ring
+   * \param [in] block_size   number of samples in each block
+   **/
+  int assign(int block_number,int block_size)
+  {
+    if(block_number<2||block_size<1) return -1;
+    block.assign(block_number,block_size);
+    count.assign(block_number).fill(0);
+    head=tail=0;finished=0;
+    full_count=max_used=0;
+    return 0;
+  }
+
+  //! number of blocks in the ring
+  int size() const {return (int)block.size();}
+  //! number of samples in each block
+  int block_size() const {return block.is_empty()?0:block[0].width();}
+  //! number of published blocks not released yet
+  int used() const {return (int)(head-tail);}
+
+  //! producer: get the block to fill
+  /**
+   * \return pointer to the block to fill, or \c NULL if the ring is full (i.e. consumer is late)
+   **/
+  T* write_block()
+  {
+    unsigned long h=head;
+    if(h-tail>=block.size()) {++full_count;return NULL;}
+    return block[h%block.size()].data();
+  }
+  //! producer: publish the block given by \c write_block()
+  /**
+   * \param [in] sample_count number of valid samples in the block
+   **/
+  void commit_write(int sample_count)
+  {
+    unsigned long h=head;
+    count(h%block.size())=sample_count;
+    //block content must be visible before the counter
+    __sync_synchronize();
+    head=h+1;
+    if(h+1-tail>max_used) max_used=h+1-tail;
+  }
+  //! producer: no more block will be published
+  void finish()
+  {
+    __sync_synchronize();
+    finished=1;
+  }
+
+  //! consumer: get the oldest published block
+  /**
+   * \param [out] sample_count number of valid samples in the block
+   * \return pointer to the block, or \c NULL if the ring is empty
+   **/
+  T* read_block(int &sample_count)
+  {
+    unsigned long t=tail;
+    if(head==t) return NULL;
+    //counter must be read before the block content
+    __sync_synchronize();
+    sample_count=count(t%block.size());
+    return block[t%block.size()].data();
+  }
+  //! consumer: release the block given by \c read_block()
+  void release_read()
+  {
+    //block content must be read before giving it back
+    __sync_synchronize();
+    tail=tail+1;
+  }
+  //! consumer: ring is empty and producer has finished
+  bool is_finished() const
+  {
+    return finished&&(head==tail);
+  }
+
+  //! print ring information
+  void print(std::ostream &stream)
+  {
+    stream<<"ring: "<<size()<<" blocks of "<<block_size()<<" samples, "<<head<<" blocks published, maximum use "<<max_used<<" blocks, full "<<full_count<<" times"<<std::endl;
+  }
+};//DAQring class
+
+#endif// DAQ_RING
+
@@ -0,0 +1,349 @@
+#ifndef DAQ_ROTATE
+#define DAQ_ROTATE
+
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+//! index of a rotated file set
+/**
+ * map time ranges to the files of a rotated set (e.g. \c data.0000.nc , \c data.0001.nc , ...):
+ * each file holds \c count samples of each channel from sample \c first of the whole run,
+ * so that time of a sample is \c start + \c s * \c sampling_period (see \c DAQtime ).
+ *
+ * The manifest is a small text file (e.g. \c data.manifest ) written again at each rotation and flush (i.e. through a temporary file renamed, so that it is always complete):
+ * \code
+ *   # DAQlml manifest: file first_sample sample_count start end (in second from start_time_epoch)
+ *   start_time_epoch 1331720430.123456
+ *   sampling_period 1e-05
+ *   data.0000.nc 0 360000000 0 3600
+ *   data.0001.nc 360000000 122880 3600 3601.2288
+ * \endcode
+ * \note file names are relative to the manifest directory, so that the set may be moved as a whole (e.g. off-box while acquisition continues).
+ * \see DAQrotate load_data_range
+ **/
+class DAQmanifest
+{
+ public:
+  std::string file_name;          ///< manifest file name (e.g. "data.manifest")
+  double start;                   ///< time of the first sample of the run (second since 1970-01-01 UTC)
+  double sampling_period;         ///< time between two scans (in second)
+  std::vector<std::string> name;  ///< file names (i.e. relative to manifest directory)
+  std::vector<long> first;        ///< first sample of each file in the run
+  std::vector<long> count;        ///< number of samples of each channel in each file
+
+  //! constructor
+  DAQmanifest()
+  {
+    start=0.0;sampling_period=0.0;
+  }
+
+  //! manifest name of a data file name (e.g. "data.manifest" for "data.nc")
+  static std::string manifest_name(const std::string &data_name)
+  {
+    const std::string::size_type dot=data_name.rfind('.');
+    const std::string::size_type slash=data_name.rfind('/');
+    if(dot==std::string::npos||(slash!=std::string::npos&&dot<slash)) return data_name+".manifest";
+    return data_name.substr(0,dot)+".manifest";
+  }
+
+  //! file name of rotated file \c index (e.g. "data.0003.nc" for "data.nc")
+  static std::string rotated_name(const std::string &data_name,int index)
+  {
+    char number[16];
+    std::sprintf(number,".%04d",index);
+    const std::string::size_type dot=data_name.rfind('.');
+    const std::string::size_type slash=data_name.rfind('/');
+    if(dot==std::string::npos||(slash!=std::string::npos&&dot<slash)) return data_name+number;
+    return data_name.substr(0,dot)+number+data_name.substr(dot);
+  }
+
+  //! directory of the manifest (i.e. prefix of file names, empty or ending with '/')
+  std::string directory() const
+  {
+    const std::string::size_type slash=file_name.rfind('/');
+    return (slash==std::string::npos)?std::string():file_name.substr(0,slash+1);
+  }
+
+  //! number of samples of each channel in the whole set
+  long samples() const
+  {
+    return name.empty()?0:first.back()+count.back();
+  }
+
+  //! file holding sample \c s (i.e. -1 if none)
+  int find(long s) const
+  {
+    for(unsigned int f=0;f<name.size();++f) if(s>=first[f]&&s<first[f]+count[f]) return f;
+    return -1;
+  }
+
+  //! add a file (i.e. path of the data file, its directory is dropped)
+  void add(const std::string &path,long first_sample,long sample_count=0)
+  {
+    const std::string::size_type slash=path.rfind('/');
+    name.push_back((slash==std::string::npos)?path:path.substr(slash+1));
+    first.push_back(first_sample);
+    count.push_back(sample_count);
+  }
+
+  //! write manifest (i.e. temporary file renamed)
+  int save() const
+  {
+    const std::string tmp=file_name+".tmp";
+    {
+      std::ofstream out(tmp.c_str());
+      if(!out) {std::cerr<<"Error: can not write \""<<tmp<<"\" manifest."<<std::endl;return CODE_ERROR;}
+      out.precision(17);
+      out<<"# DAQlml manifest: file first_sample sample_count start end (in second from start_time_epoch)"<<std::endl;
+      out<<"start_time_epoch "<<start<<std::endl;
+      out<<"sampling_period "<<sampling_period<<std::endl;
+      for(unsigned int f=0;f<name.size();++f)
+        out<<name[f]<<" "<<first[f]<<" "<<count[f]<<" "<<first[f]*sampling_period<<" "<<(first[f]+count[f])*sampling_period<<std::endl;
+      if(!out) return CODE_ERROR;
+    }
+    if(std::rename(tmp.c_str(),file_name.c_str())!=0) {perror("rename");return CODE_ERROR;}
+    return 0;
+  }
+
+  //! read manifest
+  /**
+   * \param [in] manifest_file manifest file name (e.g. "data.manifest")
+   **/
+  int load(const std::string &manifest_file)
+  {
+    std::ifstream in(manifest_file.c_str());
+    if(!in) {std::cerr<<"Error: can not open \""<<manifest_file<<"\" manifest."<<std::endl;return CODE_ERROR;}
+    file_name=manifest_file;
+    name.clear();first.clear();count.clear();
+    start=0.0;sampling_period=0.0;
+    std::string line;
+    while(std::getline(in,line))
+    {
+      if(line.empty()||line[0]=='#') continue;
+      std::istringstream l(line);
+      std::string key;
+      l>>key;
+      if(key=="start_time_epoch") {l>>start;continue;}
+      if(key=="sampling_period") {l>>sampling_period;continue;}
+      long f,n;
+      if(!(l>>f>>n)) {std::cerr<<"Error: bad line \""<<line<<"\" in \""<<manifest_file<<"\" manifest."<<std::endl;return CODE_ERROR;}
+      if(!name.empty()&&f!=samples()) {std::cerr<<"Error: file \""<<key<<"\" does not follow previous one in \""<<manifest_file<<"\" manifest."<<std::endl;return DIM_ERROR;}
+      name.push_back(key);first.push_back(f);count.push_back(n);
+    }
+    if(sampling_period<=0) {std::cerr<<"Error: no sampling period in \""<<manifest_file<<"\" manifest."<<std::endl;return CODE_ERROR;}
+    return 0;
+  }
+};//DAQmanifest class
+
+//! write recorded data into a rotated file set
+/**
+ * same as \c DAQwriter , but the output rotates into numbered files (e.g. \c data.0000.nc , \c data.0001.nc , ... for "data.nc")
+ * when the data of a file reach \c max_bytes or cover \c max_duration ; files and their time ranges are listed in a manifest (see \c DAQmanifest ).
+ * Blocks are split at the threshold, so that each file (but the last) holds the same number of samples,
+ * and each file is complete by itself (i.e. attributes, \c start_time of its first sample; 64-bit offset format if over 2 GiB, see \c DAQwriter::offset64 ).
+ * Without threshold (i.e. both 0), it is a plain \c DAQwriter on the given file name.
+ * \note channel statistics in each file are the ones of the run so far; envelope pyramid is not saved in rotated files.
+ *
+ * \code
+ *   DAQrotate<float,double> fo;
+ *   fo.max_duration=3600;//one file per hour
+ *   fo.open("data.nc",DAQdev,DAQdev.sample_number,false,"volt",0,DAQdev.maxdata,acqu_range_unit,-10.0f,10.0f,phys_range_unit);
+ *   fo.write(data_block,time_block);//as many times as needed
+ *   fo.close();
+ * \endcode
+ * \see DAQwriter load_data_range
+ **/
+template <typename Tdata, typename Ttime, typename Tacqu=int, typename Tphys=float>
+class DAQrotate:public DAQwriter<Tdata,Ttime>
+{
+ public:
+  typedef DAQwriter<Tdata,Ttime> writer;
+  double max_bytes;   ///< rotate when data of a file reach this size (in byte; 0: no size limit)
+  double max_duration;///< rotate when a file covers this duration (in second; 0: no time limit)
+  DAQmanifest manifest;///< files of the set (i.e. written at each rotation, flush and close)
+  long file_samples;  ///< number of samples of each channel in a file (i.e. from thresholds)
+  long total_samples; ///< number of samples of each channel in the run (i.e. expected if \c unlimited )
+  long first;         ///< first sample of the current file in the run
+  int file_index;     ///< number of the current file
+
+  //! constructor
+  DAQrotate()
+  {
+    max_bytes=max_duration=0.0;
+    file_samples=total_samples=first=0;file_index=0;
+    pDAQdev=NULL;with_time=false;
+  }
+
+  //! rotation is set (i.e. a threshold)
+  bool rotating() const {return max_bytes>0||max_duration>0;}
+
+  //! create first file (see \c DAQwriter::open )
+  int open(std::string file_name,DAQdevice &DAQdev,long samples,bool time_axis,
+    std::string data_unit,
+    Tacqu acqu_range_min, Tacqu acqu_range_max, std::string &acqu_range_unit,
+    Tphys phys_range_min, Tphys phys_range_max, std::string &phys_range_unit)
+  {
+    if(!rotating()) return writer::open(file_name,DAQdev,samples,time_axis,data_unit,acqu_range_min,acqu_range_max,acqu_range_unit,phys_range_min,phys_range_max,phys_range_unit);
+    ///keep file structure for next files
+    base_name=file_name;pDAQdev=&DAQdev;with_time=time_axis;data_unit_name=data_unit;
+    acqu_min=acqu_range_min;acqu_max=acqu_range_max;acqu_unit=acqu_range_unit;
+    phys_min=phys_range_min;phys_max=phys_range_max;phys_unit=phys_range_unit;
+    if(this->pyramid!=NULL) {std::cerr<<"Warning: envelope pyramid is not saved in rotated files."<<std::endl;this->pyramid=NULL;}
+    ///samples in a file (i.e. smallest threshold)
+    if(DAQdev.sampling_rate<=0) return CODE_ERROR;
+    const double scan_bytes=(double)DAQdev.channel_index.size()*sizeof(Tdata)+(with_time?(DAQdev.channel_index.size()+1.0)*sizeof(Ttime):0.0);
+    double n=0.0;
+    if(max_bytes>0) n=max_bytes/scan_bytes;
+    if(max_duration>0&&(n==0.0||max_duration*DAQdev.sampling_rate<n)) n=max_duration*DAQdev.sampling_rate;
+    file_samples=std::max(1L,(long)n);
+    total_samples=samples;first=0;file_index=0;
+    ///manifest (i.e. time of the run)
+    manifest=DAQmanifest();
+    manifest.file_name=DAQmanifest::manifest_name(file_name);
+    int error;
+    if(this->time.offset.size()!=DAQdev.channel_index.size()&&(error=this->time.assign(DAQdev))) return error;
+    manifest.start=this->time.start;manifest.sampling_period=this->time.sampling_period;
+    return open_next();
+  }
+
+  //! write a block of data (and its time) after the previous one, in as many files as needed (see \c DAQwriter::write )
+  template <typename Traw>
+  int write(cimg_library::CImgList<Traw> &data,cimg_library::CImgList<Ttime> &time)
+  {
+    if(!rotating()) return writer::write(data,time);
+    if(data.is_empty()) return 0;
+    int error;
+    const int width=data[0].width();
+    cimg_library::CImgList<Traw> part;
+    cimg_library::CImgList<Ttime> part_time;
+    bool rotated=false;
+    for(int s=0;s<width;)
+    {
+      ///- next file if current one is full (i.e. not over the run in fixed time dimension)
+      if(full()&&(this->unlimited||first+this->sample_count<total_samples))
+      {
+        if((error=rotate())) return error;
+        rotated=true;
+      }
+      long room=file_samples-this->sample_count;
+      if(!this->unlimited) room=std::min(room,this->sample_number-this->sample_count);
+      const int n=(room>0)?(int)std::min((long)(width-s),room):width-s;
+      ///- whole block in current file (i.e. no copy)
+      if(n==width&&!rotated) return writer::write(data,time);
+      ///- part of block (i.e. its time in the current file)
+      part.assign(data.size(),n);
+      cimglist_for(data,c) std::memcpy(part[c].data(),data[c].data(s),n*sizeof(Traw));
+      if(with_time&&(error=this->time.get(part_time,this->sample_count,n))) return error;
+      if((error=writer::write(part,part_time))) return error;
+      s+=n;
+    }
+    return 0;
+  }
+
+  //! flush written data and manifest to disk
+  int sync()
+  {
+    int error=writer::sync();
+    if(error||!rotating()) return error;
+    manifest.count.back()=this->sample_count;
+    return manifest.save();
+  }
+
+  //! close current file and write manifest
+  int close()
+  {
+    if(!this->opened) return 0;
+    int error=writer::close();
+    if(!rotating()) return error;
+    manifest.count.back()=this->sample_count;
+    const int merror=manifest.save();
+    return error?error:merror;
+  }
+
+ private:
+  std::string base_name;   ///< output data file name (i.e. before numbering)
+  DAQdevice *pDAQdev;      ///< acquisition device
+  bool with_time;          ///< legacy time variables
+  std::string data_unit_name;
+  Tacqu acqu_min,acqu_max;std::string acqu_unit;
+  Tphys phys_min,phys_max;std::string phys_unit;
+
+  //! current file holds its samples
+  bool full() const
+  {
+    return this->sample_count>=file_samples||(!this->unlimited&&this->sample_count>=this->sample_number);
+  }
+
+  //! create next file of the set (i.e. time shifted to its first sample)
+  int open_next()
+  {
+    const std::string file_name=DAQmanifest::rotated_name(base_name,file_index);
+    long samples=file_samples;
+    if(total_samples>first) samples=std::min(samples,total_samples-first);
+    this->time.start=manifest.start+(double)first*manifest.sampling_period;
+    int error;
+    if((error=writer::open(file_name,*pDAQdev,samples,with_time,data_unit_name,acqu_min,acqu_max,acqu_unit,phys_min,phys_max,phys_unit))) return error;
+    manifest.add(file_name,first);
+    std::cout<<"writing \""<<file_name<<"\" from sample "<<first<<"."<<std::endl;
+    return manifest.save();
+  }
+
+  //! close current file and create next one
+  int rotate()
+  {
+    manifest.count.back()=this->sample_count;
+    first+=this->sample_count;
+    ++file_index;
+    int error=writer::close();
+    if(error) return error;
+    return open_next();
+  }
+};//DAQrotate class
+
+//! load a time range of a rotated file set
+/**
+ * load samples of the requested channels from \c start for \c duration (i.e. time from the first sample of the run, see \c DAQmanifest ),
+ * reading only the overlapping files of the set (i.e. hyperslab of each, see \c DAQreader ).
+ * \param [in]  manifest_file manifest file name (e.g. "data.manifest")
+ * \param [in]  var_names variable names (i.e. channel subset)
+ * \param [out] channels data as physical values (i.e. packed data are unpacked)
+ * \param [in]  start time of the first sample (in second from \c start_time_epoch of the manifest)
+ * \param [in]  duration time range (in second; clipped to the end of the set)
+ * \param [in]  stride distance between two read samples (e.g. decimated overview)
+ * \see load_data_window DAQrotate
+**/
+template<typename T> int load_data_range(std::string manifest_file,std::vector<std::string> var_names,CImgList<T> &channels,double start,double duration,long stride=1)
+{
+  DAQmanifest m;
+  int error;
+  if((error=m.load(manifest_file))) return error;
+  if(start<0||duration<0||stride<1||var_names.empty()) return DIM_ERROR;
+  ///samples of the range (i.e. \c [s0,s1) of the run, every stride)
+  const long s0=(long)std::ceil(start/m.sampling_period-1e-9);
+  const long s1=std::min(m.samples(),(long)std::ceil((start+duration)/m.sampling_period-1e-9));
+  const long n=(s1>s0)?(s1-s0+stride-1)/stride:0;
+  channels.assign(var_names.size(),n);
+  ///read overlapping files
+  for(unsigned int f=0;f<m.name.size();++f)
+  {
+    const long fbegin=m.first[f],fend=m.first[f]+m.count[f];
+    if(fend<=s0||fbegin>=s1) continue;
+    const long k0=(fbegin>s0)?(fbegin-s0+stride-1)/stride:0;//first sample of range in file
+    const long k1=std::min(n,(fend-s0+stride-1)/stride);
+    if(k1<=k0) continue;
+    DAQreader<T> fi;
+    if((error=fi.open(m.directory()+m.name[f],var_names))) return error;
+    if((error=fi.window(s0+k0*stride-fbegin,k1-k0,stride))) return error;
+    fi.block_size=k1-k0;
+    CImgList<T> block;
+    const long r=fi.next(block);
+    if(r<0) return (int)r;
+    if(r!=k1-k0) {std::cerr<<"Error: \""<<m.name[f]<<"\" holds less samples than in manifest."<<std::endl;return DIM_ERROR;}
+    cimglist_for(channels,c) std::memcpy(channels[c].data(k0),block[c].data(),r*sizeof(T));
+  }
+  return 0;
+}
+
+#endif// DAQ_ROTATE
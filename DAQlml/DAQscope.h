@@ -0,0 +1,250 @@
+#ifndef DAQ_SCOPE
+#define DAQ_SCOPE
+
+//! live oscilloscope while streaming
+/**
+ * the writer thread publishes each block in a short history of all channels (i.e. last \c length samples),
+ * a display thread takes snapshots of this history at a capped frame rate and draws its latest sweep.
+ *
+ * History is protected by a sequence lock: the writer only increments \c sequence before and after copying a block (i.e. odd while writing),
+ * the reader copies the history then checks that \c sequence did not change (i.e. else the frame is retried, then skipped).
+ * So that publishing never waits for the display (i.e. no lock, no condition), the acquisition pipeline is never slowed down by the scope.
+ *
+ * Sweep is either free running (i.e. latest \c width samples) or triggered by level and edge on a chosen channel:
+ * the latest crossing after the previous sweep is drawn at a tenth of the window (i.e. pre-trigger);
+ * in \c auto mode, the latest samples are drawn if no trigger comes, in \c normal mode the previous sweep is kept.
+ * Redraw is incremental: the grid is drawn once, traces only when new samples are published.
+ * \note parameters are loaded from the \c scope variable of the parameter file (i.e. \c width , \c frame_rate , \c trigger_channel , \c trigger_level , \c trigger_edge and \c trigger_mode attributes).
+ *
+ * \code
+ *   DAQscope scope;
+ *   scope.load_parameter("parameters.nc");
+ *   scope.start(DAQdev,true);
+ *   scope.publish(data_phys);//for each block, from writer thread
+ *   scope.stop();
+ * \endcode
+ * \see DAQstream
+ **/
+class DAQscope
+{
+ public:
+  int width;          ///< number of samples in a sweep
+  float frame_rate;   ///< maximum number of frames per second
+  int trigger_channel;///< trigger channel (i.e. position in the channel list; -1: free running)
+  float trigger_level;///< trigger level (i.e. in data unit)
+  bool rising;        ///< trigger on rising edge (i.e. else falling)
+  bool normal;        ///< keep previous sweep until next trigger (i.e. else \c auto mode)
+  RT_placement placement;///< core and scheduling of display thread (see \c DAQthread )
+
+  //! constructor
+  DAQscope()
+  {
+    width=2048;frame_rate=25.0f;
+    trigger_channel=-1;trigger_level=0.0f;rising=true;normal=false;
+    placement.policy=-1;
+    sequence=0;position=0;length=0;
+    sampling_rate=1.0;ymin=0.0f;ymax=1.0f;
+    running=false;stopping=false;
+  }
+
+  //! load scope parameters from file
+  /**
+   * default values are kept for missing parameters (e.g. old parameter file).
+   * \param [in] file_name NetCDF/CDL parameter file name (e.g. "parameters.nc")
+   **/
+  int load_parameter(const std::string file_name)
+  {
+    //NetCDF/CDL parameter file object (i.e. parameter class)
+    CParameterNetCDF fp;
+    ///open file from its name
+    int error=fp.loadFile((char *)file_name.c_str());
+    if(error){std::cerr<<"loadFile return "<< error <<std::endl;return error;}
+    ///open scope variable (i.e. process variable)
+    int process;
+    std::string process_name="scope";
+    if((error=fp.loadVar(process,&process_name))){std::cerr<<"Warning: process variable \""<<process_name<<"\" can not be loaded (return value is "<<error<<"), using default scope parameters.\n";return 0;}
+    ///load attributes (i.e. process parameters)
+    fp.loadAttribute("width",width);
+    fp.loadAttribute("frame_rate",frame_rate);
+    fp.loadAttribute("trigger_channel",trigger_channel);
+    fp.loadAttribute("trigger_level",trigger_level);
+    std::string edge(rising?"rising":"falling"),mode(normal?"normal":"auto");
+    fp.loadAttribute("trigger_edge",edge);
+    fp.loadAttribute("trigger_mode",mode);
+    if(edge!="rising"&&edge!="falling") {std::cerr<<"Error: unknown trigger edge \""<<edge<<"\" (i.e. rising or falling).\n";return CODE_ERROR;}
+    if(mode!="auto"&&mode!="normal") {std::cerr<<"Error: unknown trigger mode \""<<mode<<"\" (i.e. auto or normal).\n";return CODE_ERROR;}
+    rising=(edge=="rising");normal=(mode=="normal");
+    if(width<2||frame_rate<=0) {std::cerr<<"Error: bad scope (width "<<width<<", frame rate "<<frame_rate<<").\n";return CODE_ERROR;}
+    return 0;
+  }
+
+  //! allocate history and start display thread
+  /**
+   * \param [in] DAQdev acquisition device (i.e. channel names, range and sampling rate)
+   * \param [in] physical published data are in physical unit (i.e. else levels)
+   **/
+  int start(const DAQdevice &DAQdev,bool physical)
+  {
+    const int channel_number=DAQdev.channel_index.size();
+    if(channel_number<1) return DIM_ERROR;
+    if(trigger_channel>=channel_number) {std::cerr<<"Error: trigger channel "<<trigger_channel<<" over "<<channel_number<<" channels.\n";return DIM_ERROR;}
+    name=DAQdev.channel_name;
+    sampling_rate=DAQdev.sampling_rate;
+    ymin=0.0f;ymax=(float)DAQdev.maxdata;
+    if(physical&&DAQdev.comedirange!=NULL) {ymin=DAQdev.comedirange->min;ymax=DAQdev.comedirange->max;}
+    if(ymax<=ymin) ymax=ymin+1.0f;
+    ///- history of a few sweeps (i.e. room for trigger search)
+    length=4*width;
+    history.assign(length,channel_number,1,1,0.0f);
+    sequence=0;position=0;
+    stopping=false;
+    if(pthread_create(&display,NULL,display_thread,this)!=0) {perror("pthread_create");return -1;}
+    running=true;
+    return 0;
+  }
+
+  //! publish a block of all channels (i.e. writer side, never waits)
+  template<typename T>
+  void publish(const cimg_library::CImgList<T> &data)
+  {
+    if(!running||data.is_empty()) return;
+    const long n=data[0].width();
+    const long first=(n>length)?n-length:0;//only the last samples are kept
+    ++sequence;//odd: writing
+    __sync_synchronize();
+    cimglist_for(data,c)
+    {
+      float *h=history.data(0,c);
+      const T *x=data[c].data();
+      for(long i=first,p=(position+first)%length;i<n;++i) {h[p]=(float)x[i];if(++p==length) p=0;}
+    }
+    position+=n;
+    __sync_synchronize();
+    ++sequence;//even: consistent
+  }
+
+  //! stop display thread (i.e. close its window)
+  void stop()
+  {
+    if(!running) return;
+    stopping=true;
+    pthread_join(display,NULL);
+    running=false;
+  }
+
+ private:
+  volatile unsigned long sequence;///< sequence lock of history (i.e. odd while writer copies a block)
+  volatile long position;         ///< number of samples published in each channel
+  long length;                    ///< number of samples of each channel in history
+  cimg_library::CImg<float> history;///< circular history of all channels (i.e. one line per channel)
+  std::vector<std::string> name;  ///< channel names
+  double sampling_rate;           ///< sampling rate (i.e. time in title)
+  float ymin,ymax;                ///< vertical range (i.e. physical or level range)
+  pthread_t display;              ///< display thread
+  bool running;                   ///< display thread is started
+  volatile bool stopping;         ///< display thread should end
+
+  //! copy consistent history (i.e. reader side of sequence lock)
+  /**
+   * \return false if the writer was always copying (i.e. frame skipped)
+   **/
+  bool snapshot(cimg_library::CImg<float> &copy,long &published) const
+  {
+    for(int retry=0;retry<16;++retry)
+    {
+      const unsigned long s0=sequence;
+      if(s0&1) {sched_yield();continue;}
+      __sync_synchronize();
+      published=position;
+      std::memcpy(copy.data(),history.data(),history.size()*sizeof(float));
+      __sync_synchronize();
+      if(sequence==s0) return true;
+    }
+    return false;
+  }
+
+  //! latest trigger in snapshot (i.e. sweep start in samples, -1 if none)
+  long trigger(const cimg_library::CImg<float> &copy,long published,long after) const
+  {
+    const long available=std::min(published,length),pre=width/10;
+    const float *x=copy.data(0,trigger_channel);
+    for(long t=published-width+pre;t>published-available+pre&&t-pre>after;--t)
+    {
+      const float a=x[(t-1)%length],b=x[t%length];
+      if(rising?(a<trigger_level&&b>=trigger_level):(a>trigger_level&&b<=trigger_level)) return t-pre;
+    }
+    return -1;
+  }
+
+  //! display thread entry point
+  static void* display_thread(void *arg)
+  {
+    DAQscope *scope=(DAQscope*)arg;
+    DAQthread::place(scope->placement,"scope");
+    try {scope->display_loop();}
+    catch(cimg_library::CImgException &e) {std::cerr<<"Warning: live scope not available ("<<e.what()<<")."<<std::endl;}
+    return NULL;
+  }
+
+  //! display loop: snapshot, find sweep, draw at capped frame rate
+  void display_loop()
+  {
+    const int W=1024,channel_height=std::max(64,512/(int)name.size()),H=channel_height*name.size();
+    const unsigned char colour[6][3]={{255,0,0},{0,160,0},{0,0,255},{200,120,0},{160,0,160},{0,140,140}};
+    const unsigned char grey[3]={192,192,192},black[3]={0,0,0};
+    const float sy=(channel_height-4)/(ymax-ymin);
+    ///- background (i.e. grid and trigger level, drawn once)
+    cimg_library::CImg<unsigned char> background(W,H,1,3,255),img;
+    for(int d=1;d<10;++d) background.draw_line(d*W/10,0,d*W/10,H-1,grey);
+    for(unsigned int c=0;c<name.size();++c)
+    {
+      const int top=c*channel_height;
+      background.draw_line(0,top,W-1,top,black);
+      background.draw_line(0,top+channel_height/2,W-1,top+channel_height/2,grey);
+      if((int)c==trigger_channel)
+      {
+        const int y=top+channel_height-2-(int)((trigger_level-ymin)*sy);
+        background.draw_line(0,y,W-1,y,colour[c%6],0.5f);
+      }
+    }
+    cimg_library::CImgDisplay disp(background,"live scope",0);
+    cimg_library::CImg<float> copy(history.width(),history.height());
+    long drawn=-1,sweep=-1,frame=0,skipped=0;
+    const unsigned int period=(unsigned int)(1000000.0f/frame_rate);
+    while(!stopping&&!disp.is_closed())
+    {
+      usleep(period);
+      long published;
+      if(!snapshot(copy,published)) {++skipped;continue;}
+      if(published==drawn||published<width) continue;//no new samples
+      ///- sweep start (i.e. free running, triggered or previous)
+      long start=published-width;
+      if(trigger_channel>=0)
+      {
+        const long t=trigger(copy,published,sweep);
+        if(t>=0) sweep=start=t;
+        else if(normal) continue;//keep previous sweep
+      }
+      drawn=published;
+      ///- traces (i.e. min-max of samples in each column)
+      img=background;
+      for(unsigned int c=0;c<name.size();++c)
+      {
+        const int top=c*channel_height;
+        const float *x=copy.data(0,c);
+        for(int px=0;px<W;++px)
+        {
+          const long s0=start+(long)width*px/W,s1=std::max(s0+1,start+(long)width*(px+1)/W);
+          float lo=x[s0%length],hi=lo;
+          for(long s=s0+1;s<s1&&s<start+width;++s) {const float v=x[s%length];lo=std::min(lo,v);hi=std::max(hi,v);}
+          img.draw_line(px,top+channel_height-2-(int)((lo-ymin)*sy),px,top+channel_height-2-(int)((hi-ymin)*sy),colour[c%6]);
+        }
+      }
+      disp.display(img);
+      disp.set_title("live scope: %g s (%s, frame %ld, %ld skipped)",start/sampling_rate,(trigger_channel<0)?"free running":((start==sweep)?"triggered":"auto"),++frame,skipped);
+    }
+  }
+};//DAQscope class
+
+#endif// DAQ_SCOPE
+
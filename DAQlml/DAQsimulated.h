@@ -0,0 +1,342 @@
+#ifndef DAQ_SIMULATED
+#define DAQ_SIMULATED
+
+#include <cmath>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+
+//! simulated acquisition device
+/**
+ * hardware-free backend (e.g. \c --fd \c sim ): a generator thread fills a memory ring (i.e. the mapped buffer) at the sampling rate of the command,
+ * with synthetic waveforms for each channel of the channel list (i.e. channel index and range), and stops after \c stop_arg scans.
+ * Point acquisition reads the waveforms at the present time.
+ * \note waveforms are set for each channel index from the \c simulation variable of the parameter file:
+ * \li \c waveform : \c square, \c sine or \c noise
+ * \li \c frequency, \c amplitude and \c offset : in Hz, volt and volt
+ * \li \c noise : amplitude of uniform noise added to all channels (in volt)
+ * \li \c buffer_size : size of the ring (in byte), \c tick : generator period (in microsecond), \c convert_min : minimum conversion time (in nanosecond)
+ * \li \c bits : resolution (e.g. 16 bit, or up to 32 bit as \c SDF_LSAMPL boards, i.e. \c lsampl_t samples)
+ * \li \c request_time : time spent by each point acquisition request, i.e. system call and board round trip (in nanosecond)
+ *
+ * a value is used for all channel indexes if only one value is given (e.g. \c noise ). Comedi buffer overflow is simulated when the ring is full (i.e. reader is late).
+ * \note there is no device file, so that waiting for data falls back on backoff (see \c DAQwakeup ); external trigger starts immediately.
+ * \see DAQbackend DAQdevice
+ **/
+class DAQsimulated : public DAQbackend
+{
+ public:
+  //parameters
+  std::vector<std::string> waveform; ///< waveform of each channel index (i.e. square, sine or noise)
+  std::vector<float> frequency;      ///< frequency of each channel index (in Hz)
+  std::vector<float> amplitude;      ///< amplitude of each channel index (in volt)
+  std::vector<float> offset;         ///< offset of each channel index (in volt)
+  float noise;                       ///< noise added to all channels (in volt)
+  int buffer_size;                   ///< ring size (in byte)
+  int tick;                          ///< generator period (in microsecond)
+  int convert_min;                   ///< minimum conversion time (in nanosecond)
+  int bits;                          ///< resolution (in bit)
+  lsampl_t maxdata;                  ///< maximum raw value (i.e. 2^bits-1)
+  int request_time;                  ///< time of a point acquisition request (in nanosecond)
+
+  //acquisition
+  std::string filename;              ///< device name
+  std::string error_message;         ///< last error
+  char *buffer;                      ///< ring (i.e. mapped buffer)
+  int bufsize;                       ///< ring size (in byte)
+  unsigned int chanlist[256];        ///< channel list of the command
+  int channel_number;                ///< number of channels in a scan
+  double period;                     ///< scan period (in second)
+  double cdelay;                     ///< delay between channels (in second)
+  bool continuous;                   ///< no scan count (i.e. \c TRIG_NONE stop)
+  unsigned long scan_number;         ///< number of scans to generate
+  volatile unsigned long written;    ///< number of bytes written in ring (generator thread only)
+  volatile unsigned long read;       ///< number of bytes marked as read (reader only)
+  volatile int overflow;             ///< ring was full (i.e. reader is late)
+  volatile int stop;                 ///< generator thread should stop
+  pthread_t generator;               ///< generator thread
+  bool generator_running;            ///< generator thread is started
+  double open_time;                  ///< time at open (i.e. point acquisition origin)
+  unsigned int seed;                 ///< noise generator state
+  unsigned long request_count;       ///< number of point acquisition requests (i.e. system calls of a board)
+
+  //! constructor
+  DAQsimulated()
+  {
+    waveform.push_back("square");waveform.push_back("sine");waveform.push_back("noise");
+    frequency.push_back(1000.0f);
+    amplitude.push_back(5.0f);
+    offset.push_back(0.0f);
+    noise=0.0f;
+    buffer_size=1048576;
+    tick=100;
+    convert_min=10;
+    bits=16;
+    maxdata=65535;
+    request_time=2000;
+    buffer=NULL;bufsize=0;
+    channel_number=0;period=cdelay=0.0;continuous=false;scan_number=0;
+    written=read=0;overflow=stop=0;
+    generator_running=false;
+    open_time=0.0;seed=2463534242u;
+    request_count=0;
+  }
+  ~DAQsimulated() {close();}
+
+  //! load waveform parameters from file
+  /**
+   * load waveform parameters as attributes of the \c simulation variable of the NetCDF parameter file,
+   * default values are kept for missing parameters.
+   * \param [in] file_name NetCDF/CDL parameter file name (e.g. "parameters.nc")
+   **/
+  int load_parameter(const std::string file_name)
+  {
+    CParameterNetCDF fp;
+    int error=fp.loadFile((char *)file_name.c_str());
+    if(error){std::cerr<<"loadFile return "<< error <<std::endl;return error;}
+    int process;
+    std::string process_name="simulation";
+    if((error=fp.loadVar(process,&process_name))){std::cerr<<"Warning: process variable \""<<process_name<<"\" can not be loaded (return value is "<<error<<"), using default waveforms.\n";return 0;}
+    fp.loadAttribute("waveform",waveform);
+    fp.loadAttribute("frequency",frequency);
+    fp.loadAttribute("amplitude",amplitude);
+    fp.loadAttribute("offset",offset);
+    fp.loadAttribute("noise",noise);
+    fp.loadAttribute("buffer_size",buffer_size);
+    fp.loadAttribute("tick",tick);
+    fp.loadAttribute("convert_min",convert_min);
+    fp.loadAttribute("bits",bits);
+    fp.loadAttribute("request_time",request_time);
+    return 0;
+  }
+
+  int open(const std::string device_name)
+  {
+    filename=device_name;
+    open_time=now();
+    if(waveform.empty()||frequency.empty()||amplitude.empty()||offset.empty()) {error_message="empty waveform parameter";return -1;}
+    if(bits<1||bits>32) {error_message="bad resolution";return -1;}
+    maxdata=(bits==32)?0xffffffffu:(lsampl_t)((1u<<bits)-1);
+    for(unsigned int i=0;i<waveform.size();++i)
+      if(waveform[i]!="square"&&waveform[i]!="sine"&&waveform[i]!="noise") {error_message="unknown waveform \""+waveform[i]+"\"";return -1;}
+    return 0;
+  }
+  int close()
+  {
+    if(generator_running)
+    {
+      stop=1;
+      pthread_join(generator,NULL);
+      generator_running=false;
+    }
+    if(buffer!=NULL) {munmap(buffer,bufsize);buffer=NULL;}
+    return 0;
+  }
+  void perror(const char *s) {std::cerr<<s<<": "<<error_message<<std::endl;}
+  int fileno() {return -1;}
+
+  int get_version_code() {return 0;}
+  const char* get_driver_name() {return "DAQlml";}
+  const char* get_board_name() {return "simulated";}
+  int get_subdevice_type(int subdevice) {return (subdevice==0)?COMEDI_SUBD_AI:COMEDI_SUBD_UNUSED;}
+  int get_subdevice_flags(int /*subdevice*/) {return SDF_READABLE|SDF_CMD|SDF_GROUND|SDF_DIFF|((bits>16)?SDF_LSAMPL:0);}
+  lsampl_t get_maxdata(int /*subdevice*/,int /*channel*/) {return maxdata;}
+  //! ranges as for most boards, e.g. \c range_id=0 for [-10..+10] volts
+  comedi_range* get_range(int /*subdevice*/,int /*channel*/,int range)
+  {
+    static comedi_range table[]={{-10.0,10.0,UNIT_volt},{-5.0,5.0,UNIT_volt},{-1.0,1.0,UNIT_volt},{-0.2,0.2,UNIT_volt}};
+    if(range<0||range>3) {error_message="bad range";return NULL;}
+    return table+range;
+  }
+
+  //! ring size (i.e. \c buffer_size rounded to pages)
+  int get_buffer_size(int /*subdevice*/)
+  {
+    const int page=sysconf(_SC_PAGESIZE);
+    return ((buffer_size+page-1)/page)*page;
+  }
+  void* map_buffer(int size)
+  {
+    close();
+    void *map=mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    if(map==MAP_FAILED) {error_message="can not allocate ring";return map;}
+    buffer=(char*)map;bufsize=size;
+    return map;
+  }
+  //! check and adjust command arguments
+  /**
+   * \return 0 if command is valid, 4 if arguments were adjusted (as comedi)
+   **/
+  int command_test(comedi_cmd *cmd)
+  {
+    int ret=0;
+    if(cmd->chanlist_len<1||cmd->chanlist_len>256||cmd->scan_begin_arg==0) {error_message="bad command";return 3;}
+    if(cmd->convert_src==TRIG_TIMER)
+    {
+      if(cmd->convert_arg<(unsigned int)convert_min) {cmd->convert_arg=convert_min;ret=4;}
+      if(cmd->convert_arg*cmd->chanlist_len>cmd->scan_begin_arg) {cmd->scan_begin_arg=cmd->convert_arg*cmd->chanlist_len;ret=4;}
+    }
+    return ret;
+  }
+  //! start generator thread
+  int command(comedi_cmd *cmd)
+  {
+    if(buffer==NULL) {error_message="buffer is not mapped";return -1;}
+    if(generator_running) {error_message="device is busy";return -1;}
+    channel_number=cmd->chanlist_len;
+    for(int c=0;c<channel_number;++c) chanlist[c]=cmd->chanlist[c];
+    for(int c=0;c<channel_number;++c) if(get_range(0,0,CR_RANGE(chanlist[c]))==NULL) return -1;
+    period=1e-9*cmd->scan_begin_arg;
+    cdelay=(cmd->convert_src==TRIG_TIMER)?1e-9*cmd->convert_arg:0.0;
+    continuous=(cmd->stop_src!=TRIG_COUNT);
+    scan_number=cmd->stop_arg;
+    written=read=0;overflow=stop=0;
+    if(pthread_create(&generator,NULL,generator_thread,this)!=0) {error_message="can not start generator thread";return -1;}
+    generator_running=true;
+    return 0;
+  }
+  int get_buffer_contents(int /*subdevice*/)
+  {
+    if(overflow) {error_message="buffer overflow";return -1;}
+    return (int)(written-read);
+  }
+  int mark_buffer_read(int /*subdevice*/,int bytes)
+  {
+    if(bytes<0||(unsigned long)bytes>written-read) {error_message="bad number of bytes";return -1;}
+    __sync_synchronize();
+    read=read+bytes;
+    return bytes;
+  }
+
+  //! read the waveform at present time
+  int data_read_delayed(int /*subdevice*/,int channel,int range,int /*aref*/,lsampl_t *data,int /*nano_sec*/)
+  {
+    comedi_range *r=get_range(0,0,range);
+    if(r==NULL) return -1;
+    const double t=request();
+    *data=sample(channel,r,t);
+    return 1;
+  }
+  //! do read and wait instructions at present time (i.e. a single request)
+  int do_insnlist(comedi_insnlist *list)
+  {
+    double t=request();
+    for(unsigned int i=0;i<list->n_insns;++i)
+    {
+      comedi_insn &insn=list->insns[i];
+      switch(insn.insn)
+      {
+        case INSN_READ:
+        {
+          comedi_range *r=get_range(0,0,CR_RANGE(insn.chanspec));
+          if(r==NULL) return (i==0)?-1:(int)i;
+          for(unsigned int n=0;n<insn.n;++n) insn.data[n]=sample(CR_CHAN(insn.chanspec),r,t);
+          break;
+        }
+        case INSN_WAIT:
+          if(insn.n>0) t+=1e-9*insn.data[0];
+          break;
+        default:
+          error_message="unsupported instruction";
+          return (i==0)?-1:(int)i;
+      }
+    }
+    return list->n_insns;
+  }
+
+ private:
+  //! monotonic time (in second)
+  static double now()
+  {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec+t.tv_nsec*1e-9;
+  }
+  //! point acquisition request (i.e. counted, and busy for \c request_time as a system call)
+  /**
+   * \return time of the request (in second, from open)
+   **/
+  double request()
+  {
+    ++request_count;
+    const double start=now();
+    if(request_time>0) while(now()-start<1e-9*request_time);
+    return start-open_time;
+  }
+  //! uniform noise in [-1,1]
+  double uniform()
+  {//xorshift
+    seed^=seed<<13;seed^=seed>>17;seed^=seed<<5;
+    return seed*(2.0/4294967295.0)-1.0;
+  }
+  //! raw value of channel index at time
+  lsampl_t sample(int channel,const comedi_range *r,double t)
+  {
+    const std::string &w=waveform[channel%waveform.size()];
+    const double f=frequency[channel%frequency.size()];
+    const double a=amplitude[channel%amplitude.size()];
+    double v=offset[channel%offset.size()];
+    if(w=="square") {double phase=t*f;v+=(phase-floor(phase)<0.5)?a:-a;}
+    else if(w=="sine") v+=a*sin(2.0*M_PI*f*t);
+    else v+=a*uniform();
+    if(noise>0.0f) v+=noise*uniform();
+    double raw=(v-r->min)/(r->max-r->min)*maxdata+0.5;
+    if(raw<0.0) return 0;
+    if(raw>maxdata) return maxdata;
+    return (lsampl_t)raw;
+  }
+
+  //! generator thread entry point
+  static void* generator_thread(void *arg)
+  {
+    ((DAQsimulated*)arg)->generate();
+    return NULL;
+  }
+  //! generator loop: write the scans due at present time, then sleep a tick
+  void generate()
+  {
+    const int sample_bytes=(bits>16)?sizeof(lsampl_t):sizeof(sampl_t);
+    const int scan_bytes=channel_number*sample_bytes;
+    int position=0;          // write position in ring (in byte)
+    unsigned long scans=0;   // number of scans written
+    comedi_range *r[256];
+    for(int c=0;c<channel_number;++c) r[c]=get_range(0,0,CR_RANGE(chanlist[c]));
+    const double start=now();
+    while(!stop&&(continuous||scans<scan_number))
+    {
+      double due=(now()-start)/period;
+      if(!continuous&&due>scan_number) due=scan_number;
+      unsigned long n=(unsigned long)due-scans;
+      if(n>0)
+      {
+        if((written-read)+n*scan_bytes>(unsigned long)bufsize) {overflow=1;break;}
+        for(unsigned long s=scans;s<scans+n;++s)
+          for(int c=0;c<channel_number;++c)
+          {
+            const lsampl_t value=sample(CR_CHAN(chanlist[c]),r[c],s*period+c*cdelay);
+            if(sample_bytes==sizeof(sampl_t)) *(sampl_t*)(buffer+position)=value;
+            else *(lsampl_t*)(buffer+position)=value;
+            position=(position+sample_bytes)%bufsize;
+          }
+        scans+=n;
+        //samples must be visible before the counter
+        __sync_synchronize();
+        written=written+n*scan_bytes;
+      }
+      usleep(tick);
+    }//generator loop
+  }
+};//DAQsimulated class
+
+//! create the backend of a device
+/**
+ * \param [in] filename device file name, \c sim for the simulated device (e.g. \c --fd \c sim )
+ **/
+inline DAQbackend* DAQbackend_new(const std::string filename)
+{
+  if(filename.compare(0,3,"sim")==0) return new DAQsimulated;
+  return new DAQbackend_comedi;
+}
+
+#endif// DAQ_SIMULATED
+
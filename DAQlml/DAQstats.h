@@ -0,0 +1,212 @@
+#ifndef DAQ_STATS
+#define DAQ_STATS
+
+#include <cmath>
+
+//! online channel statistics
+/**
+ * one-pass statistics of each channel, updated block by block while acquiring (i.e. no pass over the whole data after acquisition):
+ * mean and variance (i.e. Welford algorithm, blocks merged by their count, mean and sum of squared deviations),
+ * minimum, maximum, RMS and clipping counts (i.e. samples at level 0 or \c maxdata ).
+ * Statistics are accumulated on levels, then given in physical unit (i.e. affine range of each channel) if \c physical .
+ *
+ * For 16 bit levels, sums of a block are exact integers (i.e. sum and sum of squares, vectorized by the compiler),
+ * so that the block variance has no cancellation; larger levels use a two-pass block in double precision.
+ * \note counters may be read by another thread at any time (e.g. live monitoring), values being those of the last block.
+ *
+ * \code
+ *   DAQstats stats;
+ *   stats.assign(DAQdev,true);
+ *   stats.add(data[c].data(),n,c);//for each block of each channel
+ *   stats.print(std::cout,DAQdev);
+ * \endcode
+ * \see DAQwriter
+ **/
+class DAQstats
+{
+ public:
+  bool physical;                ///< statistics in physical unit (i.e. else in levels)
+  lsampl_t maxdata;             ///< maximum level (i.e. clipping level)
+  std::vector<long> count;      ///< number of samples of each channel
+  std::vector<double> level_mean; ///< mean of each channel (in level)
+  std::vector<double> m2;       ///< sum of squared deviations from mean of each channel (in level^2)
+  std::vector<double> minimum;  ///< minimum of each channel (in level)
+  std::vector<double> maximum;  ///< maximum of each channel (in level)
+  std::vector<long> clip_low;   ///< number of samples at level 0 of each channel
+  std::vector<long> clip_high;  ///< number of samples at level \c maxdata of each channel
+  std::vector<double> scale;    ///< physical step of each channel
+  std::vector<double> offset;   ///< physical value of level 0 of each channel
+
+  //! constructor
+  DAQstats() {physical=false;maxdata=0;}
+
+  //! number of channels
+  int size() const {return count.size();}
+
+  //! set up channels (i.e. all with the device range) and clear statistics
+  /**
+   * \param [in] DAQdev acquisition device (i.e. channels, range and maxdata)
+   * \param [in] phys statistics in physical unit
+   **/
+  int assign(const DAQdevice &DAQdev,bool phys)
+  {
+    const int channel_number=DAQdev.channel_index.size();
+    if(channel_number<1) return DIM_ERROR;
+    maxdata=DAQdev.maxdata;
+    physical=phys;
+    count.assign(channel_number,0);
+    level_mean.assign(channel_number,0.0);m2.assign(channel_number,0.0);
+    minimum.assign(channel_number,0.0);maximum.assign(channel_number,0.0);
+    clip_low.assign(channel_number,0);clip_high.assign(channel_number,0);
+    scale.assign(channel_number,1.0);offset.assign(channel_number,0.0);
+    for(int c=0;c<channel_number;++c) range(c,DAQdev.comedirange);
+    return 0;
+  }
+
+  //! set physical range of channel \c c (e.g. boards with different ranges)
+  void range(int c,const comedi_range *r)
+  {
+    if(r==NULL||maxdata==0) return;
+    offset[c]=r->min;
+    scale[c]=(r->max-r->min)/(double)maxdata;
+  }
+
+  //! add a block of levels of channel \c c
+  /**
+   * \param [in] x levels (e.g. \c sampl_t , or levels in physical type before conversion)
+   * \param [in] n number of samples
+   * \param [in] c channel (i.e. position in the channel list)
+   **/
+  template<typename T>
+  void add(const T *x,long n,int c)
+  {
+    if(n<1) return;
+    if(maxdata<=65535)
+    {///- 16 bit levels: exact integer sums by chunks (i.e. n*sum(x^2) below 2^64)
+      for(long s=0;s<n;s+=STATS_CHUNK) add16(x+s,std::min((long)STATS_CHUNK,n-s),c);
+      return;
+    }
+    ///- larger levels: two passes on block in double precision
+    double sum=0.0,lo=(double)x[0],hi=lo;
+    long low=0,high=0;
+    const double top=(double)maxdata;
+    for(long i=0;i<n;++i)
+    {
+      const double v=(double)x[i];
+      sum+=v;
+      lo=(v<lo)?v:lo;hi=(v>hi)?v:hi;
+      low+=(v==0);high+=(v==top);
+    }
+    const double mean=sum/n;
+    double d2=0.0;
+    for(long i=0;i<n;++i) {const double d=(double)x[i]-mean;d2+=d*d;}
+    merge(c,n,mean,d2,lo,hi,low,high);
+  }
+
+  //! add a block of all channels (i.e. one image per channel, same width)
+  template<typename T>
+  void add(const cimg_library::CImgList<T> &data)
+  {
+    cimglist_for(data,c) add(data[c].data(),data[c].width(),c);
+  }
+
+  //! mean of channel \c c
+  double mean(int c) const {return phys(c,level_mean[c]);}
+  //! variance of channel \c c (i.e. unbiased estimator, as \c CImg::variance )
+  double variance(int c) const
+  {
+    if(count[c]<2) return 0.0;
+    const double s=physical?scale[c]:1.0;
+    return s*s*m2[c]/(double)(count[c]-1);
+  }
+  //! minimum of channel \c c
+  double min(int c) const {return phys(c,minimum[c]);}
+  //! maximum of channel \c c
+  double max(int c) const {return phys(c,maximum[c]);}
+  //! root mean square of channel \c c
+  double rms(int c) const
+  {
+    if(count[c]<1) return 0.0;
+    const double s=physical?scale[c]:1.0;
+    const double m=mean(c);
+    return std::sqrt(m*m+s*s*m2[c]/(double)count[c]);
+  }
+
+  //! print statistics of all channels
+  void print(std::ostream &stream,const DAQdevice &DAQdev) const
+  {
+    for(int c=0;c<size();++c)
+    {
+      stream<<"chan-"<<DAQdev.channel_index[c]<<": "<<DAQdev.channel_name[c]<<", mean: "<<mean(c)<<", min: "<<min(c)<<", max: "<<max(c)
+        <<", var: "<<variance(c)<<", rms: "<<rms(c);
+      if(clip_low[c]+clip_high[c]>0) stream<<", clipped: "<<clip_low[c]<<" low "<<clip_high[c]<<" high";
+      stream<<std::endl;
+    }
+  }
+
+  //! write statistics as attributes of data variables (i.e. in data unit)
+  /**
+   * \c mean , \c variance , \c minimum , \c maximum , \c rms , \c clip_count (i.e. at level 0 and at \c maxdata ) and \c statistics_count (i.e. number of samples)
+   * \note attributes have the same size whatever the values, so that writing them again at close does not move data (see \c DAQwriter );
+   * counts are written as double (i.e. exact up to 2^53 samples, no overflow on long streaming runs).
+   **/
+  int save(const std::vector<NcVar*> &vars) const
+  {
+    if((int)vars.size()!=size()) return DIM_ERROR;
+    for(int c=0;c<size();++c)
+    {
+      NcVar *v=vars[c];
+      double clip[2];clip[0]=(double)clip_low[c];clip[1]=(double)clip_high[c];
+      if(!v->add_att("mean",mean(c))) return NC_ERROR;
+      if(!v->add_att("variance",variance(c))) return NC_ERROR;
+      if(!v->add_att("minimum",min(c))) return NC_ERROR;
+      if(!v->add_att("maximum",max(c))) return NC_ERROR;
+      if(!v->add_att("rms",rms(c))) return NC_ERROR;
+      if(!v->add_att("clip_count",2,clip)) return NC_ERROR;
+      if(!v->add_att("statistics_count",(double)count[c])) return NC_ERROR;
+    }
+    return 0;
+  }
+
+ private:
+  //! samples in an exact chunk (i.e. n*sum(x^2) and sum(x)^2 below 2^64: 2^14 x 2^14 x 2^32)
+  enum {STATS_CHUNK=16384};
+
+  //! level in physical unit (if \c physical )
+  double phys(int c,double level) const {return physical?offset[c]+scale[c]*level:level;}
+
+  //! add a chunk of 16 bit levels (i.e. integer sums, vectorized)
+  template<typename T>
+  void add16(const T *x,long n,int c)
+  {
+    unsigned long s1=0,s2=0,low=0,high=0;
+    unsigned int lo=65535,hi=0;
+    const unsigned int top=maxdata;
+    for(long i=0;i<n;++i)
+    {
+      const unsigned int v=(unsigned int)x[i];
+      s1+=v;s2+=v*v;
+      lo=(v<lo)?v:lo;hi=(v>hi)?v:hi;
+      low+=(v==0);high+=(v==top);
+    }
+    ///- exact block sum of squared deviations: (n*s2-s1^2)/n
+    const double d2=(double)(n*s2-s1*s1)/(double)n;
+    merge(c,n,(double)s1/(double)n,d2,lo,hi,low,high);
+  }
+
+  //! merge block statistics into channel \c c (i.e. Chan et al. update of Welford mean and sum of squared deviations)
+  void merge(int c,long n,double mean,double d2,double lo,double hi,long low,long high)
+  {
+    const long na=count[c],nt=na+n;
+    const double delta=mean-level_mean[c];
+    if(na==0) {minimum[c]=lo;maximum[c]=hi;}
+    else {minimum[c]=(lo<minimum[c])?lo:minimum[c];maximum[c]=(hi>maximum[c])?hi:maximum[c];}
+    level_mean[c]+=delta*(double)n/(double)nt;
+    m2[c]+=d2+delta*delta*(double)na*(double)n/(double)nt;
+    clip_low[c]+=low;clip_high[c]+=high;
+    count[c]=nt;
+  }
+};//DAQstats class
+
+#endif// DAQ_STATS
+
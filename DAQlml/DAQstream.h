@@ -0,0 +1,251 @@
+#ifndef DAQ_STREAM
+#define DAQ_STREAM
+
+#include <pthread.h>
+
+#ifndef LOOP_USLEEP_TIME
+//! waiting time for the buffer
+#define LOOP_USLEEP_TIME 100
+#endif
+
+//! streaming acquisition
+/**
+ * streaming acquisition for unbounded-duration runs: the acquisition thread only drains the comedi buffer into a ring of scan blocks (see \c sample_data_stream ),
+ * while a writer thread converts and saves the blocks into the NetCDF file (see \c DAQwriter ).
+ * Memory is then bounded by the ring size and acquisition does not wait for I/O.
+ * \note parameters are loaded from the \c stream variable of the parameter file (e.g. \c block_size , \c ring_size , \c append , \c flush_period , \c rotate_size and \c rotate_duration attributes)
+ * \note with \c rotate_size or \c rotate_duration , output rotates into numbered files listed in a manifest (e.g. \c data.0000.nc , ... and \c data.manifest , see \c DAQrotate )
+ *
+ * \code
+ *   DAQstream<sampl_t> stream;
+ *   stream.load_parameter("parameters.nc");
+ *   stream.start(DAQdev,"data.nc",true,true);
+ *   sample_data_stream(stream,map,DAQdev);
+ *   stream.stop();
+ * \endcode
+ *
+ * \see DAQring DAQwriter DAQrotate sample_data_stream
+ **/
+template<typename Traw>
+class DAQstream
+{
+ public:
+  int verbose;     ///< verbose option
+  int block_size;  ///< number of scans in a block
+  int ring_size;   ///< number of blocks in the ring
+  bool unlimited;  ///< append blocks as records of the unlimited time dimension
+  float flush_period;///< time between two flushes of the file to disk (in second; 0: at close only)
+  float rotate_size;    ///< rotate output into numbered files of this data size (in MB; 0: no size limit, see \c DAQrotate )
+  float rotate_duration;///< rotate output into numbered files of this duration (in second; 0: no time limit)
+  DAQring<Traw> ring;///< blocks of interleaved scans from acquisition to writer thread
+
+  DAQdevice *pDAQdev;   ///< acquisition device (i.e. channels, ranges, ...)
+  std::string file_name;///< output data file name
+  bool conv_phys;       ///< convert binary data into physical voltage
+  bool packed;          ///< store raw levels in 16 bit with \c scale_factor and \c add_offset (i.e. no conversion, see \c DAQwriter::packed )
+  bool time_axis;       ///< write legacy time variables
+
+  pthread_t writer;     ///< writer thread
+  RT_placement placement;///< core and scheduling of writer thread (i.e. placed by itself, see \c DAQthread )
+  bool writer_running;  ///< writer thread is started
+  int writer_error;     ///< writer thread return value
+  unsigned long block_written;///< number of blocks written in file
+  DAQstats stats;       ///< channel statistics (i.e. updated with each block, written at close)
+  DAQpyramid pyramid;   ///< envelope pyramid (i.e. updated with each block, written at close if \c pyramid.save_file )
+  DAQscope *scope;      ///< live oscilloscope (i.e. each block published; none if NULL)
+  DAQtest *test;        ///< square wave analysis of each block (i.e. analyzers set up; none if NULL)
+  double write_time;    ///< time spent in conversion and writing (in second)
+
+  //! constructor
+  DAQstream()
+  {
+    verbose=0;
+    block_size=4096;
+    ring_size=256;
+    unlimited=true;
+    flush_period=1.0f;
+    rotate_size=rotate_duration=0.0f;
+    placement.policy=-1;
+    test=NULL;scope=NULL;
+    pDAQdev=NULL;
+    conv_phys=true;time_axis=true;packed=false;
+    writer_running=false;writer_error=0;
+    block_written=0;write_time=0.0;
+  }
+
+  //! load streaming parameters from file
+  /**
+   * load streaming parameters as attributes of the \c stream variable of the NetCDF parameter file,
+   * default values are kept for missing parameters (e.g. old parameter file).
+   * \param [in] file_name NetCDF/CDL parameter file name (e.g. "parameters.nc")
+   **/
+  int load_parameter(const std::string file_name)
+  {
+    //NetCDF/CDL parameter file object (i.e. parameter class)
+    CParameterNetCDF fp;
+    ///open file from its name
+    int error=fp.loadFile((char *)file_name.c_str());
+    if(error){std::cerr<<"loadFile return "<< error <<std::endl;return error;}
+    ///open stream variable (i.e. process variable)
+    int process;
+    std::string process_name="stream";
+    if((error=fp.loadVar(process,&process_name))){std::cerr<<"Warning: process variable \""<<process_name<<"\" can not be loaded (return value is "<<error<<"), using default streaming parameters.\n";return 0;}
+    ///load attributes (i.e. process parameters)
+    fp.loadAttribute("block_size",block_size);
+    fp.loadAttribute("ring_size",ring_size);
+    int append=unlimited;
+    fp.loadAttribute("append",append);unlimited=(append!=0);
+    fp.loadAttribute("flush_period",flush_period);
+    fp.loadAttribute("rotate_size",rotate_size);
+    fp.loadAttribute("rotate_duration",rotate_duration);
+    return 0;
+  }
+
+  //! allocate ring and start writer thread
+  /**
+   * \param [in] DAQdev acquisition device (i.e. configured)
+   * \param [in] fo output data file name
+   * \param [in] physical convert binary data into physical voltage
+   * \param [in] time write legacy time variables (i.e. time axis is implicit otherwise)
+   **/
+  int start(DAQdevice &DAQdev,std::string fo,bool physical,bool time)
+  {
+    pDAQdev=&DAQdev;
+    file_name=fo;conv_phys=physical;time_axis=time;
+    verbose=DAQdev.verbose;
+    int channel_number=DAQdev.channel_index.size();
+    if(ring.assign(ring_size,block_size*channel_number)) {std::cerr<<"Error: bad ring size ("<<ring_size<<" blocks of "<<block_size<<" scans)."<<std::endl;return -1;}
+    std::cout<<"streaming with "<<ring_size<<" blocks of "<<block_size<<" scans ("<<ring_size*block_size*channel_number*sizeof(Traw)/1024<<" kB)."<<std::endl;
+    block_written=0;write_time=0.0;writer_error=0;
+    if(pthread_create(&writer,NULL,writer_thread,this)!=0) {perror("pthread_create");return -1;}
+    writer_running=true;
+    return 0;
+  }
+
+  //! wait for writer thread to save all blocks
+  /**
+   * \return writer thread error (i.e. 0 if all blocks were written)
+   **/
+  int stop()
+  {
+    ring.finish();
+    if(writer_running) pthread_join(writer,NULL);
+    writer_running=false;
+    ring.print(std::cout);
+    std::cout<<block_written<<" blocks written in "<<write_time<<" sec"<<std::endl;
+    if(pDAQdev!=NULL&&stats.size()>0) stats.print(std::cout,*pDAQdev);
+    return writer_error;
+  }
+
+ private:
+  //! writer thread entry point
+  static void* writer_thread(void *arg)
+  {
+    DAQstream<Traw> *stream=(DAQstream<Traw>*)arg;
+    DAQthread::place(stream->placement,"writer");
+    if(stream->packed)         stream->writer_error=stream->template write_loop<short>("volt");
+    else if(stream->conv_phys) stream->writer_error=stream->template write_loop<float>("volt");
+    else                       stream->writer_error=stream->template write_loop<int>("16 bit binary");
+    //drain ring on error, so that acquisition never waits
+    int n;
+    while(!stream->ring.is_finished())
+    {
+      if(stream->ring.read_block(n)!=NULL) stream->ring.release_read();
+      else usleep(LOOP_USLEEP_TIME);
+    }
+    return NULL;
+  }
+
+  //! writer loop: get blocks from ring, then convert and write them
+  template<typename Tdata>
+  int write_loop(const std::string data_unit_name)
+  {
+    int error;
+    DAQdevice &DAQdev=*pDAQdev;
+    int channel_number=DAQdev.channel_index.size();
+    ///create file structure
+    DAQrotate<Tdata,double> fo;
+    fo.unlimited=unlimited;
+    fo.max_bytes=rotate_size*1e6;fo.max_duration=rotate_duration;
+    fo.packed=packed;
+    if((error=stats.assign(DAQdev,conv_phys||packed))) return error;
+    fo.stats=&stats;
+    if((error=pyramid.assign(DAQdev,DAQdev.sample_number,conv_phys||packed))) return error;
+    if(pyramid.save_file) fo.pyramid=&pyramid;
+    int acqu_range_min=0,acqu_range_max=DAQdev.maxdata;std::string acqu_range_unit("level");
+    float phys_range_min=DAQdev.comedirange->min,phys_range_max=DAQdev.comedirange->max;std::string phys_range_unit("volt");
+    if((error=fo.open(file_name,DAQdev,DAQdev.sample_number,time_axis,data_unit_name,
+      acqu_range_min,acqu_range_max,acqu_range_unit,phys_range_min,phys_range_max,phys_range_unit)))
+    {
+      std::cerr<<"Error: can not create \""<<file_name<<"\" (return value is "<<error<<")."<<std::endl;
+      return error;
+    }
+    ///conversion engine (i.e. ranges computed once), in place on blocks if levels are exact in data type
+    DAQconvert<Tdata> conv;conv.threads=1;
+    if(conv_phys&&(error=conv.assign(DAQdev))) {fo.close();return error;}
+    const bool in_place=conv_phys&&((double)DAQdev.maxdata<=1.0/std::numeric_limits<Tdata>::epsilon());
+    ///write blocks while acquiring
+    cimg_library::CImgList<Traw> data(channel_number,block_size);
+    cimg_library::CImgList<Tdata> data_out;
+    cimg_library::CImgList<double> time;
+    double flushed=getETime();
+    while(!ring.is_finished())
+    {
+      int sample_count;
+      Traw *block=ring.read_block(sample_count);
+      if(block==NULL) {usleep(LOOP_USLEEP_TIME);continue;}
+      double st=getETime();
+      ////de-interleave scans
+      int scan_count=sample_count/channel_number;
+      if(in_place)
+      {//levels in physical type, then converted in place
+        if(data_out.size()!=(unsigned int)channel_number||data_out[0].width()!=scan_count) data_out.assign(channel_number,scan_count);
+        Tdata *plane[256];
+        for(int c=0;c<channel_number;++c) plane[c]=data_out[c].data();
+        deinterleave(block,scan_count,channel_number,plane);
+        ring.release_read();
+        stats.add(data_out);
+        pyramid.add(data_out);
+        conv.convert(data_out,data_out);
+      }
+      else
+      {
+        if(data[0].width()!=scan_count) data.assign(channel_number,scan_count);
+        Traw *plane[256];
+        for(int c=0;c<channel_number;++c) plane[c]=data[c].data();
+        deinterleave(block,scan_count,channel_number,plane);
+        ring.release_read();
+        stats.add(data);
+        pyramid.add(data);
+        if(conv_phys) conv.convert(data,data_out);
+      }
+      ////square wave analysis
+      if(test!=NULL) {if(conv_phys) test->sqwave_add(data_out);else test->sqwave_add(data);}
+      ////live view
+      if(scope!=NULL) {if(conv_phys) scope->publish(data_out);else scope->publish(data);}
+      ////write (and legacy time)
+      if(time_axis) fo.time.get(time,fo.sample_count,scan_count);
+      if(conv_phys) error=fo.write(data_out,time);
+      else error=fo.write(data,time);//raw samples widened to file type
+      if(error)
+      {
+        std::cerr<<"Error: can not write block "<<block_written<<" in \""<<file_name<<"\" (return value is "<<error<<")."<<std::endl;
+        fo.close();
+        return error;
+      }
+      ++block_written;
+      ////flush (i.e. written records and their number are on disk)
+      if(flush_period>0&&st-flushed>=flush_period)
+      {
+        if((error=fo.sync())) {std::cerr<<"Error: can not flush \""<<file_name<<"\" (return value is "<<error<<")."<<std::endl;fo.close();return error;}
+        flushed=st;
+      }
+      write_time+=getETime()-st;
+    }
+    if(!pyramid.save_file) pyramid.finish();
+    return fo.close();
+  }
+};//DAQstream class
+
+#endif// DAQ_STREAM
+
@@ -5,6 +5,131 @@
 //! \todo [low] add sinus test
 #define TEST_SINWAVE 2
 
+//! streaming square wave analyzer of a channel
+/**
+ * edges are detected sample by sample with hysteresis (i.e. rising above \c threshold_high , falling below \c threshold_low ),
+ * then durations (in samples) are counted in fixed size histograms: duration up (rising to falling), duration down (falling to rising),
+ * period (rising to rising) and duty cycle (i.e. up over period, bins of one sample of the reference period).
+ * Memory does not depend on the number of samples (i.e. blocks of any size are given to \c add ), so that long captures are analysed while acquiring.
+ * \note durations longer than the histogram are counted as overflow; edges of incomplete cycles at borders are not counted (as \c detect_edges with borders).
+ * \see DAQtest::sqwave_add
+ **/
+class DAQsqwave
+{
+ public:
+  double threshold_low;  ///< falling edge level (in data unit)
+  double threshold_high; ///< rising edge level (in data unit)
+  long position;         ///< index of next sample
+  int state;             ///< current level (i.e. 1: high, 0: low, -1: unknown before first sample)
+  long last_rising;      ///< position of last rising edge (-1: none)
+  long last_falling;     ///< position of last falling edge (-1: none)
+  std::vector<unsigned long> up;     ///< histogram of duration up (in samples)
+  std::vector<unsigned long> down;   ///< histogram of duration down (in samples)
+  std::vector<unsigned long> period; ///< histogram of period (in samples)
+  std::vector<unsigned long> dc;     ///< histogram of duty cycle (i.e. \c dc.size()-1 bins between 0 and 1)
+  unsigned long overflow;            ///< number of durations longer than histograms
+  long reference_period;             ///< reference period (in samples; 0: no error detection)
+  double tolerance;                  ///< relative tolerance of period (e.g. 0.01 for 1%)
+  unsigned long error_count;         ///< number of periods out of tolerance
+  std::vector<long> errors;          ///< first rising edges of periods out of tolerance (i.e. at most \c max_errors )
+  unsigned int max_errors;           ///< maximum number of error positions kept
+
+  //! constructor
+  DAQsqwave() {assign(2.5,0.0,1024,64);}
+
+  //! set up analyzer and clear histograms
+  /**
+   * \param [in] threshold edge level (in data unit, e.g. 2.5 volt for TTL)
+   * \param [in] hysteresis width of hysteresis around \c threshold (in data unit; 0: single threshold)
+   * \param [in] size histogram size (i.e. longest duration in samples, e.g. a few reference periods)
+   * \param [in] dc_bins number of duty cycle bins (e.g. reference period in samples)
+   * \param [in] ref_period reference period (in samples; 0: no error detection)
+   * \param [in] tol relative tolerance of period
+   **/
+  void assign(double threshold,double hysteresis,int size,int dc_bins,long ref_period=0,double tol=0.01)
+  {
+    threshold_low=threshold-hysteresis/2;threshold_high=threshold+hysteresis/2;
+    position=0;state=-1;last_rising=last_falling=-1;
+    up.assign(size,0);down.assign(size,0);period.assign(size,0);
+    dc.assign(dc_bins+1,0);
+    overflow=0;
+    reference_period=ref_period;tolerance=tol;
+    error_count=0;errors.clear();max_errors=64;
+  }
+
+  //! analyze a block (i.e. samples following the previous block)
+  template<typename T>
+  void add(const T *x,long n)
+  {
+    long i=0;
+    if(state<0&&n>0) {state=((double)x[0]>=threshold_high)?1:0;i=1;}
+    ///- compare in double (i.e. thresholds are not rounded into integer levels, nor wrapped in unsigned ones)
+    const double high=threshold_high,low=threshold_low;
+    for(;i<n;++i)
+    {
+      if(state==0) {if((double)x[i]>=high) {rising(position+i);state=1;}}
+      else         {if((double)x[i]<=low)  {falling(position+i);state=0;}}
+    }
+    position+=n;
+  }
+
+  //! number of complete periods
+  unsigned long count() const {unsigned long n=0;for(unsigned int i=0;i<period.size();++i) n+=period[i];return n;}
+  //! most frequent duration of a histogram (in samples)
+  static int mode(const std::vector<unsigned long> &h)
+  {
+    int m=0;
+    for(unsigned int i=1;i<h.size();++i) if(h[i]>h[m]) m=i;
+    return m;
+  }
+  //! mean and standard deviation of a histogram (in bins)
+  static void mean_std(const std::vector<unsigned long> &h,double &mean,double &std)
+  {
+    double n=0,s=0,s2=0;
+    for(unsigned int i=0;i<h.size();++i) {n+=h[i];s+=(double)h[i]*i;s2+=(double)h[i]*i*i;}
+    mean=(n>0)?s/n:0;std=(n>1)?std::sqrt(std::max(0.0,(s2-s*mean)/(n-1))):0;
+  }
+  //! histogram as image (i.e. for display)
+  static cimg_library::CImg<float> image(const std::vector<unsigned long> &h)
+  {
+    cimg_library::CImg<float> img(h.size());
+    cimg_forX(img,i) img(i)=h[i];
+    return img;
+  }
+
+ private:
+  //! count a duration in a histogram
+  void histogram_add(std::vector<unsigned long> &h,long d)
+  {
+    if(d>=0&&d<(long)h.size()) ++h[d];else ++overflow;
+  }
+  //! rising edge at \c p (i.e. end of down and of period)
+  void rising(long p)
+  {
+    if(last_falling>=0&&last_rising>=0)
+    {
+      histogram_add(down,p-last_falling);
+      const long t=p-last_rising;
+      histogram_add(period,t);
+      const int bins=dc.size()-1;
+      const long b=((last_falling-last_rising)*bins+t/2)/t;
+      ++dc[std::min((long)bins,b)];
+      if(reference_period>0&&std::fabs((double)(t-reference_period))>tolerance*reference_period)
+      {
+        ++error_count;
+        if(errors.size()<max_errors) errors.push_back(last_rising);
+      }
+    }
+    last_rising=p;
+  }
+  //! falling edge at \c p (i.e. end of up)
+  void falling(long p)
+  {
+    if(last_rising>=0) histogram_add(up,p-last_rising);
+    last_falling=p;
+  }
+};//DAQsqwave class
+
 //!test device
 /**
  * test of characteristics of a square wave : period, DC...
@@ -19,6 +144,19 @@ class DAQtest
   float reference_tolerance;
   bool DCfrequency;
   bool gaussian_filter;
+  float threshold;  ///< square wave edge level (in volt)
+  float hysteresis; ///< square wave hysteresis width around \c threshold (in volt)
+  std::vector<DAQsqwave> sqwave;///< streaming analyzer of each channel (see \c sqwave_assign )
+  int threads;      ///< number of analyzer threads (0: number of online processors)
+
+  //! constructor (i.e. 1 kHz square wave with 50% duty cycle, see \c load_parameter )
+  DAQtest()
+  {
+    reference_frequency=1000.0f;reference_DC=0.5f;reference_tolerance=1.0f;
+    DCfrequency=false;gaussian_filter=false;
+    threshold=2.5f;hysteresis=0.0f;
+    threads=0;
+  }
 
 //! Print instructions depending of the type of signal we want to test (sinus,square...)
 /** 
@@ -68,6 +206,8 @@ int test_print_instruction(int sw)
    DCfrequency =(param==1);
    fp.loadAttribute("filter",param);
    gaussian_filter =(param==1);
+   fp.loadAttribute("threshold",threshold);
+   fp.loadAttribute("hysteresis",hysteresis);
 
    return 0;
   }
@@ -573,6 +713,106 @@ if(display >=1) message.display("Test status");
 
 
 
+//! set up streaming square wave analyzers of all channels
+/**
+ * \param [in] DAQdev acquisition device (i.e. channels and sampling rate)
+ * \param [in] physical analyzed data is in volt (i.e. else in levels, thresholds being converted with the range of the device)
+ * \code
+ *   DAQt.sqwave_assign(DAQdev,true);
+ *   DAQt.sqwave_add(data_block);//for each block
+ *   DAQt.sqwave_report(std::cout,DAQdev,show);
+ * \endcode
+ **/
+int sqwave_assign(const DAQdevice &DAQdev,bool physical)
+{
+  const double ref_period=DAQdev.sampling_rate/(double)reference_frequency;//in samples
+  if(ref_period<2) {std::cerr<<"Error: square wave of "<<reference_frequency<<" Hz can not be sampled at "<<DAQdev.sampling_rate<<" Hz.\n";return CODE_ERROR;}
+  double th=threshold,hy=hysteresis;
+  if(!physical)
+  {//volt to level
+    const double step=(DAQdev.comedirange->max-DAQdev.comedirange->min)/(double)DAQdev.maxdata;
+    th=(th-DAQdev.comedirange->min)/step;hy/=step;
+  }
+  sqwave.assign(DAQdev.channel_index.size(),DAQsqwave());
+  for(unsigned int c=0;c<sqwave.size();++c)
+    sqwave[c].assign(th,hy,(int)(4*ref_period)+2,(int)(ref_period+0.5),(long)(ref_period+0.5),reference_tolerance/100.0);
+  return 0;
+}
+
+//! analyze a block of all channels (i.e. one image per channel, following the previous block), channels in parallel
+template<typename T>
+int sqwave_add(const cimg_library::CImgList<T> &data)
+{
+  if(data.size()!=sqwave.size()) return DIM_ERROR;
+  sqwave_job<T> j(sqwave,data);
+  DAQparallel_for(j,data.size(),threads);
+  return 0;
+}
+
+//! print square wave characteristics of all channels and check them against reference
+/**
+ * duration up, duration down, period, frequency and duty cycle (i.e. mode, mean and standard deviation of histograms) for each channel,
+ * test is OK if most frequent period and duty cycle are within tolerance of reference.
+ * \param [in] stream output stream
+ * \param [in] DAQdev acquisition device (i.e. channel names and sampling rate)
+ * \param [in] display display histograms of first channel (i.e. 1: duration up or duty cycle and period)
+ * \return number of failed channels
+ **/
+int sqwave_report(std::ostream &stream,const DAQdevice &DAQdev,int display=0)
+{
+  const double dt=1.0/DAQdev.sampling_rate;
+  const double tol=reference_tolerance/100.0;
+  int failed=0;
+  stream<<"############################ "<< std::endl;
+  stream<<"#####   BEGIN OF TEST  ##### "<< std::endl;
+  stream<<"############################ "<< std::endl;
+  for(unsigned int c=0;c<sqwave.size();++c)
+  {
+    const DAQsqwave &w=sqwave[c];
+    double mu,su,md,sd,mp,sp,mdc,sdc;
+    DAQsqwave::mean_std(w.up,mu,su);DAQsqwave::mean_std(w.down,md,sd);DAQsqwave::mean_std(w.period,mp,sp);DAQsqwave::mean_std(w.dc,mdc,sdc);
+    const int bins=w.dc.size()-1;
+    const double period=DAQsqwave::mode(w.period)*dt,duty=DAQsqwave::mode(w.dc)/(double)bins;
+    const bool ok=w.count()>0&&std::fabs(period*reference_frequency-1.0)<=tol&&std::fabs(duty-reference_DC)<=tol*std::max((double)reference_DC,1.0/bins);
+    stream<<"chan-"<<DAQdev.channel_index[c]<<": "<<DAQdev.channel_name[c]<<", "<<w.count()<<" periods"
+      <<", up: "<<mu*dt<<" +/- "<<su*dt<<" s"
+      <<", down: "<<md*dt<<" +/- "<<sd*dt<<" s"
+      <<", period: "<<period<<" s (mean "<<mp*dt<<" +/- "<<sp*dt<<")"
+      <<", frequency: "<<((period>0)?1.0/period:0.0)<<" Hz"
+      <<", duty cycle: "<<duty<<" (mean "<<mdc/bins<<" +/- "<<sdc/bins<<")";
+    if(w.overflow>0) stream<<", "<<w.overflow<<" too long";
+    if(w.error_count>0)
+    {
+      stream<<", "<<w.error_count<<" periods out of tolerance (first at sample";
+      for(unsigned int e=0;e<w.errors.size()&&e<4;++e) stream<<" "<<w.errors[e];
+      stream<<")";
+    }
+    stream<<": "<<(ok?"TEST OK":"TEST KO !")<<std::endl;
+    if(!ok) ++failed;
+  }
+  stream<<"########################### "<< std::endl;
+  stream<<"####### END OF TEST ####### "<< std::endl;
+  stream<<"########################### "<< std::endl;
+  if(display>=1&&!sqwave.empty())
+  {
+    if(DCfrequency) DAQsqwave::image(sqwave[0].dc).display_graph("histogram_DC",3,1,"Duty cycle",0,1,"Duty cycle count");
+    else DAQsqwave::image(sqwave[0].up).display_graph("duration up",3,1,"duration up (sample)",0,sqwave[0].up.size(),"up count");
+    DAQsqwave::image(sqwave[0].period).display_graph("period",3,1,"period (sample)",0,sqwave[0].period.size(),"period count");
+  }
+  return failed;
+}
+
+ private:
+//! analysis of a channel block (i.e. for \c DAQparallel_for )
+template<typename T>
+class sqwave_job : public DAQparallel_job
+{
+ public:
+  std::vector<DAQsqwave> &w;
+  const cimg_library::CImgList<T> &data;
+  sqwave_job(std::vector<DAQsqwave> &analyzers,const cimg_library::CImgList<T> &block) : w(analyzers),data(block) {}
+  void run(int c) {w[c].add(data[c].data(),data[c].width());}
+};
 
 };//DAQ_TEST class
 
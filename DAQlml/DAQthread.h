@@ -0,0 +1,87 @@
+#ifndef DAQ_THREAD
+#define DAQ_THREAD
+
+//! thread placement of acquisition, writer and analysis
+/**
+ * core and scheduling of each thread role (see \c RT_placement ), so that only the acquisition thread is real time (e.g. \c SCHED_FIFO on an isolated core),
+ * while the writer (i.e. streaming) and analysis (i.e. conversion, test and saving after acquisition) threads run with lower or no real time priority on other cores.
+ * \note parameters are loaded from the \c thread variable of the parameter file (e.g. \c acquisition_cpu , \c acquisition_policy and \c acquisition_priority attributes),
+ * default values are the previous behaviour (i.e. acquisition \c SCHED_FIFO 49 not pinned, others \c SCHED_OTHER ).
+ *
+ * \code
+ *   DAQthread DAQth;
+ *   DAQth.load_parameter("parameters.nc");
+ *   DAQth.place(DAQth.acquisition,"acquisition");//from acquisition thread
+ * \endcode
+ * \see RT_placement RT_preempt
+ **/
+class DAQthread
+{
+ public:
+  RT_placement acquisition;///< acquisition thread (i.e. point loop, buffer loop or ring filling)
+  RT_placement writer;     ///< writer thread (i.e. streaming conversion and file writing)
+  RT_placement analysis;   ///< calling thread after acquisition (i.e. conversion, test and saving)
+
+  //! constructor
+  DAQthread() : acquisition(-1,SCHED_FIFO,MY_PRIORITY),writer(-1,SCHED_OTHER,0),analysis(-1,SCHED_OTHER,0) {}
+
+  //! load placement parameters from file
+  /**
+   * default values are kept for missing parameters (e.g. old parameter file).
+   * \param [in] file_name NetCDF/CDL parameter file name (e.g. "parameters.nc")
+   **/
+  int load_parameter(const std::string file_name)
+  {
+    //NetCDF/CDL parameter file object (i.e. parameter class)
+    CParameterNetCDF fp;
+    ///open file from its name
+    int error=fp.loadFile((char *)file_name.c_str());
+    if(error){std::cerr<<"loadFile return "<< error <<std::endl;return error;}
+    ///open thread variable (i.e. process variable)
+    int process;
+    std::string process_name="thread";
+    if((error=fp.loadVar(process,&process_name))){std::cerr<<"Warning: process variable \""<<process_name<<"\" can not be loaded (return value is "<<error<<"), using default thread placement.\n";return 0;}
+    ///load attributes (i.e. process parameters)
+    if((error=load_role(fp,"acquisition",acquisition))) return error;
+    if((error=load_role(fp,"writer",writer))) return error;
+    if((error=load_role(fp,"analysis",analysis))) return error;
+    return 0;
+  }
+
+  //! place calling thread and check it
+  /**
+   * placement errors are warnings (e.g. no real time rights), as acquisition may run without them
+   * \return 0 if placement is effective
+   **/
+  static int place(const RT_placement &role,const std::string &name)
+  {
+    int error=role.apply();
+    if(error!=0) std::cerr<<"Warning: can not place "<<name<<" thread (core "<<role.cpu<<", "<<RT_placement::policy_name(role.policy)<<" priority "<<role.priority<<"): "<<strerror(error)<<"."<<std::endl;
+    return role.verify(std::cout,name)+(error!=0);
+  }
+
+  //! print placement of all roles
+  void print(std::ostream &stream) const
+  {
+    stream<<"thread placement (core, policy, priority):";
+    stream<<" acquisition "<<acquisition.cpu<<", "<<RT_placement::policy_name(acquisition.policy)<<", "<<acquisition.priority<<";";
+    stream<<" writer "<<writer.cpu<<", "<<RT_placement::policy_name(writer.policy)<<", "<<writer.priority<<";";
+    stream<<" analysis "<<analysis.cpu<<", "<<RT_placement::policy_name(analysis.policy)<<", "<<analysis.priority<<std::endl;
+  }
+
+ private:
+  //! load \c <role>_cpu , \c <role>_policy and \c <role>_priority attributes
+  static int load_role(CParameterNetCDF &fp,const std::string &role,RT_placement &placement)
+  {
+    fp.loadAttribute(role+"_cpu",placement.cpu);
+    std::string policy(RT_placement::policy_name(placement.policy));
+    fp.loadAttribute(role+"_policy",policy);
+    placement.policy=RT_placement::policy_id(policy);
+    if(placement.policy<-1) {std::cerr<<"Error: unknown "<<role<<" policy \""<<policy<<"\" (i.e. fifo, rr, other or inherit).\n";return CODE_ERROR;}
+    fp.loadAttribute(role+"_priority",placement.priority);
+    return 0;
+  }
+};//DAQthread class
+
+#endif// DAQ_THREAD
+
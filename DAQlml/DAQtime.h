@@ -0,0 +1,151 @@
+#ifndef DAQ_TIME
+#define DAQ_TIME
+
+#include <ctime>
+#include <cstdio>
+#include <sys/time.h>
+
+//! implicit time axis
+/**
+ * time of sample \c s of channel \c c is not stored but computed on demand in double precision:
+ * \c t(s,c)=s*sampling_period+time_offset(c) (in second, from \c start_time ),
+ * where \c time_offset(c) is the skew of the channel within a scan (i.e. \c c*convert_arg nanoseconds).
+ *
+ * In files, it is written as attributes (see \c save and \c load ):
+ * \li global \c start_time (UTC, ISO 8601 string), \c start_time_epoch (second since 1970-01-01), \c sampling_period and \c time_unit ,
+ * \li \c time_offset for each data variable.
+ *
+ * \code
+ *   DAQtime t;load_data_time("data.nc",var_names,t);
+ *   CImgList<double> time;t.get(time,0,1024);//time of the first 1024 samples of all channels
+ * \endcode
+ * \see DAQwriter load_data_time create_time
+ **/
+class DAQtime
+{
+ public:
+  double start;               ///< start time (second since 1970-01-01 UTC)
+  double sampling_period;     ///< time between two scans (in second)
+  std::vector<double> offset; ///< time offset of each channel (in second; i.e. skew within a scan)
+
+  //! constructor
+  DAQtime()
+  {
+    start=0.0;
+    sampling_period=0.0;
+  }
+
+  //! set up from device (i.e. sampling rate, convert time and start of acquisition)
+  int assign(const DAQdevice &DAQdev)
+  {
+    if(DAQdev.sampling_rate<=0) return CODE_ERROR;
+    start=(double)DAQdev.start_time.tv_sec+1e-6*(double)DAQdev.start_time.tv_usec;
+    sampling_period=1.0/(double)DAQdev.sampling_rate;
+    const double cdelay=1e-9*(double)DAQdev.cmd->convert_arg;//delay between channels
+    offset.resize(DAQdev.channel_index.size());
+    for(unsigned int c=0;c<offset.size();++c) offset[c]=cdelay*c;
+    return 0;
+  }
+
+  //! time of sample \c s of channel \c c (in second, from \c start )
+  double operator()(long s,int c=0) const
+  {
+    return (double)s*sampling_period+offset[c];
+  }
+
+  //! generate time of samples \c [first,first+n) of all channels
+  /**
+   * \param [out] time one image per channel
+   * \param [in] first index of the first sample (e.g. block position while streaming)
+   * \param [in] n number of samples
+   **/
+  template<typename Ttime>
+  int get(cimg_library::CImgList<Ttime> &time,long first,int n) const
+  {
+    if(offset.empty()) return DIM_ERROR;
+    time.assign(offset.size(),n);
+    cimglist_for(time,c)
+    {
+      Ttime *t=time[c].data();
+      for(int i=0;i<n;++i) t[i]=(Ttime)(*this)(first+i,c);
+    }
+    return 0;
+  }
+
+  //! start time as UTC ISO 8601 string (e.g. "2012-03-14T10:20:30.123456Z")
+  std::string start_string() const
+  {
+    time_t sec=(time_t)start;
+    struct tm utc;
+    gmtime_r(&sec,&utc);
+    char buf[64];
+    const long usec=(long)((start-(double)sec)*1e6+0.5);
+    strftime(buf,sizeof(buf),"%Y-%m-%dT%H:%M:%S",&utc);
+    std::string s(buf);
+    sprintf(buf,".%06ldZ",(usec>999999)?999999:usec);
+    return s+buf;
+  }
+
+  //! write attributes (i.e. file in define mode)
+  /**
+   * \param [in] fp NetCDF file
+   * \param [in] vars data variables (i.e. one for each channel)
+   **/
+  int save(NcFile *fp,const std::vector<NcVar*> &vars) const
+  {
+    if(vars.size()!=offset.size()) return DIM_ERROR;
+    if(!fp->add_att("start_time",start_string().c_str())) return NC_ERROR;
+    if(!fp->add_att("start_time_epoch",start)) return NC_ERROR;
+    if(!fp->add_att("sampling_period",sampling_period)) return NC_ERROR;
+    if(!fp->add_att("time_unit","second")) return NC_ERROR;
+    for(unsigned int c=0;c<vars.size();++c) if(!vars[c]->add_att("time_offset",offset[c])) return NC_ERROR;
+    return 0;
+  }
+
+  //! read attributes
+  /**
+   * \param [in] fp NetCDF file
+   * \param [in] vars data variables (i.e. time offset is 0 for a variable without \c time_offset attribute)
+   * \note files without \c sampling_period attribute use \c sampling_rate one (i.e. previous versions)
+   **/
+  int load(NcFile *fp,const std::vector<NcVar*> &vars)
+  {
+    NcError silent(NcError::silent_nonfatal);
+    NcAtt *a;
+    if((a=fp->get_att("sampling_period"))) {sampling_period=a->as_double(0);delete a;}
+    else if((a=fp->get_att("sampling_rate"))) {sampling_period=1.0/a->as_double(0);delete a;}
+    else return NC_ERROR;
+    start=0.0;
+    if((a=fp->get_att("start_time_epoch"))) {start=a->as_double(0);delete a;}
+    offset.assign(vars.size(),0.0);
+    for(unsigned int c=0;c<vars.size();++c)
+      if((a=vars[c]->get_att("time_offset"))) {offset[c]=a->as_double(0);delete a;}
+    return 0;
+  }
+};//DAQtime class
+
+//! create time corresponding to each sample
+/** 
+ * create time corresponding to each sample (i.e. legacy time variables, computed in double precision by \c DAQtime )
+ * the delay between channels is also taken into account
+ * 
+ * @param[in] data 
+ * @param[out] time 
+ * @param[in] DAQdev 
+ * @param[in] start index of the first sample (e.g. block position while streaming)
+ * 
+ * @return 
+ * \see DAQtime
+ */
+template <typename Tdata, typename Ttime>
+  int create_time(cimg_library::CImgList<Tdata>& data, cimg_library::CImgList<Ttime>& time, const DAQdevice &DAQdev, long start=0)
+{
+  DAQtime t;
+  int error=t.assign(DAQdev);
+  if(error) return error;
+  if(data.is_empty()) {time.assign();return 0;}
+  return t.get(time,start,data[0].width());
+}
+
+#endif// DAQ_TIME
+
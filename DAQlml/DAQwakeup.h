@@ -0,0 +1,156 @@
+#ifndef DAQ_WAKEUP
+#define DAQ_WAKEUP
+
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+
+#ifndef LOOP_USLEEP_TIME
+//! waiting time for the buffer
+#define LOOP_USLEEP_TIME 100
+#endif
+
+//! wakeup modes
+enum DAQwakeup_mode {WAKEUP_POLL=0, WAKEUP_BACKOFF=1};
+
+//! wait for data in the comedi buffer
+/**
+ * the acquisition loops call \c wait() when the comedi buffer is empty and \c data() when data is found:
+ * \li \c WAKEUP_POLL (default) blocks on the comedi file descriptor using \c poll() (i.e. no CPU use while idle), with a timeout so that a stalled acquisition is noticed,
+ * \li \c WAKEUP_BACKOFF sleeps from \c backoff_min up to \c backoff_max microseconds, doubling at each empty wakeup (i.e. adaptive polling).
+ *
+ * The poll mode falls back to backoff if the driver does not support \c poll() on the device file.
+ * The wakeup-to-data latency is recorded as the age of the oldest unread sample at wakeup (i.e. unread bytes over the acquisition byte rate).
+ *
+ * \code
+ *   DAQwakeup wakeup;wakeup.init(DAQdev);
+ *   while(...) {if(comedi_get_buffer_contents(...)==0) {wakeup.wait();continue;} wakeup.data(available);...}
+ *   wakeup.print(std::cout);
+ * \endcode
+ * \see sample_data_buffer sample_data_stream
+ **/
+class DAQwakeup
+{
+ public:
+  int verbose;        ///< verbose option
+  int mode;           ///< wakeup mode (see \c DAQwakeup_mode )
+  int timeout;        ///< poll timeout (in millisecond)
+  int backoff_min;    ///< first sleep of backoff mode (in microsecond)
+  int backoff_max;    ///< longest sleep of backoff mode (in microsecond)
+
+  int fd;             ///< comedi file descriptor
+  int backoff;        ///< current sleep of backoff mode (in microsecond)
+  double byte_rate;   ///< acquisition byte rate (in byte per second)
+  bool waited;        ///< last call was a wait (i.e. next data is a wakeup)
+
+  //statistics
+  unsigned long wait_count;    ///< number of waits
+  unsigned long timeout_count; ///< number of poll timeouts
+  unsigned long data_count;    ///< number of wakeups with data
+  double latency_min;          ///< minimum wakeup-to-data latency (in second)
+  double latency_max;          ///< maximum wakeup-to-data latency (in second)
+  double latency_sum;          ///< sum of wakeup-to-data latencies (in second)
+  double wait_time;            ///< time spent waiting (in second)
+
+  //! constructor
+  DAQwakeup()
+  {
+    verbose=0;
+    mode=WAKEUP_POLL;
+    timeout=1000;
+    backoff_min=10;
+    backoff_max=LOOP_USLEEP_TIME;
+    fd=-1;byte_rate=0.0;
+    reset();
+  }
+
+  //! reset statistics
+  void reset()
+  {
+    backoff=backoff_min;waited=false;
+    wait_count=timeout_count=data_count=0;
+    latency_min=latency_max=latency_sum=0.0;
+    wait_time=0.0;
+  }
+
+  //! set up for an acquisition device
+  /**
+   * \param [in] DAQdev acquisition device (i.e. configured for buffer acquisition)
+   **/
+  int init(DAQdevice &DAQdev)
+  {
+    verbose=DAQdev.verbose;
+    if(backoff_min<1) backoff_min=1;
+    if(backoff_max<backoff_min) backoff_max=backoff_min;
+    reset();
+    byte_rate=DAQdev.sampling_rate*DAQdev.channel_index.size()*((DAQdev.subdevice_flags&SDF_LSAMPL)?sizeof(lsampl_t):sizeof(sampl_t));
+    fd=DAQdev.backend->fileno();
+    if(mode==WAKEUP_POLL&&fd<0)
+    {
+      std::cerr<<"Warning: no file descriptor for \""<<DAQdev.filename<<"\", using backoff wakeup."<<std::endl;
+      mode=WAKEUP_BACKOFF;
+    }
+    return 0;
+  }
+
+  //! wait for data (i.e. buffer is empty)
+  void wait()
+  {
+    ++wait_count;waited=true;
+    double st=time();
+    if(mode==WAKEUP_POLL)
+    {
+      struct pollfd pfd;
+      pfd.fd=fd;pfd.events=POLLIN;pfd.revents=0;
+      int ret=poll(&pfd,1,timeout);
+      if(ret==0) ++timeout_count;
+      else if((ret<0&&errno!=EINTR)||(ret>0&&(pfd.revents&(POLLERR|POLLNVAL))))
+      {//driver does not support poll: fall back on backoff
+        std::cerr<<"Warning: poll on comedi file descriptor failed, using backoff wakeup."<<std::endl;
+        mode=WAKEUP_BACKOFF;
+      }
+    }
+    else
+    {
+      usleep(backoff);
+      backoff=std::min(backoff*2,backoff_max);
+    }
+    wait_time+=time()-st;
+  }
+
+  //! data found in buffer
+  /**
+   * \param [in] bytes number of unread bytes in the comedi buffer
+   **/
+  void data(int bytes)
+  {
+    backoff=backoff_min;
+    if(!waited||byte_rate<=0.0) return;
+    waited=false;
+    double latency=bytes/byte_rate;
+    if(data_count==0||latency<latency_min) latency_min=latency;
+    if(latency>latency_max) latency_max=latency;
+    latency_sum+=latency;
+    ++data_count;
+  }
+
+  //! print wakeup information
+  void print(std::ostream &stream)
+  {
+    stream<<"wakeup: "<<((mode==WAKEUP_POLL)?"poll":"backoff")<<", "<<wait_count<<" waits ("<<wait_time<<" sec, "<<timeout_count<<" timeouts)";
+    if(data_count>0) stream<<", latency min/mean/max "<<latency_min*1e6<<"/"<<latency_sum/data_count*1e6<<"/"<<latency_max*1e6<<" us";
+    stream<<std::endl;
+  }
+
+ private:
+  //! monotonic time (in second)
+  static double time()
+  {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec+t.tv_nsec*1e-9;
+  }
+};//DAQwakeup class
+
+#endif// DAQ_WAKEUP
+
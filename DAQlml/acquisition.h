@@ -1,5 +1,242 @@
 #ifndef DAQ_ACQUISITION
 #define DAQ_ACQUISITION
 
-#endif// DAQ_ACQUISITION
+//! acquire, process and save data
+/**
+ * acquisition process for a configured device, data is stored in its native sample type (i.e. \c sampl_t for 16 bit boards or \c lsampl_t if \c SDF_LSAMPL subdevice flag)
+ * from acquisition loop to conversion, then saved (raw data being widened block by block in file type).
+ * \param [in] DAQdev acquisition device (i.e. configured)
+ * \param [in] map pointer to mapped buffer (i.e. buffer acquisition only)
+ * \param [in] wakeup wait for buffer data
+ * \param [in] DAQth thread placement (i.e. acquisition, writer and analysis threads)
+ * \param [in] DAQt test signal parameters
+ * \param [in] fp input parameter file name
+ * \param [in] fo output data file name
+ * \param [in] buffer buffer acquisition (i.e. else point acquisition)
+ * \param [in] stream streaming acquisition (i.e. with buffer)
+ * \param [in] conv_phys convert binary data into physical voltage
+ * \param [in] packed store raw levels in 16 bit with \c scale_factor and \c add_offset (i.e. no conversion, see \c DAQwriter::packed )
+ * \param [in] time_axis create legacy time variables (i.e. time axis is implicit otherwise, see \c DAQtime )
+ * \param [in] test test type (e.g. \c TEST_SQWAVE )
+ * \param [in] show display result as a graph
+ * \param [in] scope live oscilloscope while streaming (see \c DAQscope )
+ * \param [in] verbose verbose option
+ *
+ * \code
+ *   if(DAQdev.subdevice_flags&SDF_LSAMPL) acquisition<lsampl_t>(DAQdev,map,...); else acquisition<sampl_t>(DAQdev,map,...);
+ * \endcode
+ **/
+template<typename Tsample>
+int acquisition(DAQdevice &DAQdev,void *map,DAQwakeup &wakeup,const DAQthread &DAQth,DAQtest &DAQt,
+  const std::string fp,const std::string fo,
+  const bool buffer,const bool stream,bool conv_phys,const bool packed,const bool time_axis,const int test,const int show,const bool scope,const int verbose)
+{
+  ///- streaming acquisition (i.e. data is saved block by block while acquiring)
+  if(buffer&&stream)
+  {
+    DAQstream<Tsample> DAQs;
+    DAQs.load_parameter(fp);
+    std::cout<<"starting streaming acquisition into '"<<fo<<"'."<<std::endl;
+    double st=getETime();
+    DAQs.placement=DAQth.writer;
+    DAQs.packed=packed;
+    DAQs.pyramid.load_parameter(fp);
+    DAQscope DAQsc;
+    if(scope)
+    {//live view of each block while streaming (i.e. display thread, never waited for)
+      if(DAQsc.load_parameter(fp)) return 1;
+      DAQsc.placement=DAQth.analysis;
+      if(DAQsc.start(DAQdev,conv_phys)) return 1;
+      DAQs.scope=&DAQsc;
+    }
+    if(test==TEST_SQWAVE)
+    {//square wave analysis of each block while streaming
+      std::cout<<"testing signals by square wave."<<std::endl;
+      DAQt.load_parameter(fp);
+      DAQt.threads=1;
+      if(DAQt.sqwave_assign(DAQdev,conv_phys)) return 1;
+      DAQs.test=&DAQt;
+    }
+    if(DAQs.start(DAQdev,fo,conv_phys,time_axis)) return 1;
+    DAQthread::place(DAQth.acquisition,"acquisition");
+    int error=sample_data_stream(DAQs,map,DAQdev,wakeup);
+    DAQthread::place(DAQth.analysis,"analysis");
+    if(error) std::cerr<<"Error: acquisition stopped before the end (return value is "<<error<<")."<<std::endl;
+    error|=DAQs.stop();
+    DAQsc.stop();
+    if(test==TEST_SQWAVE) DAQt.sqwave_report(std::cout,DAQdev,show);
+    if(show==1) DAQs.pyramid.display("channels recorded",DAQdev.sampling_rate,(cimg_library::CImgList<Tsample>*)NULL);
+    double en=getETime();
+    std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+    std::cout<<"finalizing the device."<<std::endl;
+    if(DAQdev.close()<0){std::cerr<<"Error: can not close \""<<DAQdev.filename<<"\"."<<std::endl;exit(1);}
+    return error;
+  }//stream
+
+  std::cout<<"allocating memory for data."<<std::endl;
+  double st, en;
+  st=getETime();
+  cimg_library::CImgList<Tsample> data(DAQdev.channel_index.size(),DAQdev.sample_number);
+  cimg_library::CImgList<float> data_phys;
+  cimg_library::CImgList<double> time;
+  RT_jitter jitter;
+  DAQstats stats;stats.assign(DAQdev,conv_phys||packed);
+  DAQpyramid pyramid;pyramid.load_parameter(fp);pyramid.assign(DAQdev,DAQdev.sample_number,conv_phys||packed);
+  en=getETime();
+  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+
+//RT
+ // data.fill(99);
+  //RT.init
+
+  //control or acquisition loop
+  std::cout<<"starting sampling with ";
+  st=getETime();
+//! \todo currently control is removed.
+  if(buffer)
+  {
+    DAQthread::place(DAQth.acquisition,"acquisition");
+    sample_data_buffer(data, map, DAQdev, wakeup, &stats, &pyramid);//,control);
+  }
+  else
+  {
+    sample_data_point(data, DAQdev, &jitter, &DAQth.acquisition);//,control);
+    stats.add(data);//one pass (i.e. not in real time loop)
+    pyramid.add(data);
+  }
+  ///- leave real time priority for processing and saving
+  DAQthread::place(DAQth.analysis,"analysis");
+  en=getETime();
+  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+  if(!buffer&&jitter.ticks>0) jitter.print(std::cout);
+
+  //convert data to data_phys
+  if(conv_phys) {
+    st=getETime();
+    std::cout<<"converting binary data to physical voltage."<<std::endl;
+    convert_to_phys(data, data_phys, DAQdev);
+data.print("data in main");
+data_phys.print("data_phys in main");
+    en=getETime();
+    std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+  }
+
+  //create time axis
+  if(time_axis)
+    {
+      st=getETime();
+      std::cout<<"creating legacy time variables."<<std::endl;
+      create_time(data, time, DAQdev);
+      en=getETime();
+      std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+    }
+  if(verbose) data_phys.print("data physical");
+
+  std::cout<<"printing first 10 samples."<<std::endl;
+  if(conv_phys)
+  for (int j=0; j<10; j++){for (unsigned int i=0; i<DAQdev.channel_index.size(); i++){ if(data_phys[i](j)>=0.0){std::cout<<" ";} std::cout<<std::scientific<<std::setprecision(3)<<data_phys[i](j)<<" "; } std::cout<<std::endl; }
+
+  //simple statistics, mean, var, min, max (i.e. computed while acquiring)
+  std::cout<<"basic statistics."<<std::endl;
+  stats.print(std::cout,DAQdev);
 
+
+  ///- test computations (e.g. square or sinus wave tests)
+  if(test==TEST_SQWAVE)
+    {
+      std::cout<<"testing signals by square wave."<<std::endl;  
+
+      DAQt.load_parameter(fp);
+      ///all channels at once, without copy (i.e. streaming analyzer, see \c DAQsqwave )
+      if(DAQt.sqwave_assign(DAQdev,conv_phys)==0)
+      {
+        if(conv_phys) DAQt.sqwave_add(data_phys);
+        else DAQt.sqwave_add(data);
+        DAQt.sqwave_report(std::cout,DAQdev,show);
+      }
+    }
+  
+  std::cout<<"saving data into a NetCDF file."<<std::endl;
+  st=getETime();
+  int acqu_range_min=0,acqu_range_max=DAQdev.maxdata;std::string acqu_range_unit("level");
+  if(conv_phys)
+    {
+      float phys_range_min=DAQdev.comedirange->min,phys_range_max=DAQdev.comedirange->max; std::string phys_range_unit("volt");
+      save_data(fo, data_phys, time, DAQdev, "volt", acqu_range_min, acqu_range_max, acqu_range_unit, phys_range_min, phys_range_max, phys_range_unit, buffer?NULL:&jitter, &stats, pyramid.save_file?&pyramid:NULL);
+    }
+  else
+    {
+      int   phys_range_min=DAQdev.comedirange->min,phys_range_max=DAQdev.comedirange->max; std::string phys_range_unit("volt");
+      save_data(fo, data, time, DAQdev, packed?"volt":"16 bit binary", acqu_range_min, acqu_range_max, acqu_range_unit, phys_range_min, phys_range_max, phys_range_unit, buffer?NULL:&jitter, &stats, pyramid.save_file?&pyramid:NULL, packed);
+    }
+  en=getETime();
+  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+
+  
+  std::cout<<"finalizing the device."<<std::endl;
+  int ret=DAQdev.close();
+  if(ret<0){
+    std::cerr<<"Error: can not close \""<<DAQdev.filename<<"\"."<<std::endl;
+    exit(1);
+  }
+
+  ///- display data on GUI
+  //display data
+  if(show==1)
+    {
+      //envelope pyramid (i.e. redraw cost given by screen width, raw levels when zoomed in)
+      pyramid.finish();
+      pyramid.display("channels recorded",DAQdev.sampling_rate,&data);
+    }//if show
+  ///- computation of data statistics, save and display on GUI
+  /*
+  //later
+  if(statistic)
+  {
+  max_min_mean_rms
+  histogram
+  if(store_statistic)
+  if(GUI_statistic)
+  }
+  */
+
+  return 0;
+}
+
+//! acquire and save data of several boards in a single file
+/**
+ * multi-board streaming acquisition (see \c DAQmulti ): one pinned acquisition thread for each board, merged, converted and saved while acquiring.
+ * \param [in] devices acquisition devices (i.e. configured with the same sampling rate and sample type)
+ * \param [in] maps pointer to mapped buffer of each device
+ * \param [in] wakeup wait for buffer data (i.e. same settings for all boards)
+ * \param [in] DAQth thread placement (i.e. scheduling of acquisition threads, writer being the calling thread)
+ * \param [in] cpu core of each acquisition thread (empty: default cores)
+ * \param [in] fp input parameter file name (i.e. streaming parameters)
+ * \param [in] fo output data file name
+ * \param [in] conv_phys convert binary data into physical voltage
+ * \param [in] time_axis create legacy time variables
+ **/
+template<typename Tsample>
+int acquisition_multi(std::vector<DAQdevice*> &devices,std::vector<void*> &maps,DAQwakeup &wakeup,const DAQthread &DAQth,const std::vector<int> &cpu,
+  const std::string fp,const std::string fo,bool conv_phys,const bool time_axis)
+{
+  DAQmulti<Tsample> DAQm;
+  DAQm.load_parameter(fp);
+  DAQm.placement=DAQth.acquisition;
+  int error=DAQm.assign(devices,maps,wakeup,cpu);
+  if(error) return error;
+  std::cout<<"starting multi-board streaming acquisition into '"<<fo<<"'."<<std::endl;
+  double st=getETime();
+  if(DAQm.start()) return 1;
+  DAQthread::place(DAQth.writer,"writer");
+  error=DAQm.write(fo,conv_phys,time_axis);
+  if(DAQm.stop()) {std::cerr<<"Error: acquisition stopped before the end."<<std::endl;error|=1;}
+  double en=getETime();
+  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
+  std::cout<<"finalizing the devices."<<std::endl;
+  for(unsigned int d=0;d<devices.size();++d)
+    if(devices[d]->close()<0){std::cerr<<"Error: can not close \""<<devices[d]->filename<<"\"."<<std::endl;exit(1);}
+  return error;
+}
+
+#endif// DAQ_ACQUISITION
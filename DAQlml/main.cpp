@@ -111,24 +111,6 @@
 #include "../RealTime/RT_PREEMPT.h"
 //#endif
 
-//DAQlml headers
-#include "DAQcomedi.h"
-#include "DAQdata.h"
-#include "DAQloop.h"
-
-
-//process headers
-#include "acquisition.h"
-#include "control.h"
-
-//test signal
-#include "DAQtest.h"
-
-//signal post-processing
-//! \todo [very low] signal post-processing adapted from *_flag.h and intensive CImg functions
-//#include "statistic.h"
-//#include "histogram.h"
-
 //! for time count 
 /**
  * One can use this function to measure the actual time (not CPU time).
@@ -149,6 +131,38 @@ double getETime()
   return tv.tv_sec + (double)tv.tv_usec*1e-6;
 }
 
+//DAQlml headers
+#include "DAQbackend.h"
+#include "DAQsimulated.h"
+#include "DAQcomedi.h"
+#include "DAQparallel.h"
+#include "DAQconvert.h"
+#include "DAQtime.h"
+#include "DAQstats.h"
+#include "DAQpyramid.h"
+//test signal
+#include "DAQtest.h"
+#include "DAQpoint.h"
+#include "DAQdata.h"
+#include "DAQrotate.h"
+#include "DAQdeinterleave.h"
+#include "DAQwakeup.h"
+#include "DAQring.h"
+#include "DAQthread.h"
+#include "DAQscope.h"
+#include "DAQstream.h"
+#include "DAQloop.h"
+#include "DAQmulti.h"
+
+//process headers
+#include "acquisition.h"
+#include "control.h"
+
+//signal post-processing
+//! \todo [very low] signal post-processing adapted from *_flag.h and intensive CImg functions
+//#include "statistic.h"
+//#include "histogram.h"
+
 //! main function of the DAQlml program
 /**
  * \param [in] argc command line argument number (i.e. string count)
@@ -156,7 +170,7 @@ double getETime()
  **/
 int main(int argc, char *argv[])
 {
-  const std::string version = "DAQlml v0.4.4: DAta AcQuisition program of LML";
+  const std::string version = "DAQlml v0.5.9: DAta AcQuisition program of LML";
                                
   std::cout<<"----------------------------------------------"<<std::endl;
   std::cout<< version                                        <<std::endl;
@@ -171,8 +185,8 @@ int main(int argc, char *argv[])
         bool show_help  = (cimg_option("--help",(const char*)NULL,"help (or -h option)")!=NULL);show_help=show_h|show_help;
 
   ////file names
-  const std::string fd  =  cimg_option("--fd","/dev/comedi0","board device file");
-  const std::string fp  =  cimg_option("--fp","parameters.nc","input parameter file");
+  const std::string fd  =  cimg_option("--fd","/dev/comedi0","board device file (or sim for simulated device), comma separated for several boards (e.g. /dev/comedi0,/dev/comedi1; with --buffer --stream)");
+  const std::string fp  =  cimg_option("--fp","parameters.nc","input parameter file, comma separated for several boards (or one for all)");
 //  const std::string fi  =  cimg_option("--fi","","input data file");
   const std::string fo  =  cimg_option("--fo","data.nc","output data file");
 //  const std::string fs  =  cimg_option("--fs","stats.nc","statistics output file");
@@ -181,13 +195,27 @@ int main(int argc, char *argv[])
   ////program behaviours
   //! \todo currently acquire is not used.
 //  bool       acquire   =  fi.empty();
-  const bool time_axis =  cimg_option("-t",true,"create time axis");
+  const bool time_axis =  cimg_option("-t",false,"create legacy time variables (time axis is implicit: start_time, sampling_period and time_offset attributes)");
   bool       conv_phys =  cimg_option("-c",true,"convert 16bit int value into voltage");
+  const bool packed    =  cimg_option("--packed",false,"store raw 16bit levels as short with scale_factor and add_offset attributes (half size of float voltage, no conversion; implies -c false)");
+  if(packed) conv_phys=false;//raw levels saved, physical values from attributes
   const int  test      =  cimg_option("--test",0,"test, 0: no test, 1: square wave test");//, 2: sin wave test");
 //  const bool control   =  cimg_option("--control",false,"use of output for control");
   const bool bdinfo    = (cimg_option("--boardinfo",(const char*)NULL,"print board info")!=NULL);
   const int  show      = (cimg_option("--show",0,"display result as a graph, 0: no display 1: data (and histogram on test) 2: + errors 3: + raw data/clean data"));
   const bool buffer  =  cimg_option("--buffer", false,"acquisition type");
+  const bool stream  =  cimg_option("--stream", false,"streaming acquisition (with --buffer): data is converted and saved while acquiring");
+  const bool scope   =  cimg_option("--scope", false,"live oscilloscope while streaming (see scope parameters: sweep width, frame rate and trigger)");
+  ////buffer wakeup (i.e. wait for data)
+  DAQwakeup wakeup;
+  wakeup.mode        =  cimg_option("--wakeup",wakeup.mode,"wait for buffer data, 0: poll on device file (backoff if not supported), 1: backoff sleep");
+  wakeup.timeout     =  cimg_option("--poll_timeout",wakeup.timeout,"poll timeout (in ms)");
+  wakeup.backoff_min =  cimg_option("--backoff_min",wakeup.backoff_min,"first backoff sleep (in us)");
+  wakeup.backoff_max =  cimg_option("--backoff_max",wakeup.backoff_max,"longest backoff sleep (in us)");
+  ////point acquisition
+  const int  settle  =  cimg_option("--settle",0,"point acquisition: settling time between channel selection and read (in ns, 0: no wait)");
+  ////multi-board acquisition
+  const std::string cpus = cimg_option("--cpu","","multi-board: core of each board acquisition thread, comma separated (default: board d on core d+1, -1: not pinned)");
 
   //show help and/or information
   if(show_help) {print_help(std::cerr);      return 0;}
@@ -199,13 +227,51 @@ int main(int argc, char *argv[])
   
   if(test==TEST_SQWAVE)  DAQt.test_print_instruction(TEST_SQWAVE);
 
+  ///- thread placement (i.e. core and priority of acquisition, writer and analysis threads)
+  DAQthread DAQth;
+  if(DAQth.load_parameter(DAQmulti_split(fp)[0])) return 1;
+  DAQth.print(std::cout);
+
+  ///- multi-board acquisition (i.e. one device and parameter file for each board)
+  std::vector<std::string> fds=DAQmulti_split(fd);
+  if(fds.size()>1)
+  {
+    if(!(buffer&&stream)) {std::cerr<<"Error: several boards need streaming acquisition (i.e. --buffer true --stream true)."<<std::endl;return 1;}
+    if(packed) {std::cerr<<"Error: several boards can not be packed (i.e. one scale_factor and add_offset for boards of different ranges; use -c true or -c false)."<<std::endl;return 1;}
+    if(test!=0||show!=0||scope) {std::cerr<<"Error: several boards have no test, display nor live oscilloscope (i.e. --test 0 --show 0 --scope false)."<<std::endl;return 1;}
+    std::vector<std::string> fps=DAQmulti_split(fp);
+    if(fps.size()==1) fps.assign(fds.size(),fp);
+    if(fps.size()!=fds.size()) {std::cerr<<"Error: "<<fps.size()<<" parameter files for "<<fds.size()<<" boards."<<std::endl;return 1;}
+    std::vector<int> cpu;
+    if(!cpus.empty()) {std::vector<std::string> c=DAQmulti_split(cpus);for(unsigned int i=0;i<c.size();++i) cpu.push_back(atoi(c[i].c_str()));}
+    std::vector<DAQdevice*> devices(fds.size());
+    std::vector<void*> maps(fds.size(),(void*)NULL);
+    for(unsigned int d=0;d<fds.size();++d)
+    {
+      devices[d]=new DAQdevice(fds[d]);
+      std::cout<<"loading sampling parameters of board "<<d<<" from '"<< fps[d] <<"'."<<std::endl;
+      devices[d]->load_parameter(fps[d]);
+      devices[d]->verbose=verbose;
+      devices[d]->config_device_buffer(maps[d]);
+      devices[d]->print();
+    }
+    int error;
+    if(devices[0]->subdevice_flags&SDF_LSAMPL)
+      error=acquisition_multi<lsampl_t>(devices,maps,wakeup,DAQth,cpu,fps[0],fo,conv_phys,time_axis);
+    else
+      error=acquisition_multi<sampl_t>(devices,maps,wakeup,DAQth,cpu,fps[0],fo,conv_phys,time_axis);
+    for(unsigned int d=0;d<devices.size();++d) delete devices[d];
+    return error;
+  }
+
   // create DAQdevice;
   DAQdevice DAQdev(fd);
   std::cout<<"loading sampling parameters from '"<< fp <<"'."<<std::endl;
   DAQdev.load_parameter(fp);
 
-  void *map;// pointer to mapped memory
+  void *map=NULL;// pointer to mapped memory
   DAQdev.verbose=verbose;
+  DAQdev.settling_time=settle;
   //initialize acquisition device
   if(buffer)
   {
@@ -220,135 +286,9 @@ int main(int argc, char *argv[])
   }
   DAQdev.print();
 
-  //! \todo [low] \c data should be \c sampl_t type (best with template)
-  std::cout<<"allocating memory for data."<<std::endl;
-  double st, en;
-  st=getETime();
-  cimg_library::CImgList<int>   data(DAQdev.channel_index.size(),DAQdev.sample_number);
-  cimg_library::CImgList<float> data_phys;
-  cimg_library::CImgList<float> time;
-  en=getETime();
-  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
-
-//RT
- // data.fill(99);
-  //RT.init
-
-  //control or acquisition loop
-  std::cout<<"starting sampling with ";
-  st=getETime();
-//! \todo currently control is removed.
-  if(buffer) sample_data_buffer(data, map, DAQdev);//,control);
-  else sample_data_point(data, DAQdev);//,control);
-  en=getETime();
-  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
-
-  //convert data to data_phys
-  if(conv_phys) {
-    st=getETime();
-    std::cout<<"converting binary data to physical voltage."<<std::endl;
-    convert_to_phys(data, data_phys, DAQdev);
-data.print("data in main");
-data_phys.print("data_phys in main");
-    en=getETime();
-    std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
-  }
-
-  //create time axis
-  if(time_axis)
-    {
-      st=getETime();
-      std::cout<<"creating time axis."<<std::endl;
-      create_time(data, time, DAQdev);
-      en=getETime();
-      std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
-    }
-  if(verbose) data_phys.print("data physical");
-
-  std::cout<<"printing first 10 samples."<<std::endl;
-  for (int j=0; j<10; j++){for (unsigned int i=0; i<DAQdev.channel_index.size(); i++){ if(data_phys[i](j)>=0.0){std::cout<<" ";} std::cout<<std::scientific<<std::setprecision(3)<<data_phys[i](j)<<" "; } std::cout<<std::endl; }
-
-  //check simple statistics, mean, var, min, max
-  std::cout<<"computing basic statistics."<<std::endl;
-  cimglist_for(data_phys,n){std::cout<<"chan-"<<DAQdev.channel_index[n] << ": " << DAQdev.channel_name[n] << ", mean: "<<data_phys[n].mean() << ", min: "<<data_phys[n].min()<<", max: "<<data_phys[n].max()<<", var: "<<data_phys[n].variance()<<std::endl;}
-
-
-  ///- test computations (e.g. square or sinus wave tests)
-  if(test==TEST_SQWAVE)
-    {
-      std::cout<<"testing signals by square wave."<<std::endl;  
-
-      DAQt.load_parameter(fp);
-//! \todo [high] loop on channels
-      /*
-      for(i=0;i<data_phys.size();i++)
-	{
-	  DAQt.test_signal(data_phys[i],DAQdev.sampling_rate,true,false,true,DAQt.reference_frequency,DAQt.reference_DC,DAQt.reference_tolerance);
-	}
-      */
-      DAQt.test_signal(data_phys[0],DAQdev.sampling_rate,DAQt.gaussian_filter,DAQt.DCfrequency,show,DAQt.reference_frequency,DAQt.reference_DC,DAQt.reference_tolerance);     
-    }
-  
-  std::cout<<"saving data into a NetCDF file."<<std::endl;
-  st=getETime();
-  int acqu_range_min=0,acqu_range_max=DAQdev.maxdata;std::string acqu_range_unit("level");
-  if(conv_phys)
-    {
-      float phys_range_min=DAQdev.comedirange->min,phys_range_max=DAQdev.comedirange->max; std::string phys_range_unit("volt");
-      save_data(fo, data_phys, time, DAQdev, "volt", acqu_range_min, acqu_range_max, acqu_range_unit, phys_range_min, phys_range_max, phys_range_unit);
-    }
-  else
-    {
-      int   phys_range_min=DAQdev.comedirange->min,phys_range_max=DAQdev.comedirange->max; std::string phys_range_unit("volt");
-      save_data(fo, data, time, DAQdev, "16 bit binary", acqu_range_min, acqu_range_max, acqu_range_unit, phys_range_min, phys_range_max, phys_range_unit);
-    }
-  en=getETime();
-  std::cout<<"elapsed time: "<<(en-st)<<" sec"<<std::endl;
-
-  
-  std::cout<<"finalizing the device."<<std::endl;
-  int ret=comedi_close(DAQdev.dev);
-  if(ret<0){
-    comedi_perror(DAQdev.filename.c_str());
-    exit(1);
-  }
-
-  ///- display data on GUI
-  //display data
-  if(show==1)
-    {
-      //tranform data as list to display as image
-      cimg_library::CImg<float> display;
-      if(conv_phys)
-	{//floating data (i.e. recorded levels in Volts)
-	  cimglist_for(data_phys,n) display.append(data_phys[n]);//concat lines
-	  display.assign(data_phys[0].width(),1,1,data_phys.size());//set right dimensions
-	}
-      else
-	{//unsigned interger data (i.e. recorded discrete levels)
-	  cimglist_for(data,n) display.append(data[n]);//concat lines
-	  display.assign(data[0].width(),1,1,data.size());//set right dimensions
-	}
-      //display as color graphs by set of 3
-      for(int c=0;c<display.spectrum();c+=3)
-	{
-	  int c0=c,c1=((c+3)<display.spectrum())?(c+2):(display.spectrum()-1);
-	  PR(c0);PR(c1);
-	  (display.get_shared_channels(c0,c1)).display_graph("channels recorded");
-	}
-    }//if show
-  ///- computation of data statistics, save and display on GUI
-  /*
-  //later
-  if(statistic)
-  {
-  max_min_mean_rms
-  histogram
-  if(store_statistic)
-  if(GUI_statistic)
-  }
-  */
-
-  return 0;
+  ///- acquisition, processing and saving with the sample type of the board (i.e. 16 or 32 bit samples)
+  if(DAQdev.subdevice_flags&SDF_LSAMPL)
+    return acquisition<lsampl_t>(DAQdev,map,wakeup,DAQth,DAQt,fp,fo,buffer,stream,conv_phys,packed,time_axis,test,show,scope,verbose);
+  return acquisition<sampl_t>(DAQdev,map,wakeup,DAQth,DAQt,fp,fo,buffer,stream,conv_phys,packed,time_axis,test,show,scope,verbose);
 }
 
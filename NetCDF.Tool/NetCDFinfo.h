@@ -10,8 +10,10 @@
 //! Information on NetCDF type of data
 /**
  * Information on NetCDF type of data, implemented types are the following:
- *      \c char,         \c int,         \c float
- * \see NcTypeInfo<char> NcTypeInfo<int> NcTypeInfo<float>
+ *      \c char,         \c ncbyte (i.e. \c unsigned \c char ), \c short,       \c int,         \c float,       \c double,
+ * other unsigned and 64 bit types being stored in the smallest classic type holding their whole range:
+ *      \c unsigned \c short as \c ncInt, \c unsigned \c int, \c long and \c unsigned \c long as \c ncDouble (i.e. exact up to 2^53)
+ * \see NcTypeInfo<char> NcTypeInfo<short> NcTypeInfo<int> NcTypeInfo<float>
  * \note This list may not be updated, but have a look in \e Class \e Hierarchy of documentation
 **/
 
@@ -26,6 +28,11 @@ template<> struct NcTypeInfo<char> {
   static const int ncId() {static const int i=ncChar; return i;}
   static const char* ncStr() {static const char *const s="ncChar"; return s;}
 };
+//! Information on NetCDF type of a \c short data
+template<> struct NcTypeInfo<short> {
+  static const int ncId() {static const int i=ncShort; return i;}
+  static const char* ncStr() {static const char *const s="ncShort"; return s;}
+};
 //! Information on NetCDF type of an \c int data
 template<> struct NcTypeInfo<int> {
   static const int ncId() {static const int i=ncInt; return i;}
@@ -46,10 +53,30 @@ template<> struct NcTypeInfo<bool> {
   static const int ncId() {static const int i=ncByte; return i;}
   static const char* ncStr() {static const char *const s="ncByte (used as boolean)"; return s;}
 };
-//! Information on NetCDF type of a \c bool data
+//! Information on NetCDF type of a \c ncbyte data
 template<> struct NcTypeInfo<ncbyte> {
   static const int ncId() {static const int i=ncByte; return i;}
-  static const char* ncStr() {static const char *const s="ncByte (used as boolean)"; return s;}
+  static const char* ncStr() {static const char *const s="ncByte"; return s;}
+};
+//! Information on NetCDF type of an \c unsigned \c short data (i.e. stored in \c ncInt , e.g. 16 bit levels)
+template<> struct NcTypeInfo<unsigned short> {
+  static const int ncId() {static const int i=ncInt; return i;}
+  static const char* ncStr() {static const char *const s="ncInt (used as unsigned short)"; return s;}
+};
+//! Information on NetCDF type of an \c unsigned \c int data (i.e. stored in \c ncDouble , e.g. 32 bit levels)
+template<> struct NcTypeInfo<unsigned int> {
+  static const int ncId() {static const int i=ncDouble; return i;}
+  static const char* ncStr() {static const char *const s="ncDouble (used as unsigned int)"; return s;}
+};
+//! Information on NetCDF type of a \c long data (i.e. stored in \c ncDouble , no 64 bit classic type)
+template<> struct NcTypeInfo<long> {
+  static const int ncId() {static const int i=ncDouble; return i;}
+  static const char* ncStr() {static const char *const s="ncDouble (used as long)"; return s;}
+};
+//! Information on NetCDF type of an \c unsigned \c long data (i.e. stored in \c ncDouble , no 64 bit classic type)
+template<> struct NcTypeInfo<unsigned long> {
+  static const int ncId() {static const int i=ncDouble; return i;}
+  static const char* ncStr() {static const char *const s="ncDouble (used as unsigned long)"; return s;}
 };
 //! Information on NetCDF type as a string of any \c NcType
 char *NcTypeStr(int ncId)
@@ -58,10 +85,11 @@ char *NcTypeStr(int ncId)
   switch(ncId)
   {
     case ncChar:  s=(char *)(NcTypeInfo<char>::ncStr());  break;
+    case ncShort: s=(char *)(NcTypeInfo<short>::ncStr()); break;
     case ncInt:   s=(char *)(NcTypeInfo<int>::ncStr());   break;
     case ncFloat: s=(char *)(NcTypeInfo<float>::ncStr()); break;
     case ncDouble:s=(char *)(NcTypeInfo<double>::ncStr());break;
-    case ncByte:  s=(char *)(NcTypeInfo<bool>::ncStr());  break;
+    case ncByte:  s=(char *)(NcTypeInfo<ncbyte>::ncStr());break;
     default: return NULL;
   }
   return s;
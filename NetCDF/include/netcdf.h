@@ -96,6 +96,8 @@ typedef enum {
 #define NC_LOCK		0x0400	/* Use locking if available */
 #define NC_SHARE	0x0800	/* Share updates, limit cacheing */
 #define NC_64BIT_OFFSET 0x0200  /* Use large (64-bit) file offsets */
+#define NC_MMAP		0x1000	/* Map file in memory, no ncio buffer */
+#define NC_DEFER_NUMRECS 0x2000	/* Write numrecs at sync points only */
 
 /*
  * Starting with version 3.6, there are different format netCDF files.
@@ -414,6 +416,10 @@ nc_copy_var(int ncid_in, int varid, int ncid_out);
 #define ncvarcpy(ncid_in, varid, ncid_out) ncvarcopy((ncid_in), (varid), (ncid_out))
 #endif
 
+/* write nrecs records of all record variables */
+EXTERNL int
+nc_put_recs(int ncid, size_t recnum, size_t nrecs, void *const *datap);
+
 /* End _var */
 /* Begin {put,get}_var1 */
 
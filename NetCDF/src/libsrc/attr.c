@@ -140,6 +140,8 @@ free_NC_attrarrayV0(NC_attrarray *ncap)
 {
 	assert(ncap != NULL);
 
+	free_NC_hashmap(&ncap->hash);
+
 	if(ncap->nelems == 0)
 		return;
 
@@ -312,34 +314,31 @@ NC_attrarray0( NC *ncp, int varid)
 
 
 /*
- * Step thru NC_ATTRIBUTE array, seeking match on name.
+ * Name of an attribute (see NC_hashfind()).
+ */
+static NC_string *
+NC_attrname(const void *elemp)
+{
+	return ((const NC_attr *)elemp)->name;
+}
+
+
+/*
+ * Seek NC_ATTRIBUTE array on name, through its hash index.
  *  return match or NULL if Not Found.
  */
 NC_attr **
 NC_findattr(const NC_attrarray *ncap, const char *name)
 {
-	NC_attr **attrpp;
-	size_t attrid;
-	size_t slen;
+	int attrid;
 
 	assert(ncap != NULL);
 
-	if(ncap->nelems == 0)
-		return NULL;
-
-	attrpp = (NC_attr **) ncap->value;
-
-	slen = strlen(name);
-
-	for(attrid = 0; attrid < ncap->nelems; attrid++, attrpp++)
-	{
-		if(strlen((*attrpp)->name->cp) == slen &&
-			strncmp((*attrpp)->name->cp, name, slen) == 0)
-		{
-			return(attrpp); /* Normal return */
-		}
-	}
-	return(NULL);
+	attrid = NC_hashfind(&ncap->hash, (void *const *)ncap->value,
+		ncap->nelems, NC_attrname, name);
+	if(attrid == -1)
+		return(NULL);
+	return(&ncap->value[attrid]); /* Normal return */
 }
 
 
@@ -532,12 +531,14 @@ nc_rename_att( int ncid, int varid, const char *name, const char *newname)
 			return NC_ENOMEM;
 		attrp->name = newStr;
 		free_NC_string(old);
+		free_NC_hashmap(&ncap->hash);
 		return NC_NOERR;
 	}
 	/* else */
 	status = set_NC_string(old, newname);
 	if( status != NC_NOERR)
 		return status;
+	free_NC_hashmap(&ncap->hash);
 
 	set_NC_hdirty(ncp);
 
@@ -694,6 +695,7 @@ nc_del_att(int ncid, int varid, const char *name)
 	*attrpp = NULL;
 	/* decrement count */
 	ncap->nelems--;
+	free_NC_hashmap(&ncap->hash); /* elements moved */
 
 	free_NC_attr(old);
 
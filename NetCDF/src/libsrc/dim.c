@@ -110,40 +110,35 @@ find_NC_Udim(const NC_dimarray *ncap, NC_dim **dimpp)
 
 
 /*
- * Step thru NC_DIMENSION array, seeking match on name.
+ * Name of a dimension (see NC_hashfind()).
+ */
+static NC_string *
+NC_dimname(const void *elemp)
+{
+	return ((const NC_dim *)elemp)->name;
+}
+
+
+/*
+ * Seek NC_DIMENSION array on name, through its hash index.
  * Return dimid or -1 on not found.
  * *dimpp is set to the appropriate NC_dim.
- * The loop structure is odd. In order to parallelize,
- * we moved a clearer 'break' inside the loop body to the loop test.
  */
 static int
 NC_finddim(const NC_dimarray *ncap, const char *name, NC_dim **dimpp)
 {
+	int dimid;
 
 	assert(ncap != NULL);
 
-	if(ncap->nelems == 0)
-		return -1;
-
-	{
-	size_t slen = strlen(name);
-	int dimid = 0;
-	NC_dim **loc = (NC_dim **) ncap->value;
-
-	for(; (size_t) dimid < ncap->nelems
-			&& (strlen((*loc)->name->cp) != slen
-				|| strncmp((*loc)->name->cp, name, slen) != 0);
-		 dimid++, loc++)
-	{
-		/*EMPTY*/
-	}
-	if(dimid >= ncap->nelems)
+	dimid = NC_hashfind(&ncap->hash, (void *const *)ncap->value,
+		ncap->nelems, NC_dimname, name);
+	if(dimid == -1)
 		return(-1); /* not found */
 	/* else, normal return */
 	if(dimpp != NULL)
-			*dimpp = *loc;
+		*dimpp = ncap->value[dimid];
 	return(dimid);
-	}
 }
 
 
@@ -159,6 +154,8 @@ free_NC_dimarrayV0(NC_dimarray *ncap)
 {
 	assert(ncap != NULL);
 
+	free_NC_hashmap(&ncap->hash);
+
 	if(ncap->nelems == 0)
 		return;
 
@@ -504,6 +501,7 @@ nc_rename_dim( int ncid, int dimid, const char *newname)
 			return NC_ENOMEM;
 		dimp->name = newStr;
 		free_NC_string(old);
+		free_NC_hashmap(&ncp->dims.hash);
 		return NC_NOERR;
 	}
 
@@ -512,6 +510,7 @@ nc_rename_dim( int ncid, int dimid, const char *newname)
 	status = set_NC_string(dimp->name, newname);
 	if(status != NC_NOERR)
 		return status;
+	free_NC_hashmap(&ncp->dims.hash);
 
 	set_NC_hdirty(ncp);
 
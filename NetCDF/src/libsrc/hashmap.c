@@ -0,0 +1,143 @@
+/*
+ *	Copyright 1996, University Corporation for Atmospheric Research
+ *      See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+/* $Id$ */
+
+#include "nc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+ * Name index of the dimension, variable and attribute arrays.
+ *
+ * The index is a cache of the array: open addressing (linear probing)
+ * on element numbers, with at least twice as many slots as elements.
+ * It is built on the first search of an array of NC_HASH_MIN elements
+ * or more, then catches up with elements appended since (i.e. define
+ * or header read). Anything else that changes names or moves elements
+ * (rename, delete, free) must drop it with free_NC_hashmap().
+ * Without memory, searches fall back to a linear scan.
+ */
+
+#ifndef NC_HASH_MIN
+#define NC_HASH_MIN 16 /* smaller arrays are scanned */
+#endif
+
+/*
+ * FNV-1a hash of a name.
+ */
+static size_t
+hash_name(const char *name)
+{
+	unsigned long hh = 2166136261UL;
+	const unsigned char *cp = (const unsigned char *)name;
+	for( /*NADA*/; *cp != 0; cp++)
+	{
+		hh ^= *cp;
+		hh *= 16777619UL;
+	}
+	return (size_t)hh;
+}
+
+
+/*
+ * Free the index (i.e. it is built again on next search).
+ */
+void
+free_NC_hashmap(NC_hashmap *hmp)
+{
+	assert(hmp != NULL);
+
+	if(hmp->slots != NULL)
+		free(hmp->slots);
+	hmp->slots = NULL;
+	hmp->nslots = 0;
+	hmp->nelems = 0;
+}
+
+
+/*
+ * Put element elem in its slot.
+ */
+static void
+hash_insert(NC_hashmap *hmp, size_t elem, const char *name)
+{
+	const size_t mask = hmp->nslots - 1;
+	size_t ii = hash_name(name) & mask;
+	while(hmp->slots[ii] != 0)
+		ii = (ii + 1) & mask;
+	hmp->slots[ii] = elem + 1;
+}
+
+
+/*
+ * Index the elements appended since last search,
+ * growing the slots (i.e. index built again) if needed.
+ */
+static int
+hash_update(NC_hashmap *hmp, void *const *value, size_t nelems,
+	NC_hashname *namef)
+{
+	if(hmp->nelems > nelems)
+		free_NC_hashmap(hmp); /* not dropped on a change */
+
+	if(2 * nelems > hmp->nslots)
+	{
+		size_t nslots = 64;
+		size_t *slots;
+		while(nslots < 4 * nelems)
+			nslots *= 2;
+		slots = (size_t *) calloc(nslots, sizeof(size_t));
+		if(slots == NULL)
+			return NC_ENOMEM;
+		free_NC_hashmap(hmp);
+		hmp->slots = slots;
+		hmp->nslots = nslots;
+	}
+
+	for( /*NADA*/; hmp->nelems < nelems; hmp->nelems++)
+		hash_insert(hmp, hmp->nelems, namef(value[hmp->nelems])->cp);
+
+	return NC_NOERR;
+}
+
+
+/*
+ * Search name in an array of nelems elements (e.g. ncap->value),
+ * namef giving the name of an element.
+ * Return the element number or -1 on not found.
+ */
+int
+NC_hashfind(const NC_hashmap *hmp, void *const *value, size_t nelems,
+	NC_hashname *namef, const char *name)
+{
+	NC_hashmap *const hp = (NC_hashmap *)hmp; /* cast away const: cache */
+	const size_t slen = strlen(name);
+	size_t ii;
+
+	if(nelems == 0)
+		return -1;
+
+	if(nelems >= NC_HASH_MIN && hash_update(hp, value, nelems, namef) == NC_NOERR)
+	{
+		const size_t mask = hp->nslots - 1;
+		for(ii = hash_name(name) & mask; hp->slots[ii] != 0; ii = (ii + 1) & mask)
+		{
+			const char *cp = namef(value[hp->slots[ii] - 1])->cp;
+			if(strlen(cp) == slen && strncmp(cp, name, slen) == 0)
+				return (int)(hp->slots[ii] - 1);
+		}
+		return -1;
+	}
+
+	/* small array (or no memory) */
+	for(ii = 0; ii < nelems; ii++)
+	{
+		const char *cp = namef(value[ii])->cp;
+		if(strlen(cp) == slen && strncmp(cp, name, slen) == 0)
+			return (int)ii;
+	}
+	return -1;
+}
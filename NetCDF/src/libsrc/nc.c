@@ -929,6 +929,15 @@ nc__create_mp(const char * path, int ioflags, size_t initialsz, int basepe,
 		fSet(ncp->flags, NC_NSYNC);
 	}
 
+	if(fIsSet(ioflags, NC_DEFER_NUMRECS))
+	{
+		/*
+		 * Records are still shared, but the number of records
+		 * is written only by nc_sync() (or nc_redef(), nc_close()).
+		 */
+		fSet(ncp->flags, NC_DEFER_NUMRECS);
+	}
+
 	status = ncx_put_NC(ncp, &xp, sizeof_off_t, ncp->xsz);
 	if(status != NC_NOERR)
 		goto unwind_ioc;
@@ -1029,6 +1038,15 @@ nc__open_mp(const char * path, int ioflags, int basepe,
 		fSet(ncp->flags, NC_NSYNC);
 	}
 
+	if(fIsSet(ioflags, NC_DEFER_NUMRECS))
+	{
+		/*
+		 * Records are still shared, but the number of records
+		 * is written only by nc_sync() (or nc_redef(), nc_close()).
+		 */
+		fSet(ncp->flags, NC_DEFER_NUMRECS);
+	}
+
 	status = nc_get_NC(ncp);
 	if(status != NC_NOERR)
 		goto unwind_ioc;
@@ -1248,6 +1266,13 @@ nc_redef(int ncid)
 	
 	if(fIsSet(ncp->nciop->ioflags, NC_SHARE))
 	{
+		/* numrecs may be deferred (i.e. NC_DEFER_NUMRECS) */
+		if(NC_ndirty(ncp))
+		{
+			status = write_numrecs(ncp);
+			if(status != NC_NOERR)
+				return status;
+		}
 		/* read in from disk */
 		status = read_NC(ncp);
 		if(status != NC_NOERR)
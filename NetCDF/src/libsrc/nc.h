@@ -71,6 +71,29 @@ set_NC_string(NC_string *ncstrp, const char *str);
 
 /* End defined in string.c */
 
+/*
+ * Hash index of the names of a dimension, variable or attribute array,
+ * built when the array is searched.
+ */
+typedef struct {
+	size_t nslots;		/* number of slots (power of 2), 0 if not built */
+	size_t nelems;		/* number of elements indexed */
+	size_t *slots;		/* element number +1, 0 if empty */
+} NC_hashmap;
+
+/* name of an array element */
+typedef NC_string *NC_hashname(const void *elemp);
+
+/* Begin defined in hashmap.c */
+extern void
+free_NC_hashmap(NC_hashmap *hmp);
+
+extern int
+NC_hashfind(const NC_hashmap *hmp, void *const *value, size_t nelems,
+	NC_hashname *namef, const char *name);
+
+/* End defined in hashmap.c */
+
 /*
  * NC dimension stucture
  */
@@ -82,6 +105,7 @@ typedef struct {
 
 typedef struct NC_dimarray {
 	size_t nalloc;		/* number allocated >= nelems */
+	NC_hashmap hash;	/* name index (see NC_hashfind()) */
 	/* below gets xdr'd */
 	/* NCtype type = NC_DIMENSION */
 	size_t nelems;		/* length of the array */
@@ -129,6 +153,7 @@ typedef struct {
 
 typedef struct NC_attrarray {
 	size_t nalloc;		/* number allocated >= nelems */
+	NC_hashmap hash;	/* name index (see NC_hashfind()) */
 	/* below gets xdr'd */
 	/* NCtype type = NC_ATTRIBUTE */
 	size_t nelems;		/* length of the array */
@@ -186,6 +211,7 @@ typedef struct {
 
 typedef struct NC_vararray {
 	size_t nalloc;		/* number allocated >= nelems */
+	NC_hashmap hash;	/* name index (see NC_hashfind()) */
 	/* below gets xdr'd */
 	/* NCtype type = NC_VARIABLE */
 	size_t nelems;		/* length of the array */
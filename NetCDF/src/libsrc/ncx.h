@@ -668,4 +668,12 @@ ncx_putn_void(void **xpp, size_t nchars, const void *vp);
 extern int
 ncx_pad_putn_void(void **xpp, size_t nchars, const void *vp);
 
+/*
+ * Set the highest SIMD kernel set used by the conversions
+ * (-1: all the CPU has, 0: scalar, 1: SSSE3, 2: AVX2),
+ * return the set in use.
+ */
+extern int
+ncx_set_simd(int level);
+
 #endif /* _NCX_H_ */
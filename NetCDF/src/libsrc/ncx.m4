@@ -95,11 +95,248 @@ static const char nada[X_ALIGN] = {0, 0, 0, 0};
 		(((a) >>  8) & 0x0000ff00) | \
 		(((a) >> 24) & 0x000000ff) )
 
+/*
+ * SIMD kernels (i.e. SSSE3 or AVX2 byte shuffle) used by the swapn?b()
+ * routines and the short <-> float conversions, chosen at run time
+ * from the CPU. They process whole vectors and return the number of
+ * bytes or elements done, the scalar loops doing the tail (and all
+ * of the work on other CPUs or compilers).
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+	&& (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) \
+	&& !defined(NCX_NO_SIMD)
+#define NCX_SIMD 1
+#include <immintrin.h>
+
+/* byte order of each 2, 4 or 8 byte element, for both 128 bit lanes */
+static const char swap2_mask[32] = {
+	1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+	1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+static const char swap4_mask[32] = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+/* low 16 bits of each int, byte swapped, in the low 8 bytes of a lane */
+static const char short4_mask[32] = {
+	1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1,
+	1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1};
+static const char swap8_mask[32] = {
+	7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+	7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8};
+
+/* highest kernel set in use: 0 scalar, 1 SSSE3, 2 AVX2 (-1 not set yet) */
+static int simd_level = -1;
+/* highest kernel set allowed (see ncx_set_simd()) */
+static int simd_max = 2;
+
+static int
+simd(void)
+{
+	if(simd_level < 0)
+	{
+		int level = 0;
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2"))
+			level = 2;
+		else if(__builtin_cpu_supports("ssse3"))
+			level = 1;
+		simd_level = (level < simd_max) ? level : simd_max;
+	}
+	return simd_level;
+}
+
+__attribute__((target("ssse3")))
+static size_t
+swapn_ssse3(char *op, const char *ip, size_t nbytes, const char *mask)
+{
+	const __m128i mm = _mm_loadu_si128((const __m128i *)mask);
+	size_t done;
+	for(done = 0; done + 16 <= nbytes; done += 16)
+	{
+		const __m128i xx = _mm_loadu_si128((const __m128i *)(ip + done));
+		_mm_storeu_si128((__m128i *)(op + done), _mm_shuffle_epi8(xx, mm));
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static size_t
+swapn_avx2(char *op, const char *ip, size_t nbytes, const char *mask)
+{
+	const __m256i mm = _mm256_loadu_si256((const __m256i *)mask);
+	size_t done;
+	for(done = 0; done + 64 <= nbytes; done += 64)
+	{
+		const __m256i x0 = _mm256_loadu_si256((const __m256i *)(ip + done));
+		const __m256i x1 = _mm256_loadu_si256((const __m256i *)(ip + done + 32));
+		_mm256_storeu_si256((__m256i *)(op + done), _mm256_shuffle_epi8(x0, mm));
+		_mm256_storeu_si256((__m256i *)(op + done + 32), _mm256_shuffle_epi8(x1, mm));
+	}
+	for( ; done + 32 <= nbytes; done += 32)
+	{
+		const __m256i xx = _mm256_loadu_si256((const __m256i *)(ip + done));
+		_mm256_storeu_si256((__m256i *)(op + done), _mm256_shuffle_epi8(xx, mm));
+	}
+	return done;
+}
+
+/* swap the whole vectors of nbytes, return the number of bytes swapped */
+static size_t
+simd_swapn(char *op, const char *ip, size_t nbytes, const char *mask)
+{
+	if(nbytes < 16)
+		return 0;
+	switch(simd()) {
+	case 2:
+		return swapn_avx2(op, ip, nbytes, mask);
+	case 1:
+		return swapn_ssse3(op, ip, nbytes, mask);
+	}
+	return 0;
+}
+
+/* external shorts to floats, 8 at a time */
+__attribute__((target("ssse3")))
+static size_t
+getn_short_float_ssse3(const char *xp, size_t nelems, float *tp)
+{
+	const __m128i mm = _mm_loadu_si128((const __m128i *)swap2_mask);
+	size_t done;
+	for(done = 0; done + 8 <= nelems; done += 8)
+	{
+		const __m128i xx = _mm_shuffle_epi8(
+			_mm_loadu_si128((const __m128i *)(xp + 2 * done)), mm);
+		/* sign extension: short in upper half, arithmetic right shifting */
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(xx, xx), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(xx, xx), 16);
+		_mm_storeu_ps(tp + done, _mm_cvtepi32_ps(lo));
+		_mm_storeu_ps(tp + done + 4, _mm_cvtepi32_ps(hi));
+	}
+	return done;
+}
+
+/* external shorts to floats, 16 at a time */
+__attribute__((target("avx2")))
+static size_t
+getn_short_float_avx2(const char *xp, size_t nelems, float *tp)
+{
+	const __m256i mm = _mm256_loadu_si256((const __m256i *)swap2_mask);
+	size_t done;
+	for(done = 0; done + 16 <= nelems; done += 16)
+	{
+		const __m256i xx = _mm256_shuffle_epi8(
+			_mm256_loadu_si256((const __m256i *)(xp + 2 * done)), mm);
+		const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(xx));
+		const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(xx, 1));
+		_mm256_storeu_ps(tp + done, _mm256_cvtepi32_ps(lo));
+		_mm256_storeu_ps(tp + done + 8, _mm256_cvtepi32_ps(hi));
+	}
+	return done;
+}
+
+/*
+ * floats to external shorts, 8 at a time, same bytes as
+ * ncx_put_short_float(): truncation to int, then its low 16 bits
+ * (i.e. out of range values wrap, NaN gives 0 as the scalar cast),
+ * NC_ERANGE flag set if any value is out of range.
+ */
+__attribute__((target("ssse3")))
+static size_t
+putn_short_float_ssse3(char *xp, size_t nelems, const float *tp, int *erange)
+{
+	const __m128i mm = _mm_loadu_si128((const __m128i *)short4_mask);
+	const __m128 smax = _mm_set1_ps((float)X_SHORT_MAX);
+	const __m128 smin = _mm_set1_ps((float)X_SHORT_MIN);
+	__m128 out = _mm_setzero_ps();
+	size_t done;
+	for(done = 0; done + 8 <= nelems; done += 8)
+	{
+		const __m128 a = _mm_loadu_ps(tp + done);
+		const __m128 b = _mm_loadu_ps(tp + done + 4);
+		const __m128i xx = _mm_unpacklo_epi64(
+			_mm_shuffle_epi8(_mm_cvttps_epi32(a), mm),
+			_mm_shuffle_epi8(_mm_cvttps_epi32(b), mm));
+		out = _mm_or_ps(out, _mm_or_ps(
+			_mm_or_ps(_mm_cmpgt_ps(a, smax), _mm_cmplt_ps(a, smin)),
+			_mm_or_ps(_mm_cmpgt_ps(b, smax), _mm_cmplt_ps(b, smin))));
+		_mm_storeu_si128((__m128i *)(xp + 2 * done), xx);
+	}
+	*erange = _mm_movemask_ps(out) != 0;
+	return done;
+}
+
+/* floats to external shorts, 16 at a time */
+__attribute__((target("avx2")))
+static size_t
+putn_short_float_avx2(char *xp, size_t nelems, const float *tp, int *erange)
+{
+	const __m256i mm = _mm256_loadu_si256((const __m256i *)short4_mask);
+	const __m256 smax = _mm256_set1_ps((float)X_SHORT_MAX);
+	const __m256 smin = _mm256_set1_ps((float)X_SHORT_MIN);
+	__m256 out = _mm256_setzero_ps();
+	size_t done;
+	for(done = 0; done + 16 <= nelems; done += 16)
+	{
+		const __m256 a = _mm256_loadu_ps(tp + done);
+		const __m256 b = _mm256_loadu_ps(tp + done + 8);
+		/* shuffle and unpack work in 128 bit lanes: put quadwords back in order */
+		const __m256i xx = _mm256_permute4x64_epi64(
+			_mm256_unpacklo_epi64(
+				_mm256_shuffle_epi8(_mm256_cvttps_epi32(a), mm),
+				_mm256_shuffle_epi8(_mm256_cvttps_epi32(b), mm)),
+			0xd8);
+		out = _mm256_or_ps(out, _mm256_or_ps(
+			_mm256_or_ps(_mm256_cmp_ps(a, smax, _CMP_GT_OQ), _mm256_cmp_ps(a, smin, _CMP_LT_OQ)),
+			_mm256_or_ps(_mm256_cmp_ps(b, smax, _CMP_GT_OQ), _mm256_cmp_ps(b, smin, _CMP_LT_OQ))));
+		_mm256_storeu_si256((__m256i *)(xp + 2 * done), xx);
+	}
+	*erange = _mm256_movemask_ps(out) != 0;
+	return done;
+}
+
+static size_t
+simd_getn_short_float(const char *xp, size_t nelems, float *tp)
+{
+	if(nelems < 8)
+		return 0;
+	switch(simd()) {
+	case 2:
+		return getn_short_float_avx2(xp, nelems, tp);
+	case 1:
+		return getn_short_float_ssse3(xp, nelems, tp);
+	}
+	return 0;
+}
+
+static size_t
+simd_putn_short_float(char *xp, size_t nelems, const float *tp, int *erange)
+{
+	*erange = 0;
+	if(nelems < 8)
+		return 0;
+	switch(simd()) {
+	case 2:
+		return putn_short_float_avx2(xp, nelems, tp, erange);
+	case 1:
+		return putn_short_float_ssse3(xp, nelems, tp, erange);
+	}
+	return 0;
+}
+
+#endif /* NCX_SIMD */
+
 static void
 swapn2b(void *dst, const void *src, size_t nn)
 {
 	char *op = dst;
 	const char *ip = src;
+#if NCX_SIMD
+	{
+		const size_t done = simd_swapn(op, ip, 2 * nn, swap2_mask);
+		op += done;
+		ip += done;
+		nn -= done / 2;
+	}
+#endif
 	while(nn-- != 0)
 	{
 		*op++ = *(++ip);
@@ -125,6 +362,14 @@ swapn4b(void *dst, const void *src, size_t nn)
 {
 	char *op = dst;
 	const char *ip = src;
+#if NCX_SIMD
+	{
+		const size_t done = simd_swapn(op, ip, 4 * nn, swap4_mask);
+		op += done;
+		ip += done;
+		nn -= done / 4;
+	}
+#endif
 	while(nn-- != 0)
 	{
 		op[0] = ip[3];
@@ -159,6 +404,14 @@ swapn8b(void *dst, const void *src, size_t nn)
 {
 	char *op = dst;
 	const char *ip = src;
+#if NCX_SIMD
+	{
+		const size_t done = simd_swapn(op, ip, 8 * nn, swap8_mask);
+		op += done;
+		ip += done;
+		nn -= done / 8;
+	}
+#endif
 	while(nn-- != 0)
 	{
 		op[0] = ip[7];
@@ -177,6 +430,23 @@ swapn8b(void *dst, const void *src, size_t nn)
 
 #endif /* LITTLE_ENDIAN */
 
+/*
+ * Set the highest SIMD kernel set used by the conversions
+ * (-1: all the CPU has, 0: scalar, 1: SSSE3, 2: AVX2),
+ * return the set in use.
+ */
+int
+ncx_set_simd(int level)
+{
+#if NCX_SIMD
+	simd_max = (level < 0 || level > 2) ? 2 : level;
+	simd_level = -1;
+	return simd();
+#else
+	return 0;
+#endif
+}
+
 
 /*
  * Primitive numeric conversion functions.
@@ -2268,7 +2538,32 @@ NCX_GETN(short, short)
 #endif
 NCX_GETN(short, int)
 NCX_GETN(short, long)
-NCX_GETN(short, float)
+/* SIMD version */
+int
+ncx_getn_short_float(const void **xpp, size_t nelems, float *tp)
+{
+	const char *xp = (const char *) *xpp;
+	int status = ENOERR;
+
+#if NCX_SIMD
+	{
+		const size_t done = simd_getn_short_float(xp, nelems, tp);
+		xp += done * X_SIZEOF_SHORT;
+		tp += done;
+		nelems -= done;
+	}
+#endif
+	for( ; nelems != 0; nelems--, xp += X_SIZEOF_SHORT, tp++)
+	{
+		const int lstatus = ncx_get_short_float(xp, tp);
+		if(lstatus != ENOERR)
+			status = lstatus;
+	}
+
+	*xpp = (const void *)xp;
+	return status;
+}
+
 NCX_GETN(short, double)
 
 NCX_PAD_GETN_SHORT(schar)
@@ -2299,7 +2594,35 @@ NCX_PUTN(short, short)
 #endif
 NCX_PUTN(short, int)
 NCX_PUTN(short, long)
-NCX_PUTN(short, float)
+/* SIMD version */
+int
+ncx_putn_short_float(void **xpp, size_t nelems, const float *tp)
+{
+	char *xp = (char *) *xpp;
+	int status = ENOERR;
+
+#if NCX_SIMD
+	{
+		int erange;
+		const size_t done = simd_putn_short_float(xp, nelems, tp, &erange);
+		if(erange)
+			status = NC_ERANGE;
+		xp += done * X_SIZEOF_SHORT;
+		tp += done;
+		nelems -= done;
+	}
+#endif
+	for( ; nelems != 0; nelems--, xp += X_SIZEOF_SHORT, tp++)
+	{
+		int lstatus = ncx_put_short_float(xp, tp);
+		if(lstatus != ENOERR)
+			status = lstatus;
+	}
+
+	*xpp = (void *)xp;
+	return status;
+}
+
 NCX_PUTN(short, double)
 
 NCX_PAD_PUTN_SHORT(schar)
@@ -25,6 +25,12 @@
 #include <unistd.h>
 #endif
 
+/* memory mapped I/O (i.e. NC_MMAP), else NC_MMAP is ignored */
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0 && defined(HAVE_FTRUNCATE)
+#include <sys/mman.h>
+#define NCIO_MMAP 1
+#endif
+
 #ifndef SEEK_SET
 #define SEEK_SET 0
 #define SEEK_CUR 1
@@ -1294,6 +1300,400 @@ ncio_spx_init(ncio *const nciop)
 }
 
 
+#if NCIO_MMAP
+/* Begin mm */
+
+/* The mm functions map the whole file in memory, when NC_MMAP is
+   set. A region is the mapped memory itself, so get() and rel() do
+   no I/O and no copy (i.e. no ncio buffer as in px and spx): the
+   kernel pages data in and out of the page cache.
+
+   The file grows by large extents (i.e. ftruncate() to a multiple of
+   NCIO_MM_EXTENT), the mapping by doubling, so that a sequential
+   writer seldom remaps. At close, the file is truncated back to its
+   logical end (i.e. highest byte requested for writing).
+
+   Reads are hinted as sequential, and the extent ahead of the last
+   read is requested (i.e. MADV_WILLNEED) when a read crosses it.
+   Reads beyond the end of the file get zeros, as px_pgin() does,
+   through a small private buffer.
+*/
+
+#ifndef NCIO_MM_EXTENT
+#define NCIO_MM_EXTENT 16777216 /* 16 MiB: growth of file and read ahead */
+#endif
+
+/* This struct is for POSIX systems, with NC_MMAP set.
+
+   extent - growth of file and read ahead, multiple of pagesize.
+   size - current size of file on disk.
+   high - logical end of file, size of file at close.
+   advised - end of the region already requested (i.e. read ahead).
+   mapped - length of mapping (may be larger than file size).
+   base - address of mapping (NULL if nothing mapped yet).
+   bf_base - buffer for reads beyond end of file.
+   bf_extent - size of that buffer.
+   refcount - number of regions not released yet.
+*/
+typedef struct ncio_mm {
+	size_t	extent;
+	off_t	size;
+	off_t	high;
+	off_t	advised;
+	size_t	mapped;
+	void	*base;
+	void	*bf_base;
+	size_t	bf_extent;
+	int	refcount;
+} ncio_mm;
+
+
+/* Map (again) the file with length at least len, doubling the mapping
+   length. No region may be held, as the mapping may move.
+*/
+static int
+mm_map(ncio *const nciop, ncio_mm *const mmp, size_t len)
+{
+	const int prot = fIsSet(nciop->ioflags, NC_WRITE)
+		? (PROT_READ|PROT_WRITE) : PROT_READ;
+	void *base;
+
+	assert(mmp->refcount <= 0);
+
+	if(len < 2 * mmp->mapped)
+		len = 2 * mmp->mapped;
+	len = _RNDUP(len, mmp->extent);
+
+	if(mmp->base != NULL)
+	{
+		(void) munmap(mmp->base, mmp->mapped);
+		mmp->base = NULL;
+		mmp->mapped = 0;
+	}
+
+	base = mmap(NULL, len, prot, MAP_SHARED, nciop->fd, 0);
+	if(base == MAP_FAILED)
+		return errno;
+#ifdef MADV_SEQUENTIAL
+	(void) madvise(base, len, MADV_SEQUENTIAL);
+#endif
+	mmp->base = base;
+	mmp->mapped = len;
+	return ENOERR;
+}
+
+
+/* Grow the file (and its mapping) so that it holds at least end
+   bytes. The file grows by whole extents.
+*/
+static int
+mm_grow(ncio *const nciop, ncio_mm *const mmp, off_t end)
+{
+	const off_t size = (off_t)_RNDUP(end, (off_t)mmp->extent);
+
+	if(end <= mmp->size)
+		return ENOERR;
+
+	if(ftruncate(nciop->fd, size) < 0)
+		return errno;
+	mmp->size = size;
+
+	if((size_t)size > mmp->mapped)
+		return mm_map(nciop, mmp, (size_t)size);
+	return ENOERR;
+}
+
+
+/* Request the extent after offset, if not requested yet (i.e. read
+   ahead of sequential reads).
+*/
+static void
+mm_advise(ncio_mm *const mmp, off_t offset, size_t extent)
+{
+#ifdef MADV_WILLNEED
+	const size_t pgsz = pagesize();
+	off_t lower;
+	off_t upper;
+
+	if((off_t)(offset + extent) <= mmp->advised)
+		return;
+	lower = _RNDDOWN(offset, (off_t)pgsz);
+	upper = lower + (off_t)mmp->extent;
+	if(upper > mmp->size)
+		upper = mmp->size;
+	if(upper > lower)
+		(void) madvise((char *)mmp->base + lower,
+			(size_t)(upper - lower), MADV_WILLNEED);
+	mmp->advised = upper;
+#endif
+}
+
+
+/* Read a region beyond the end of the file: copy what exists and fill
+   the rest with zeros in the private buffer.
+*/
+static int
+mm_get_eof(ncio_mm *const mmp,
+		off_t offset, size_t extent,
+		void **const vpp)
+{
+	size_t avail = 0;
+
+	if(extent > mmp->bf_extent)
+	{
+		void *const bf = realloc(mmp->bf_base, extent);
+		if(bf == NULL)
+			return ENOMEM;
+		mmp->bf_base = bf;
+		mmp->bf_extent = extent;
+	}
+	if(offset < mmp->size)
+	{
+		avail = (size_t)(mmp->size - offset);
+		(void) memcpy(mmp->bf_base, (char *)mmp->base + offset, avail);
+	}
+	(void) memset((char *)mmp->bf_base + avail, 0, extent - avail);
+	*vpp = mmp->bf_base;
+	return ENOERR;
+}
+
+
+/* Release a region. Nothing to write back: the region is the mapping.
+*/
+static int
+ncio_mm_rel(ncio *const nciop, off_t offset, int rflags)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+
+	if(fIsSet(rflags, RGN_MODIFIED) && !fIsSet(nciop->ioflags, NC_WRITE))
+		return EPERM; /* attempt to write readonly file */
+
+	mmp->refcount--;
+	return ENOERR;
+}
+
+
+/* Make the region (offset, extent) available through *vpp, that is
+   return its address in the mapping. A region to write beyond the end
+   of the file grows the file first.
+*/
+static int
+ncio_mm_get(ncio *const nciop,
+		off_t offset, size_t extent,
+		int rflags,
+		void **const vpp)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+	const off_t end = offset + (off_t)extent;
+	int status = ENOERR;
+
+	if(fIsSet(rflags, RGN_WRITE) && !fIsSet(nciop->ioflags, NC_WRITE))
+		return EPERM; /* attempt to write readonly file */
+
+	if(end > mmp->size)
+	{
+		if(!fIsSet(rflags, RGN_WRITE))
+		{
+			status = mm_get_eof(mmp, offset, extent, vpp);
+			if(status == ENOERR)
+				mmp->refcount++;
+			return status;
+		}
+		status = mm_grow(nciop, mmp, end);
+		if(status != ENOERR)
+			return status;
+	}
+
+	if(fIsSet(rflags, RGN_WRITE))
+	{
+		if(end > mmp->high)
+			mmp->high = end;
+	}
+	else
+		mm_advise(mmp, offset, extent);
+
+	mmp->refcount++;
+	*vpp = (char *)mmp->base + offset;
+	return ENOERR;
+}
+
+
+/* Like memmove(), safely move possibly overlapping data, in the
+   mapping.
+*/
+static int
+ncio_mm_move(ncio *const nciop, off_t to, off_t from,
+			size_t nbytes, int rflags)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+	const off_t end = (to > from ? to : from) + (off_t)nbytes;
+	int status;
+
+	if(!fIsSet(nciop->ioflags, NC_WRITE))
+		return EPERM; /* attempt to write readonly file */
+
+	if(to == from || nbytes == 0)
+		return ENOERR; /* NOOP */
+
+	rflags &= RGN_NOLOCK; /* filter unwanted flags */
+
+	status = mm_grow(nciop, mmp, end);
+	if(status != ENOERR)
+		return status;
+
+	(void) memmove((char *)mmp->base + to,
+		(char *)mmp->base + from, nbytes);
+	if(to + (off_t)nbytes > mmp->high)
+		mmp->high = to + (off_t)nbytes;
+
+	return ENOERR;
+}
+
+
+/* Nothing buffered to write out: the mapping shares the page cache.
+   For a readonly dataset, follow a file grown by another process so
+   that the next get() sees its data (e.g. records of a NC_SHARE
+   writer).
+*/
+static int
+ncio_mm_sync(ncio *const nciop)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+	struct stat sb;
+
+	if(fIsSet(nciop->ioflags, NC_WRITE))
+	{
+		if(fIsSet(nciop->ioflags, NC_SHARE) && mmp->base != NULL
+			&& msync(mmp->base, (size_t)mmp->high, MS_ASYNC) < 0)
+			return errno;
+		return ENOERR;
+	}
+
+	if(fstat(nciop->fd, &sb) < 0)
+		return errno;
+	if(sb.st_size > mmp->size)
+	{
+		mmp->size = sb.st_size;
+		mmp->high = sb.st_size;
+		if((size_t)sb.st_size > mmp->mapped)
+			return mm_map(nciop, mmp, (size_t)sb.st_size);
+	}
+	return ENOERR;
+}
+
+
+/* Unmap the file and truncate it to its logical end. Called from
+   ncio_close(), before the file is closed.
+*/
+static int
+ncio_mm_close(ncio *const nciop)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+
+	if(mmp->base != NULL)
+	{
+		(void) munmap(mmp->base, mmp->mapped);
+		mmp->base = NULL;
+		mmp->mapped = 0;
+	}
+	if(fIsSet(nciop->ioflags, NC_WRITE) && mmp->size != mmp->high)
+	{
+		if(ftruncate(nciop->fd, mmp->high) < 0)
+			return errno;
+		mmp->size = mmp->high;
+	}
+	return ENOERR;
+}
+
+
+/* Internal function called at close to
+   free up anything hanging off pvt.
+*/
+static void
+ncio_mm_free(void *const pvt)
+{
+	ncio_mm *const mmp = (ncio_mm *)pvt;
+	if(mmp == NULL)
+		return;
+
+	if(mmp->base != NULL)
+	{
+		(void) munmap(mmp->base, mmp->mapped);
+		mmp->base = NULL;
+		mmp->mapped = 0;
+	}
+	if(mmp->bf_base != NULL)
+	{
+		free(mmp->bf_base);
+		mmp->bf_base = NULL;
+		mmp->bf_extent = 0;
+	}
+}
+
+
+/* Second half of the ncio_mm initialization, after the file has been
+   opened: map the existing file (if not empty) and grow it to
+   initialsz (i.e. as fgrow(), never shorter).
+
+   The size hint is only returned (i.e. chunk size of the nc layer),
+   the mapping has no buffer size.
+*/
+static int
+ncio_mm_init2(ncio *const nciop, size_t initialsz)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+	struct stat sb;
+
+	assert(nciop->fd >= 0);
+
+	mmp->extent = _RNDUP(NCIO_MM_EXTENT, pagesize());
+
+	if(fstat(nciop->fd, &sb) < 0)
+		return errno;
+	mmp->size = sb.st_size;
+	mmp->high = sb.st_size;
+
+	if((off_t)initialsz > mmp->high)
+	{
+		mmp->high = (off_t)initialsz;
+		return mm_grow(nciop, mmp, mmp->high);
+	}
+	if(mmp->size > 0)
+		return mm_map(nciop, mmp, (size_t)mmp->size);
+	return ENOERR;
+}
+
+
+/* First half of init for ncio_mm struct, setting the rel, get, move,
+   sync, and free function pointers to the NC_MMAP versions of these
+   functions (i.e. the ncio_mm_* functions).
+*/
+static void
+ncio_mm_init(ncio *const nciop)
+{
+	ncio_mm *const mmp = (ncio_mm *)nciop->pvt;
+
+	*((ncio_relfunc **)&nciop->rel) = ncio_mm_rel; /* cast away const */
+	*((ncio_getfunc **)&nciop->get) = ncio_mm_get; /* cast away const */
+	*((ncio_movefunc **)&nciop->move) = ncio_mm_move; /* cast away const */
+	*((ncio_syncfunc **)&nciop->sync) = ncio_mm_sync; /* cast away const */
+	*((ncio_freefunc **)&nciop->free) = ncio_mm_free; /* cast away const */
+
+	mmp->extent = 0;
+	mmp->size = 0;
+	mmp->high = 0;
+	mmp->advised = 0;
+	mmp->mapped = 0;
+	mmp->base = NULL;
+	mmp->bf_base = NULL;
+	mmp->bf_extent = 0;
+	mmp->refcount = 0;
+}
+
+/* End mm */
+#endif /* NCIO_MMAP */
+
+
 /* */
 
 /* This will call whatever free function is attached to the free
@@ -1315,8 +1715,8 @@ ncio_free(ncio *nciop)
 
 
 /* Create a new ncio struct to hold info about the file. This will
-   create and init the ncio_px or ncio_spx struct (the latter if
-   NC_SHARE is used.)
+   create and init the ncio_mm, ncio_px or ncio_spx struct (the first
+   if NC_MMAP is used, else the last if NC_SHARE is used.)
 */
 static ncio *
 ncio_new(const char *path, int ioflags)
@@ -1330,6 +1730,13 @@ ncio_new(const char *path, int ioflags)
 	fSet(ioflags, NC_SHARE);
 #endif
 
+#if NCIO_MMAP
+	if(fIsSet(ioflags, NC_MMAP))
+		sz_ncio_pvt = sizeof(ncio_mm);
+	else
+#else
+	fClr(ioflags, NC_MMAP); /* not available, use px or spx */
+#endif
 	if(fIsSet(ioflags, NC_SHARE))
 		sz_ncio_pvt = sizeof(ncio_spx);
 	else
@@ -1348,6 +1755,11 @@ ncio_new(const char *path, int ioflags)
 				/* cast away const */
 	*((void **)&nciop->pvt) = (void *)(nciop->path + sz_path);
 
+#if NCIO_MMAP
+	if(fIsSet(ioflags, NC_MMAP))
+		ncio_mm_init(nciop);
+	else
+#endif
 	if(fIsSet(ioflags, NC_SHARE))
 		ncio_spx_init(nciop);
 	else
@@ -1442,6 +1854,11 @@ ncio_create(const char *path, int ioflags,
 		*sizehintp = M_RNDUP(*sizehintp);
 	}
 
+#if NCIO_MMAP
+	if(fIsSet(nciop->ioflags, NC_MMAP))
+		status = ncio_mm_init2(nciop, initialsz);
+	else
+#endif
 	if(fIsSet(nciop->ioflags, NC_SHARE))
 		status = ncio_spx_init2(nciop, sizehintp);
 	else
@@ -1450,7 +1867,7 @@ ncio_create(const char *path, int ioflags,
 	if(status != ENOERR)
 		goto unwind_open;
 
-	if(initialsz != 0)
+	if(initialsz != 0 && !fIsSet(nciop->ioflags, NC_MMAP))
 	{
 		status = fgrow(fd, (off_t)initialsz);
 		if(status != ENOERR)
@@ -1566,6 +1983,11 @@ ncio_open(const char *path,
 		*sizehintp = M_RNDUP(*sizehintp);
 	}
 
+#if NCIO_MMAP
+	if(fIsSet(nciop->ioflags, NC_MMAP))
+		status = ncio_mm_init2(nciop, 0);
+	else
+#endif
 	if(fIsSet(nciop->ioflags, NC_SHARE))
 		status = ncio_spx_init2(nciop, sizehintp);
 	else
@@ -1616,6 +2038,15 @@ ncio_close(ncio *nciop, int doUnlink)
 
 	status = nciop->sync(nciop);
 
+#if NCIO_MMAP
+	if(fIsSet(nciop->ioflags, NC_MMAP))
+	{
+		const int lstatus = ncio_mm_close(nciop);
+		if(status == ENOERR)
+			status = lstatus;
+	}
+#endif
+
 	(void) close(nciop->fd);
 	
 	if(doUnlink)
@@ -341,9 +341,14 @@ NCtouchlast(NC *ncp, const NC_var *const *varpp, size_t recno)
 /*
  * Ensure that the netcdf file has 'numrecs' records,
  * add records and fill as neccessary.
+ * Records from 'fillrecs' on are not filled
+ * (i.e. the caller writes them whole).
+ * The header numrecs is written here only if NC_NSYNC
+ * and not NC_DEFER_NUMRECS, else at next sync point
+ * (i.e. nc_sync(), nc_redef(), nc_close()).
  */
 static int
-NCvnrecs(NC *ncp, size_t numrecs)
+NCvnrecsfill(NC *ncp, size_t numrecs, size_t fillrecs)
 {
 	int status = NC_NOERR;
 #ifdef LOCKNUMREC
@@ -404,7 +409,7 @@ NCvnrecs(NC *ncp, size_t numrecs)
 		{
 			/* Fill each record out to numrecs */
 			size_t cur_nrecs;
-			while((cur_nrecs = NC_get_numrecs(ncp)) < numrecs)
+			while((cur_nrecs = NC_get_numrecs(ncp)) < MIN(numrecs, fillrecs))
 			{
 				status = NCfillrecord(ncp,
 					(const NC_var *const*)ncp->vars.value,
@@ -417,9 +422,11 @@ NCvnrecs(NC *ncp, size_t numrecs)
 			}
 			if(status != NC_NOERR)
 				goto common_return;
+			if(numrecs > NC_get_numrecs(ncp))
+				NC_set_numrecs(ncp, numrecs);
 		}
 
-		if(NC_doNsync(ncp))
+		if(NC_doNsync(ncp) && !fIsSet(ncp->flags, NC_DEFER_NUMRECS))
 		{
 			status = write_numrecs(ncp);
 		}
@@ -435,6 +442,13 @@ common_return:
 }
 
 
+static int
+NCvnrecs(NC *ncp, size_t numrecs)
+{
+	return NCvnrecsfill(ncp, numrecs, numrecs);
+}
+
+
 /* 
  * Check whether 'coord' values are valid for the variable.
  */
@@ -2417,6 +2431,34 @@ putNCvdata(NC *ncp, const NC_var *varp,
 }
 
 
+/*
+ * Size of a value of 'varp' for putNCvdata() (i.e. in memory).
+ */
+static size_t
+NCvdatasz(const NC_var *varp)
+{
+	switch(varp->type){
+	case NC_CHAR:
+		return sizeof(char);
+	case NC_BYTE:
+		return sizeof(schar);
+	case NC_SHORT:
+		return sizeof(short);
+	case NC_INT:
+#if (SIZEOF_INT >= X_SIZEOF_INT)
+		return sizeof(int);
+#else
+		return sizeof(long);
+#endif
+	case NC_FLOAT:
+		return sizeof(float);
+	case NC_DOUBLE: 
+		return sizeof(double);
+	}
+	return 0;
+}
+
+
 static size_t
 NCelemsPerRec(
 	const NC_var *varp)
@@ -2601,6 +2643,101 @@ nc_put_rec(
 }
 
 
+/*
+ * Write 'nrecs' records' worth of data from record 'recnum' on,
+ * except don't write to variables for which the address of the data
+ * to be written is null.
+ * datap[ii] holds the 'nrecs' records of the ii-th record variable
+ * back to back, in the type of the variable (as nc_put_vara()).
+ * The records are written in file order (i.e. all record variables
+ * of a record, then the next record), the number of records is
+ * updated once and, if all record variables are written, the new
+ * records are not filled first.
+ */
+int
+nc_put_recs(
+	int ncid,
+	size_t recnum,
+	size_t nrecs,
+	void * const *datap)
+{
+	int status;
+	NC *ncp;
+	size_t nrvars = 0;
+	size_t nnull = 0;
+	size_t fillrecs = recnum + nrecs;
+	size_t ii;
+	size_t rr;
+
+	status = NC_check_id(ncid, &ncp); 
+	if(status != NC_NOERR)
+		return status;
+
+	if(NC_readonly(ncp))
+	{
+		return NC_EPERM;
+	}
+
+	if(NC_indef(ncp))
+	{
+		return NC_EINDEFINE;
+	}
+
+	if(nrecs == 0)
+		return NC_NOERR;
+
+	if(recnum + nrecs > X_INT_MAX)
+		return NC_EINVALCOORDS;
+
+	for(ii = 0; ii < ncp->vars.nelems; ii++)
+	{
+		if(!IS_RECVAR(ncp->vars.value[ii]))
+			continue;
+		if(datap[nrvars++] == NULL)
+			nnull++;
+	}
+	if(nrvars == 0)
+		return NC_ENORECVARS;
+	if(nnull == 0)
+		fillrecs = recnum; /* all written, no fill */
+
+	status = NCvnrecsfill(ncp, recnum + nrecs, fillrecs);
+	if(status != NC_NOERR)
+		return status;
+
+	{
+	ALLOC_ONSTACK(recp, void *, nrvars);
+	size_t jj = 0;
+	for(ii = 0; ii < ncp->vars.nelems; ii++)
+	{
+		const NC_var *const varp = ncp->vars.value[ii];
+		if(!IS_RECVAR(varp))
+			continue;
+		recp[jj] = datap[jj];
+		jj++;
+	}
+	for(rr = 0; rr < nrecs && status == NC_NOERR; rr++)
+	{
+		status = NCrecput(ncp, recnum + rr, recp);
+		/* next record of each variable */
+		jj = 0;
+		for(ii = 0; ii < ncp->vars.nelems; ii++)
+		{
+			const NC_var *const varp = ncp->vars.value[ii];
+			if(!IS_RECVAR(varp))
+				continue;
+			if(recp[jj] != NULL)
+				recp[jj] = (char *)recp[jj]
+					+ NCelemsPerRec(varp) * NCvdatasz(varp);
+			jj++;
+		}
+	}
+	FREE_ONSTACK(recp);
+	}
+	return status;
+}
+
+
 /*
  * Read one record's worth of data, except don't read from variables for which
  * the address of the data to be read is null.  Return -1 on error;
@@ -0,0 +1,165 @@
+/*
+ *	Copyright 1996, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+/* $Id$ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "netcdf.h"
+
+/*
+ * This program times the definition of files with many variables
+ * and attributes (i.e. one data and one time variable per channel,
+ * five attributes each, and a global attribute per channel, as a
+ * multichannel acquisition file), then reopens them and looks every
+ * name up.
+ * Times growing linearly with the number of channels show the
+ * name lookups are hashed (i.e. quadratic if scanned, see
+ * NC_HASH_MIN in hashmap.c).
+ * Link like this:
+ * cc t_nchash.c -L. -lnetcdf -o t_nchash
+ * Exit status is 0 if all names are found back.
+ */
+
+#define FNAME "t_nchash.nc"
+#define NATTRS 5
+
+static const char *attnames[NATTRS] = {
+	"units", "long_name", "minimum", "maximum", "channel"
+};
+
+#define CHECK(stat) \
+	if((stat) != NC_NOERR) \
+	{ \
+		(void) fprintf(stderr, "line %d: %s\n", __LINE__, nc_strerror(stat)); \
+		exit(1); \
+	}
+
+static double
+seconds(clock_t t0)
+{
+	return (double)(clock() - t0) / CLOCKS_PER_SEC;
+}
+
+/* define nchan data and time variables, with their attributes */
+static void
+define(int nchan)
+{
+	int ncid;
+	int dimid;
+	int varid;
+	int chan;
+	int ii;
+	char name[NC_MAX_NAME];
+
+	CHECK(nc_create(FNAME, NC_CLOBBER, &ncid));
+	CHECK(nc_def_dim(ncid, "sample", 16, &dimid));
+	CHECK(nc_put_att_text(ncid, NC_GLOBAL, "history", 8, "t_nchash"));
+	for(chan = 0; chan < nchan; chan++)
+	{
+		(void) sprintf(name, "chan-%d", chan);
+		CHECK(nc_def_var(ncid, name, NC_SHORT, 1, &dimid, &varid));
+		(void) sprintf(name, "chan-%d__time", chan);
+		CHECK(nc_def_var(ncid, name, NC_DOUBLE, 1, &dimid, &varid));
+		for(ii = 0; ii < NATTRS; ii++)
+		{
+			CHECK(nc_inq_varid(ncid, name, &varid));
+			CHECK(nc_put_att_int(ncid, varid - 1, attnames[ii], NC_INT, 1, &chan));
+			CHECK(nc_put_att_int(ncid, varid, attnames[ii], NC_INT, 1, &chan));
+		}
+		(void) sprintf(name, "chan-%d_gain", chan);
+		CHECK(nc_put_att_int(ncid, NC_GLOBAL, name, NC_INT, 1, &chan));
+	}
+	CHECK(nc_close(ncid));
+}
+
+/* reopen and look every name up, return number of errors */
+static int
+lookup(int nchan)
+{
+	int ncid;
+	int varid;
+	int chan;
+	int ii;
+	int value;
+	int errs = 0;
+	char name[NC_MAX_NAME];
+
+	CHECK(nc_open(FNAME, NC_NOWRITE, &ncid));
+	for(chan = nchan - 1; chan >= 0; chan--)
+	{
+		(void) sprintf(name, "chan-%d", chan);
+		CHECK(nc_inq_varid(ncid, name, &varid));
+		errs += varid != 2 * chan;
+		for(ii = 0; ii < NATTRS; ii++)
+		{
+			CHECK(nc_get_att_int(ncid, varid, attnames[ii], &value));
+			errs += value != chan;
+		}
+		(void) sprintf(name, "chan-%d_gain", chan);
+		CHECK(nc_get_att_int(ncid, NC_GLOBAL, name, &value));
+		errs += value != chan;
+	}
+	errs += nc_inq_varid(ncid, "chan-none", &varid) != NC_ENOTVAR;
+	CHECK(nc_close(ncid));
+	return errs;
+}
+
+/* rename and delete (i.e. index dropped), return number of errors */
+static int
+change(void)
+{
+	int ncid;
+	int varid;
+	int errs = 0;
+
+	CHECK(nc_open(FNAME, NC_WRITE, &ncid));
+	CHECK(nc_redef(ncid));
+	CHECK(nc_rename_var(ncid, 0, "renamed"));
+	errs += nc_inq_varid(ncid, "chan-0", &varid) != NC_ENOTVAR;
+	CHECK(nc_inq_varid(ncid, "renamed", &varid));
+	errs += varid != 0;
+	CHECK(nc_del_att(ncid, NC_GLOBAL, "chan-0_gain"));
+	errs += nc_inq_attid(ncid, NC_GLOBAL, "chan-0_gain", &varid) != NC_ENOTATT;
+	CHECK(nc_inq_attid(ncid, NC_GLOBAL, "history", &varid));
+	errs += varid != 0;
+	CHECK(nc_inq_attid(ncid, NC_GLOBAL, "chan-1_gain", &varid));
+	errs += varid != 1;
+	CHECK(nc_rename_att(ncid, NC_GLOBAL, "chan-1_gain", "gain"));
+	CHECK(nc_inq_attid(ncid, NC_GLOBAL, "gain", &varid));
+	errs += varid != 1;
+	CHECK(nc_close(ncid));
+	return errs;
+}
+
+int
+main(int ac, char *av[])
+{
+	int nchan;
+	int errs = 0;
+
+	(void) ac; (void) av;
+
+	(void) printf("%8s %10s %10s %10s\n", "channels", "define(s)", "lookup(s)", "attributes");
+	/* up to NC_MAX_VARS variables */
+	for(nchan = 256; 2 * nchan <= NC_MAX_VARS; nchan *= 2)
+	{
+		clock_t t0 = clock();
+		double tdef;
+		define(nchan);
+		tdef = seconds(t0);
+		t0 = clock();
+		errs += lookup(nchan);
+		(void) printf("%8d %10.3f %10.3f %10d\n", nchan, tdef, seconds(t0),
+			nchan * (2 * NATTRS + 1));
+	}
+	errs += change();
+	(void) remove(FNAME);
+
+	if(errs != 0)
+		(void) fprintf(stderr, "%d names not found back\n", errs);
+	return errs != 0;
+}
@@ -0,0 +1,257 @@
+/*
+ *	Copyright 1996, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+/* $Id$ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "netcdf.h"
+
+/*
+ * This program checks the memory mapped I/O (i.e. NC_MMAP) against
+ * the buffered one: each case is run on a file with NC_MMAP and on a
+ * reference file without, then both files must be the same bytes
+ * (i.e. same data, and mapped file truncated back to its logical end
+ * at close) and read back the same records through NC_MMAP.
+ * Cases: create and append records, append with NC_SHARE while a
+ * reader follows the records at each nc_sync(), and redef growing
+ * the header (i.e. data moved) before appending again.
+ * Link like this:
+ * cc t_ncmmap.c -L. -lnetcdf -o t_ncmmap
+ * Exit status is 0 if all cases agree.
+ */
+
+#define FNAME "t_ncmmap.nc"
+#define RNAME "t_ncmmap_ref.nc"
+#define NSAMPLE 4096	/* samples per record */
+#define NRECS 300	/* a few MiB, more than one mapping doubling */
+#define NSYNC 32	/* records between nc_sync() with NC_SHARE */
+#define ATTLEN 3000	/* global attribute growing the header */
+
+static short samples[NSAMPLE];
+static short back[NSAMPLE];
+static char text[ATTLEN];
+
+#define CHECK(stat) \
+	if((stat) != NC_NOERR) \
+	{ \
+		(void) fprintf(stderr, "line %d: %s\n", __LINE__, nc_strerror(stat)); \
+		exit(1); \
+	}
+
+/* values of a record */
+static void
+record(size_t rec)
+{
+	size_t ii;
+	for(ii = 0; ii < NSAMPLE; ii++)
+		samples[ii] = (short)(rec * 7 + ii);
+}
+
+/* a channel and its time, one record per NSAMPLE samples */
+static int
+define(const char *path, int cmode)
+{
+	int ncid;
+	int dimids[2];
+	int varid;
+
+	CHECK(nc_create(path, NC_CLOBBER | cmode, &ncid));
+	CHECK(nc_def_dim(ncid, "record", NC_UNLIMITED, &dimids[0]));
+	CHECK(nc_def_dim(ncid, "sample", NSAMPLE, &dimids[1]));
+	CHECK(nc_def_var(ncid, "chan-0", NC_SHORT, 2, dimids, &varid));
+	CHECK(nc_def_var(ncid, "time", NC_DOUBLE, 1, dimids, &varid));
+	CHECK(nc_enddef(ncid));
+	return ncid;
+}
+
+/* write records [from, to) */
+static void
+append(int ncid, size_t from, size_t to)
+{
+	size_t start[2];
+	size_t count[2];
+	double tt;
+
+	for(start[0] = from; start[0] < to; start[0]++)
+	{
+		record(start[0]);
+		start[1] = 0;
+		count[0] = 1; count[1] = NSAMPLE;
+		CHECK(nc_put_vara_short(ncid, 0, start, count, samples));
+		tt = (double)start[0] / 100.;
+		CHECK(nc_put_var1_double(ncid, 1, start, &tt));
+	}
+}
+
+/* check nrecs records of an open file, return number of errors */
+static int
+check_open(int ncid, const char *path, size_t nrecs)
+{
+	size_t len;
+	size_t start[2];
+	size_t count[2];
+	double tt;
+	int errs = 0;
+
+	CHECK(nc_inq_dimlen(ncid, 0, &len));
+	if(len != nrecs)
+	{
+		(void) fprintf(stderr, "%s: %lu records, %lu expected\n",
+			path, (unsigned long)len, (unsigned long)nrecs);
+		return 1;
+	}
+	for(start[0] = 0; start[0] < nrecs; start[0]++)
+	{
+		record(start[0]);
+		start[1] = 0;
+		count[0] = 1; count[1] = NSAMPLE;
+		CHECK(nc_get_vara_short(ncid, 0, start, count, back));
+		CHECK(nc_get_var1_double(ncid, 1, start, &tt));
+		errs += memcmp(back, samples, sizeof(back)) != 0;
+		errs += tt != (double)start[0] / 100.;
+	}
+	if(errs != 0)
+		(void) fprintf(stderr, "%s: %d values differ\n", path, errs);
+	return errs;
+}
+
+/* check records read back through NC_MMAP, return number of errors */
+static int
+check(const char *path, size_t nrecs)
+{
+	int ncid;
+	int errs;
+
+	CHECK(nc_open(path, NC_NOWRITE | NC_MMAP, &ncid));
+	errs = check_open(ncid, path, nrecs);
+	CHECK(nc_close(ncid));
+	return errs;
+}
+
+/* same size and bytes as the reference file, return number of errors */
+static int
+compare(const char *what)
+{
+	struct stat st;
+	struct stat rst;
+	FILE *fp;
+	FILE *rfp;
+	int cc;
+	int rc;
+	int errs = 0;
+
+	if(stat(FNAME, &st) != 0 || stat(RNAME, &rst) != 0)
+	{
+		perror("stat");
+		exit(1);
+	}
+	if(st.st_size != rst.st_size)
+	{
+		(void) fprintf(stderr, "%s: size %ld, %ld expected (not truncated at close)\n",
+			what, (long)st.st_size, (long)rst.st_size);
+		return 1;
+	}
+	fp = fopen(FNAME, "rb");
+	rfp = fopen(RNAME, "rb");
+	if(fp == NULL || rfp == NULL)
+	{
+		perror("fopen");
+		exit(1);
+	}
+	do {
+		cc = getc(fp);
+		rc = getc(rfp);
+	} while(cc == rc && cc != EOF);
+	if(cc != rc)
+	{
+		(void) fprintf(stderr, "%s: bytes differ at %ld\n", what, ftell(fp) - 1);
+		errs++;
+	}
+	(void) fclose(fp);
+	(void) fclose(rfp);
+	return errs;
+}
+
+/* create and append all records */
+static void
+create(const char *path, int cmode)
+{
+	const int ncid = define(path, cmode);
+	append(ncid, 0, NRECS);
+	CHECK(nc_close(ncid));
+}
+
+/* append with NC_SHARE, a reader checks the records at each nc_sync() */
+static int
+share(const char *path, int cmode)
+{
+	const int ncid = define(path, NC_SHARE | cmode);
+	int rdid;
+	size_t rec;
+	int errs = 0;
+
+	CHECK(nc_open(path, NC_SHARE | cmode, &rdid));
+	for(rec = 0; rec < NRECS; rec += NSYNC)
+	{
+		const size_t to = (rec + NSYNC < NRECS) ? rec + NSYNC : NRECS;
+		append(ncid, rec, to);
+		CHECK(nc_sync(ncid));
+		CHECK(nc_sync(rdid));
+		errs += check_open(rdid, path, to);
+	}
+	CHECK(nc_close(rdid));
+	CHECK(nc_close(ncid));
+	return errs;
+}
+
+/* grow the header (i.e. move data) then append a record */
+static void
+redef(const char *path, int cmode)
+{
+	int ncid;
+
+	CHECK(nc_open(path, NC_WRITE | cmode, &ncid));
+	CHECK(nc_redef(ncid));
+	CHECK(nc_put_att_text(ncid, NC_GLOBAL, "history", ATTLEN, text));
+	CHECK(nc_enddef(ncid));
+	append(ncid, NRECS, NRECS + 1);
+	CHECK(nc_close(ncid));
+}
+
+int
+main(int ac, char *av[])
+{
+	int errs = 0;
+
+	(void) ac; (void) av;
+	(void) memset(text, 'a', sizeof(text));
+
+	create(FNAME, NC_MMAP);
+	create(RNAME, 0);
+	errs += compare("create");
+	errs += check(FNAME, NRECS);
+
+	errs += share(FNAME, NC_MMAP);
+	errs += share(RNAME, 0);
+	errs += compare("NC_SHARE");
+	errs += check(FNAME, NRECS);
+
+	redef(FNAME, NC_MMAP);
+	redef(RNAME, 0);
+	errs += compare("redef");
+	errs += check(FNAME, NRECS + 1);
+
+	(void) remove(FNAME);
+	(void) remove(RNAME);
+
+	if(errs != 0)
+		(void) fprintf(stderr, "%d errors\n", errs);
+	else
+		(void) printf("NC_MMAP: create, NC_SHARE, redef and truncation agree\n");
+	return errs != 0;
+}
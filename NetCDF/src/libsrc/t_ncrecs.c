@@ -0,0 +1,190 @@
+/*
+ *	Copyright 1996, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+/* $Id$ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "netcdf.h"
+
+/*
+ * This program times record appends as an acquisition writer does
+ * (i.e. a block of short samples of each channel and its time stamp
+ * per record, a few records per block) with NC_SHARE:
+ * record by record, with NC_DEFER_NUMRECS (i.e. numrecs written at
+ * nc_sync() only), and block by block with nc_put_recs().
+ * With NC_SHARE, the header numrecs is rewritten at each new record,
+ * so records are small and not filled (i.e. NC_NOFILL, as the
+ * acquisition writer), for that rewrite not to be hidden behind data
+ * and fill writes.
+ * Then it checks that all files have the same records.
+ * Link like this:
+ * cc t_ncrecs.c -L. -lnetcdf -o t_ncrecs
+ * Exit status is 0 if all files read back the same.
+ */
+
+#define FNAME "t_ncrecs.nc"
+#define NCHAN 4
+#define NSAMPLE 16	/* samples per record */
+#define NBLOCK 8	/* records per block */
+#define NRECS 65536
+
+static short samples[NCHAN][NBLOCK * NSAMPLE];
+static double times[NBLOCK];
+static short back[NBLOCK * NSAMPLE];
+
+#define CHECK(stat) \
+	if((stat) != NC_NOERR) \
+	{ \
+		(void) fprintf(stderr, "line %d: %s\n", __LINE__, nc_strerror(stat)); \
+		exit(1); \
+	}
+
+static double
+seconds(clock_t t0)
+{
+	return (double)(clock() - t0) / CLOCKS_PER_SEC;
+}
+
+/* NCHAN channels and a time, one record per NSAMPLE samples */
+static int
+define(const char *path, int cmode)
+{
+	int ncid;
+	int dimids[2];
+	int varid;
+	int chan;
+	int oldfill;
+	char name[NC_MAX_NAME];
+
+	CHECK(nc_create(path, NC_CLOBBER | cmode, &ncid));
+	CHECK(nc_set_fill(ncid, NC_NOFILL, &oldfill));
+	CHECK(nc_def_dim(ncid, "record", NC_UNLIMITED, &dimids[0]));
+	CHECK(nc_def_dim(ncid, "sample", NSAMPLE, &dimids[1]));
+	for(chan = 0; chan < NCHAN; chan++)
+	{
+		(void) sprintf(name, "chan-%d", chan);
+		CHECK(nc_def_var(ncid, name, NC_SHORT, 2, dimids, &varid));
+	}
+	CHECK(nc_def_var(ncid, "time", NC_DOUBLE, 1, dimids, &varid));
+	CHECK(nc_enddef(ncid));
+	return ncid;
+}
+
+/* next block of values */
+static void
+block(size_t rec)
+{
+	int chan;
+	size_t ii;
+	for(chan = 0; chan < NCHAN; chan++)
+		for(ii = 0; ii < NBLOCK * NSAMPLE; ii++)
+			samples[chan][ii] = (short)(rec * NSAMPLE + ii + chan);
+	for(ii = 0; ii < NBLOCK; ii++)
+		times[ii] = (double)(rec + ii) / 100.;
+}
+
+/* append NRECS records, record by record or block by block */
+static double
+append(const char *path, int cmode, int byblock)
+{
+	clock_t t0 = clock();
+	const int ncid = define(path, cmode);
+	void *datap[NCHAN + 1];
+	size_t rec;
+	size_t rr;
+	int chan;
+
+	for(rec = 0; rec < NRECS; rec += NBLOCK)
+	{
+		block(rec);
+		if(byblock)
+		{
+			for(chan = 0; chan < NCHAN; chan++)
+				datap[chan] = samples[chan];
+			datap[NCHAN] = times;
+			CHECK(nc_put_recs(ncid, rec, NBLOCK, datap));
+			continue;
+		}
+		for(rr = 0; rr < NBLOCK; rr++)
+		{
+			size_t start[2];
+			size_t count[2];
+			start[0] = rec + rr; start[1] = 0;
+			count[0] = 1; count[1] = NSAMPLE;
+			for(chan = 0; chan < NCHAN; chan++)
+				CHECK(nc_put_vara_short(ncid, chan, start, count,
+					samples[chan] + rr * NSAMPLE));
+			CHECK(nc_put_vara_double(ncid, NCHAN, start, count, times + rr));
+		}
+	}
+	CHECK(nc_close(ncid));
+	return seconds(t0);
+}
+
+/* check records read back, return number of errors */
+static int
+check(const char *path)
+{
+	int ncid;
+	size_t nrecs;
+	size_t rec;
+	int chan;
+	int errs = 0;
+
+	CHECK(nc_open(path, NC_NOWRITE, &ncid));
+	CHECK(nc_inq_dimlen(ncid, 0, &nrecs));
+	if(nrecs != NRECS)
+	{
+		(void) fprintf(stderr, "%s: %lu records\n", path, (unsigned long)nrecs);
+		errs++;
+	}
+	for(rec = 0; rec < NRECS && errs == 0; rec += NBLOCK)
+	{
+		size_t start[2];
+		size_t count[2];
+		double tt[NBLOCK];
+		start[0] = rec; start[1] = 0;
+		count[0] = NBLOCK; count[1] = NSAMPLE;
+		block(rec);
+		for(chan = 0; chan < NCHAN; chan++)
+		{
+			CHECK(nc_get_vara_short(ncid, chan, start, count, back));
+			errs += memcmp(back, samples[chan], sizeof(back)) != 0;
+		}
+		CHECK(nc_get_vara_double(ncid, NCHAN, start, count, tt));
+		errs += memcmp(tt, times, sizeof(tt)) != 0;
+	}
+	CHECK(nc_close(ncid));
+	return errs;
+}
+
+int
+main(int ac, char *av[])
+{
+	int errs = 0;
+
+	(void) ac; (void) av;
+
+	(void) printf("%d records of %d channels\n", NRECS, NCHAN);
+	(void) printf("%-32s %8.3f s\n", "NC_SHARE, by record",
+		append(FNAME, NC_SHARE, 0));
+	errs += check(FNAME);
+	(void) printf("%-32s %8.3f s\n", "NC_SHARE|NC_DEFER_NUMRECS",
+		append(FNAME, NC_SHARE | NC_DEFER_NUMRECS, 0));
+	errs += check(FNAME);
+	(void) printf("%-32s %8.3f s\n", "NC_SHARE, nc_put_recs",
+		append(FNAME, NC_SHARE, 1));
+	errs += check(FNAME);
+	(void) printf("%-32s %8.3f s\n", "nc_put_recs",
+		append(FNAME, 0, 1));
+	errs += check(FNAME);
+	(void) remove(FNAME);
+
+	if(errs != 0)
+		(void) fprintf(stderr, "%d blocks differ\n", errs);
+	return errs != 0;
+}
@@ -0,0 +1,227 @@
+/*
+ *	Copyright 1996, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+/* $Id$ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ncx.h"
+
+/*
+ * This program checks the SIMD conversion kernels of ncx
+ * of each level against the scalar ones (i.e. same external bytes,
+ * same values, same NC_ERANGE status, also for out of range and NaN
+ * floats put into shorts) and prints the speed in MB/s (i.e. of
+ * memory values) of each type pair for each kernel set.
+ * Link like this:
+ * cc t_ncxsimd.c ncx.o -o t_ncxsimd
+ * Exit status is 0 if all kernel sets agree.
+ */
+
+#define NELEMS 1048573 /* odd, so that kernels have a tail */
+#define SECONDS 0.25
+
+static short shorts[NELEMS];
+static int ints[NELEMS];
+static float floats[NELEMS];
+static double doubles[NELEMS];
+static float back[NELEMS];
+static char xb[NELEMS * 8];
+static char ref[NELEMS * 8];
+
+enum pair {
+	PUT_SHORT_SHORT, GET_SHORT_SHORT,
+	PUT_INT_INT, GET_INT_INT,
+	PUT_FLOAT_FLOAT, GET_FLOAT_FLOAT,
+	PUT_DOUBLE_DOUBLE, GET_DOUBLE_DOUBLE,
+	PUT_SHORT_FLOAT, GET_SHORT_FLOAT,
+	NPAIRS
+};
+
+static const char *names[NPAIRS] = {
+	"putn_short_short", "getn_short_short",
+	"putn_int_int", "getn_int_int",
+	"putn_float_float", "getn_float_float",
+	"putn_double_double", "getn_double_double",
+	"putn_short_float", "getn_short_float"
+};
+
+/* memory size of the values of a pair */
+static size_t
+memsize(int pair)
+{
+	switch(pair) {
+	case PUT_SHORT_SHORT: case GET_SHORT_SHORT: return sizeof(short);
+	case PUT_INT_INT: case GET_INT_INT: return sizeof(int);
+	case PUT_DOUBLE_DOUBLE: case GET_DOUBLE_DOUBLE: return sizeof(double);
+	}
+	return sizeof(float);
+}
+
+/* one conversion of the whole array */
+static int
+run(int pair)
+{
+	void *xp = xb;
+	const void *cxp = xb;
+	switch(pair) {
+	case PUT_SHORT_SHORT: return ncx_putn_short_short(&xp, NELEMS, shorts);
+	case GET_SHORT_SHORT: return ncx_getn_short_short(&cxp, NELEMS, shorts);
+	case PUT_INT_INT: return ncx_putn_int_int(&xp, NELEMS, ints);
+	case GET_INT_INT: return ncx_getn_int_int(&cxp, NELEMS, ints);
+	case PUT_FLOAT_FLOAT: return ncx_putn_float_float(&xp, NELEMS, floats);
+	case GET_FLOAT_FLOAT: return ncx_getn_float_float(&cxp, NELEMS, floats);
+	case PUT_DOUBLE_DOUBLE: return ncx_putn_double_double(&xp, NELEMS, doubles);
+	case GET_DOUBLE_DOUBLE: return ncx_getn_double_double(&cxp, NELEMS, doubles);
+	case PUT_SHORT_FLOAT: return ncx_putn_short_float(&xp, NELEMS, floats);
+	case GET_SHORT_FLOAT: return ncx_getn_short_float(&cxp, NELEMS, back);
+	}
+	return -1;
+}
+
+/* values of all types, floats rounded toward zero into shorts */
+static void
+fill(void)
+{
+	size_t ii;
+	for(ii = 0; ii < NELEMS; ii++)
+	{
+		shorts[ii] = (short)(ii * 7919 - 32768);
+		ints[ii] = (int)(ii * 2654435761u);
+		floats[ii] = (float)shorts[ii] + 0.25f * (float)(ii % 4);
+		doubles[ii] = (double)ints[ii] / 3.0;
+	}
+}
+
+/* out of range and NaN floats, in the vector part and in the tail */
+static void
+outliers(void)
+{
+	static const size_t at[] = {
+		5, NELEMS / 2, NELEMS / 2 + 9, NELEMS / 2 + 18,
+		NELEMS - 1, NELEMS - 2, NELEMS - 3, NELEMS - 4
+	};
+	volatile float zero = 0.f;
+	const float nan = zero / zero;
+	const float values[4] = { 40000.f, -40000.f, 3.e9f, 0.f };
+	size_t ii;
+	for(ii = 0; ii < sizeof(at) / sizeof(at[0]); ii++)
+		floats[at[ii]] = (ii % 4 == 3) ? nan : values[ii % 4];
+}
+
+/*
+ * check results of kernel set level against the scalar ones
+ * (with out of range and NaN floats if oor)
+ */
+static int
+check(int pair, int level, int oor)
+{
+	const size_t xsz = (pair == PUT_DOUBLE_DOUBLE || pair == GET_DOUBLE_DOUBLE) ? 8
+		: (pair == PUT_SHORT_SHORT || pair == GET_SHORT_SHORT
+		|| pair == PUT_SHORT_FLOAT || pair == GET_SHORT_FLOAT) ? 2 : 4;
+	int status;
+	int lstatus;
+
+	(void) ncx_set_simd(0);
+	fill();
+	if(oor)
+		outliers();
+	status = run(pair);
+	(void) memcpy(ref, xb, NELEMS * xsz);
+	if(pair == GET_SHORT_FLOAT)
+		(void) memcpy(ref, back, NELEMS * sizeof(float));
+
+	(void) ncx_set_simd(level);
+	fill();
+	if(oor)
+		outliers();
+	lstatus = run(pair);
+	if(lstatus != status)
+	{
+		(void) fprintf(stderr, "%s: level %d status %d, scalar %d\n",
+			names[pair], level, lstatus, status);
+		return 1;
+	}
+	if(pair == GET_SHORT_FLOAT)
+		return memcmp(ref, back, NELEMS * sizeof(float)) != 0;
+	return memcmp(ref, xb, NELEMS * xsz) != 0;
+}
+
+/* MB/s of memory values */
+static double
+speed(int pair)
+{
+	clock_t t0 = clock();
+	clock_t t1;
+	long nn = 0;
+	do {
+		(void) run(pair);
+		nn++;
+		t1 = clock();
+	} while(t1 - t0 < (clock_t)(SECONDS * CLOCKS_PER_SEC));
+	return (double)nn * NELEMS * memsize(pair)
+		/ ((double)(t1 - t0) / CLOCKS_PER_SEC) / 1.0e6;
+}
+
+int
+main(int ac, char *av[])
+{
+	const int best = ncx_set_simd(-1);
+	int pair;
+	int level;
+	int errs = 0;
+
+	(void) ac; (void) av;
+
+	/* every kernel set, not only the best one */
+	for(level = 1; level <= best; level++)
+	{
+		for(pair = 0; pair < NPAIRS; pair++)
+		{
+			if(check(pair, level, 0))
+			{
+				(void) fprintf(stderr, "%s: level %d differs from scalar\n",
+					names[pair], level);
+				errs++;
+			}
+		}
+		/* out of range and NaN values: same bytes and status in the vector part and the tail */
+		if(check(PUT_SHORT_FLOAT, level, 1))
+		{
+			(void) fprintf(stderr, "putn_short_float: level %d out of range differs from scalar\n",
+				level);
+			errs++;
+		}
+		(void) ncx_set_simd(level);
+		fill();
+		outliers();
+		if(run(PUT_SHORT_FLOAT) != NC_ERANGE)
+		{
+			(void) fprintf(stderr, "putn_short_float: level %d no NC_ERANGE\n",
+				level);
+			errs++;
+		}
+	}
+
+	(void) printf("%-20s", "MB/s");
+	for(level = 0; level <= best; level++)
+		(void) printf(" %10s", level == 0 ? "scalar" : level == 1 ? "SSSE3" : "AVX2");
+	(void) printf("\n");
+	fill();
+	for(pair = 0; pair < NPAIRS; pair++)
+	{
+		(void) printf("%-20s", names[pair]);
+		for(level = 0; level <= best; level++)
+		{
+			(void) ncx_set_simd(level);
+			(void) printf(" %10.0f", speed(pair));
+		}
+		(void) printf("\n");
+	}
+	(void) ncx_set_simd(-1);
+
+	return errs != 0;
+}
@@ -141,6 +141,8 @@ free_NC_vararrayV0(NC_vararray *ncap)
 {
 	assert(ncap != NULL);
 
+	free_NC_hashmap(&ncap->hash);
+
 	if(ncap->nelems == 0)
 		return;
 
@@ -286,7 +288,17 @@ elem_NC_vararray(const NC_vararray *ncap, size_t elem)
 
 
 /*
- * Step thru NC_VARIABLE array, seeking match on name.
+ * Name of a variable (see NC_hashfind()).
+ */
+static NC_string *
+NC_varname(const void *elemp)
+{
+	return ((const NC_var *)elemp)->name;
+}
+
+
+/*
+ * Seek NC_VARIABLE array on name, through its hash index.
  * Return varid or -1 on not found.
  * *varpp is set to the appropriate NC_var.
  * Formerly (sort of)
@@ -295,30 +307,17 @@ NC_hvarid
 int
 NC_findvar(const NC_vararray *ncap, const char *name, NC_var **varpp)
 {
-	NC_var **loc;
-	size_t slen;
 	int varid;
 
 	assert(ncap != NULL);
 
-	if(ncap->nelems == 0)
-		return -1;
-
-	loc = (NC_var **) ncap->value;
-
-	slen = strlen(name);
-
-	for(varid = 0; (size_t) varid < ncap->nelems; varid++, loc++)
-	{
-		if(strlen((*loc)->name->cp) == slen &&
-			strncmp((*loc)->name->cp, name, slen) == 0)
-		{
-			if(varpp != NULL)
-				*varpp = *loc;
-			return(varid); /* Normal return */
-		}
-	}
-	return(-1); /* not found */
+	varid = NC_hashfind(&ncap->hash, (void *const *)ncap->value,
+		ncap->nelems, NC_varname, name);
+	if(varid == -1)
+		return(-1); /* not found */
+	if(varpp != NULL)
+		*varpp = ncap->value[varid];
+	return(varid); /* Normal return */
 }
 
 /* 
@@ -792,6 +791,7 @@ nc_rename_var(int ncid, int varid, const char *newname)
 			return(-1);
 		varp->name = newStr;
 		free_NC_string(old);
+		free_NC_hashmap(&ncp->vars.hash);
 		return NC_NOERR;
 	}
 
@@ -799,6 +799,7 @@ nc_rename_var(int ncid, int varid, const char *newname)
 	status = set_NC_string(varp->name, newname);
 	if(status != NC_NOERR)
 		return status;
+	free_NC_hashmap(&ncp->vars.hash);
 
 	set_NC_hdirty(ncp);
 
@@ -1,15 +1,241 @@
 #ifndef RT_PREEMPT
 #define RT_PREEMPT
 #include <time.h>
-#ifdef REAL_TIME
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <sched.h>
+#include <pthread.h>
+#ifdef REAL_TIME
 #include <sys/mman.h>
 #endif
 
+//! number of sub-buckets of each power of 2 in \c RT_jitter histogram (i.e. relative resolution of 1/16)
+#define RT_JITTER_SUB 16
+//! number of buckets of \c RT_jitter histogram (i.e. up to 2^40 ns)
+#define RT_JITTER_BUCKETS (RT_JITTER_SUB*38)
+
+//! wakeup lateness and overrun statistics of real time ticks
+/**
+ * lateness of each wakeup (i.e. time after the requested tick, in nanosecond) is counted in a log-linear histogram of fixed size
+ * (exact below \c RT_JITTER_SUB ns, then 16 buckets for each power of 2, i.e. about 6% resolution), so that percentiles are available after any run length;
+ * overruns are ticks where the work ended after the next tick.
+ * \note counters are written by the real time thread only and may be read by others at any time (i.e. no lock).
+ * \note measured only with \c REAL_TIME (i.e. absolute ticks); otherwise \c ticks stays 0 and statistics are neither printed nor saved.
+ * \code
+ *   RT_jitter jitter;
+ *   RT_preempt RT;RT.jitter=&jitter;
+ *   ...
+ *   jitter.print(std::cout);
+ * \endcode
+ **/
+class RT_jitter{
+ public:
+  volatile unsigned long histogram[RT_JITTER_BUCKETS];///< number of wakeups in each lateness bucket
+  volatile unsigned long ticks;   ///< number of wakeups
+  volatile unsigned long overruns;///< number of ticks where work exceeded interval
+  volatile long min;              ///< minimum lateness (in ns)
+  volatile long max;              ///< maximum lateness (in ns)
+  volatile double sum;            ///< sum of lateness (in ns)
+  int interval;                   ///< tick interval (in ns)
+
+  //! constructor
+  RT_jitter() {reset();interval=0;}
+
+  //! clear statistics
+  void reset()
+  {
+    for(int i=0;i<RT_JITTER_BUCKETS;++i) histogram[i]=0;
+    ticks=overruns=0;
+    min=max=0;
+    sum=0.0;
+  }
+
+  //! bucket of a lateness (in ns)
+  static int bucket(long ns)
+  {
+    if(ns<RT_JITTER_SUB) return (ns<0)?0:(int)ns;
+    int e=0;
+    for(unsigned long v=(unsigned long)ns;v>=2*RT_JITTER_SUB;v>>=1) ++e;
+    const int b=(e+1)*RT_JITTER_SUB+(int)((ns>>e)-RT_JITTER_SUB);
+    return (b<RT_JITTER_BUCKETS)?b:RT_JITTER_BUCKETS-1;
+  }
+  //! upper bound of a bucket (in ns)
+  static long bucket_max(int b)
+  {
+    if(b<RT_JITTER_SUB) return b;
+    const int e=b/RT_JITTER_SUB-1;
+    return (((long)(b%RT_JITTER_SUB+RT_JITTER_SUB+1))<<e)-1;
+  }
+
+  //! add a wakeup lateness (in ns)
+  void add(long ns)
+  {
+    if(ns<0) ns=0;
+    if(ticks==0||ns<min) min=ns;
+    if(ns>max) max=ns;
+    sum+=ns;
+    ++histogram[bucket(ns)];
+    ++ticks;
+  }
+  //! add an overrun
+  void overrun() {++overruns;}
+
+  //! mean lateness (in ns)
+  double mean() const {return (ticks==0)?0.0:sum/ticks;}
+  //! lateness percentile (in ns, i.e. upper bound of bucket, e.g. \c percentile(99.9) )
+  long percentile(double p) const
+  {
+    if(ticks==0) return 0;
+    const double rank=p*0.01*ticks;
+    unsigned long count=0;
+    for(int b=0;b<RT_JITTER_BUCKETS;++b)
+    {
+      count+=histogram[b];
+      if(count>=rank&&count>0) {long v=bucket_max(b);return (v>max)?max:v;}
+    }
+    return max;
+  }
+
+  //! print statistics
+  void print(std::ostream &stream) const
+  {
+    stream<<"real time: "<<ticks<<" ticks of "<<interval<<" ns, "<<overruns<<" overruns, wakeup lateness (ns)"
+      <<" min: "<<min<<", mean: "<<mean()<<", p99: "<<percentile(99.0)<<", p99.9: "<<percentile(99.9)<<", max: "<<max<<std::endl;
+  }
+};//RT_jitter class
+
+#define MY_PRIORITY (49) /* we use 49 as the PRREMPT_RT use 50
+                            as the priority of kernel tasklets
+                            and interrupt handler by default */
+
+//! CPU list of a sysfs file contains a core (e.g. "2-3,6" in \c /sys/devices/system/cpu/isolated )
+/**
+ * \return 1 if \c cpu is in the list, 0 if not, -1 if file can not be read (e.g. not Linux)
+ **/
+inline int RT_cpu_in_list(const char *file_name,int cpu)
+{
+  std::ifstream file(file_name);
+  if(!file) return -1;
+  std::string list;
+  std::getline(file,list);
+  const char *p=list.c_str();
+  while(*p)
+  {
+    char *end;
+    const long first=strtol(p,&end,10);
+    if(end==p) break;
+    long last=first;
+    if(*end=='-') {p=end+1;last=strtol(p,&end,10);}
+    if(cpu>=first&&cpu<=last) return 1;
+    p=(*end==',')?end+1:end;
+  }
+  return 0;
+}
+
+//! placement of a thread (i.e. core and scheduling)
+/**
+ * core affinity and scheduling policy of a thread role (e.g. acquisition on an isolated core with \c SCHED_FIFO , writer and analysis as \c SCHED_OTHER on other cores),
+ * applied by the thread itself (i.e. \c apply from the thread to place), then checked (i.e. \c verify ).
+ * \note isolated cores (i.e. kernel \c isolcpus and \c nohz_full options) are reported by \c verify but not required.
+ * \code
+ *   RT_placement acquisition(2,SCHED_FIFO,49);
+ *   acquisition.apply();
+ *   acquisition.verify(std::cout,"acquisition");
+ * \endcode
+ **/
+class RT_placement{
+ public:
+  int cpu;     ///< core (i.e. -1: not pinned, inherited affinity)
+  int policy;  ///< scheduling policy (e.g. \c SCHED_FIFO , \c SCHED_RR or \c SCHED_OTHER ; -1: inherited)
+  int priority;///< real time priority (i.e. \c SCHED_FIFO or \c SCHED_RR only)
+
+  //! constructor
+  RT_placement(int core=-1,int sched_policy=-1,int sched_priority=0) {cpu=core;policy=sched_policy;priority=sched_priority;}
+
+  //! scheduling policy from name (i.e. "fifo", "rr", "other" or "inherit"; -2 if unknown)
+  static int policy_id(const std::string &name)
+  {
+    if(name=="fifo")    return SCHED_FIFO;
+    if(name=="rr")      return SCHED_RR;
+    if(name=="other")   return SCHED_OTHER;
+    if(name=="inherit") return -1;
+    return -2;
+  }
+  //! scheduling policy name
+  static const char* policy_name(int id)
+  {
+    switch(id)
+    {
+      case SCHED_FIFO:  return "fifo";
+      case SCHED_RR:    return "rr";
+      case SCHED_OTHER: return "other";
+      default:          return "inherit";
+    }
+  }
+
+  //! place calling thread
+  /**
+   * \return 0 on success, else the error of \c pthread_setaffinity_np or \c pthread_setschedparam (e.g. \c EPERM without real time rights)
+   **/
+  int apply() const
+  {
+    int error;
+    if(cpu>=0)
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);CPU_SET(cpu,&set);
+      if((error=pthread_setaffinity_np(pthread_self(),sizeof(set),&set))!=0) return error;
+    }
+    if(policy>=0)
+    {
+      struct sched_param param;
+      param.sched_priority=(policy==SCHED_OTHER)?0:priority;
+      if((error=pthread_setschedparam(pthread_self(),policy,&param))!=0) return error;
+    }
+    return 0;
+  }
+
+  //! check placement of calling thread
+  /**
+   * print actual core and scheduling, and warn on mismatch (e.g. placement not applied, thread migrated) or on a real time core which is not isolated
+   * \return number of mismatches (i.e. 0 if placement is effective)
+   **/
+  int verify(std::ostream &stream,const std::string &role) const
+  {
+    int mismatch=0;
+    int actual_policy;
+    struct sched_param param;
+    pthread_getschedparam(pthread_self(),&actual_policy,&param);
+    const int actual_cpu=sched_getcpu();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    pthread_getaffinity_np(pthread_self(),sizeof(set),&set);
+    stream<<role<<" thread: core "<<actual_cpu<<" ("<<CPU_COUNT(&set)<<" allowed), "<<policy_name(actual_policy)<<" priority "<<param.sched_priority<<std::endl;
+    if(cpu>=0&&(actual_cpu!=cpu||CPU_COUNT(&set)!=1||!CPU_ISSET(cpu,&set)))
+    {stream<<"Warning: "<<role<<" thread is not pinned on core "<<cpu<<"."<<std::endl;++mismatch;}
+    if(policy>=0&&(actual_policy!=policy||(policy!=SCHED_OTHER&&param.sched_priority!=priority)))
+    {stream<<"Warning: "<<role<<" thread is not "<<policy_name(policy)<<" priority "<<priority<<"."<<std::endl;++mismatch;}
+    if(cpu>=0&&policy!=SCHED_OTHER&&policy>=0)
+    {
+      if(RT_cpu_in_list("/sys/devices/system/cpu/isolated",cpu)==0) stream<<"Warning: core "<<cpu<<" of "<<role<<" thread is not isolated (i.e. isolcpus kernel option)."<<std::endl;
+      if(RT_cpu_in_list("/sys/devices/system/cpu/nohz_full",cpu)==0) stream<<"Warning: core "<<cpu<<" of "<<role<<" thread has scheduler ticks (i.e. nohz_full kernel option)."<<std::endl;
+    }
+    return mismatch;
+  }
+};//RT_placement class
+
 class RT_preempt{
  public:
   int interval;///< real time resolution
   struct timespec t; ///< real time variable
+  RT_jitter *jitter; ///< wakeup lateness and overrun statistics (i.e. not measured if NULL)
+  RT_placement placement; ///< core and priority of the real time thread (i.e. calling thread of \c initialization )
+
+  RT_preempt() : placement(-1,SCHED_FIFO,MY_PRIORITY) {jitter=NULL;}
   /*
   //! constructor
   void initialization();
@@ -23,27 +249,23 @@ void initialization(int facq)
 	
   interval= 1e9/(facq); /* 50us*/
   //int interval = 50000; /* 50us*/
+  if(jitter!=NULL) {jitter->reset();jitter->interval=interval;}
   set_RTpriority();  
   lock_memory_pagination();  
   stack_prefault();  
   gettime();  
 }
 
+//! place calling thread (i.e. not the whole process, so that threads created later do not inherit real time priority unless they ask for it)
 void set_RTpriority() 
 {
-#define MY_PRIORITY (49) /* we use 49 as the PRREMPT_RT use 50
-                            as the priority of kernel tasklets
-                            and interrupt handler by default */
-  
-  struct sched_param param;
-  /* Declare ourself as a real time task */
-  
-  param.sched_priority = MY_PRIORITY;
-  if(sched_setscheduler(0, SCHED_FIFO, &param) == -1) 
+  int error=placement.apply();
+  if(error!=0)
     {
-      perror("sched_setscheduler failed");
+      std::cerr<<"set_RTpriority failed: "<<strerror(error)<<std::endl;
       exit(-1);
     }
+  placement.verify(std::cout,"real time");
 }
   
 void lock_memory_pagination() 
@@ -87,6 +309,7 @@ void nanowait()
   
 #ifdef REAL_TIME
   clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+  if(jitter!=NULL) jitter->add(elapsed());
 #else
 struct timespec req = {0};
 req.tv_sec = 0;
@@ -102,6 +325,9 @@ nanosleep(&req, (struct timespec *)NULL);
 void next_time_interval()
 {
 #define NSEC_PER_SEC    (1000000000) /* The number of nsecs per sec. */
+#ifdef REAL_TIME
+  if(jitter!=NULL && elapsed()>interval) jitter->overrun();
+#endif
   t.tv_nsec += interval;
   
   while (t.tv_nsec >= NSEC_PER_SEC) {
@@ -110,6 +336,14 @@ void next_time_interval()
   
 }
 
+//! time since present tick (in ns)
+long elapsed()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC ,&now);
+  return (long)(now.tv_sec-t.tv_sec)*1000000000L+(now.tv_nsec-t.tv_nsec);
+}
+
 }; //CLASS RT_PREEMPT
 
 #endif// RT_PREEMPT